@@ -36,6 +36,15 @@ static const std::string ErrToString(const AddressEntryError& error)
 	case AddressEntryError::kAddressEntryNotAttempted:
 		return "Action not attempted";
 
+	case AddressEntryError::kAddressEntryReadOnly:
+		return "Address book is frozen!";
+
+	case AddressEntryError::kAddressEntryOutOfSequence:
+		return "Change is out of sequence!";
+
+	case AddressEntryError::kAddressEntryIOFailure:
+		return "File could not be read or written!";
+
 	default:
 		return std::string();
 	}
@@ -78,7 +87,7 @@ const AddressEntrySearchType GetEntrySearchType()
 {
 	while (true)
 	{
-		std::cout << "Please choose from the following search types:\n1. First Name Search\n2. Last Name Search\n3. First and Last Name Search" << std::endl;
+		std::cout << "Please choose from the following search types:\n1. First Name Search\n2. Last Name Search\n3. First and Last Name Search\n4. Substring Search" << std::endl;
 		
 		int option = 0;
 		if (std::cin >> option)
@@ -91,6 +100,8 @@ const AddressEntrySearchType GetEntrySearchType()
 				return AddressEntrySearchType::LastNameSearch;
 			case 3:
 				return AddressEntrySearchType::FirstAndLastNameSearch;
+			case 4:
+				return AddressEntrySearchType::SubstringSearch;
 			default:
 				std::cout << "Invalid search type! please try again." << std::endl;
 				break;
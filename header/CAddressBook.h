@@ -4,31 +4,58 @@
 //		Includes
 //=======================================================
 #include "CAddressBookTrie.h"
+#include "CThreadPool.h"
+#include "CAddressSearchCache.h"
+#include "CAddressBookMetrics.h"
+#include "CAddressSubstringIndex.h"
+#include "CAddressFrozenBook.h"
+#include "CAddressChangeFeed.h"
+#include "CAddressBookVersion.h"
+#include "CAddressLookupFilter.h"
 
-//====================================================================
-//		FirstNameAddressTrie : Address trie sorted in first name order
-//====================================================================
-class FirstNameAddressTrie : public CAddressTrie
-{
-public:
-	// C-tor
-	FirstNameAddressTrie();
+//=======================================================
+//		Constants
+//=======================================================
+// Tries holding fewer entries are retrieved on the calling thread
+constexpr size_t kAddressBookParallelRetrieveMin = 4096;
 
-private:
-	virtual std::string GetTrieKey(const AddressEntry& addressEntry) const;
-};
+// Off-lock rebuilds attempted by Compact and index builds before rebuilding under the lock
+constexpr uint32_t kAddressBookCompactAttempts = 3;
+
+// Adds of a bulk load published to the change feed at once
+constexpr size_t kAddressBookLoadPublishCount = 4096;
+
+// Matches counted per AND query term before the count limit is doubled
+constexpr size_t kAddressBookQueryCountMin = 64;
 
 //====================================================================
-//		AddressTrieNode : Address trie sorted in last name order
+//		Name tries : Letters only, case is ignored
 //====================================================================
-class LastNameAddressTrie : public CAddressTrie
+using CAddressNameAlphabet = CAddressLetterAlphabet;
+
+// Address trie sorted in first name order
+using FirstNameAddressTrie = CAddressTrie<CAddressNameAlphabet, CAddressFirstNameKey>;
+
+// Address trie sorted in last name order
+using LastNameAddressTrie = CAddressTrie<CAddressNameAlphabet, CAddressLastNameKey>;
+
+// Tries of a book in record slot order
+using CAddressBookTries = std::tuple<FirstNameAddressTrie, LastNameAddressTrie, LastNameAddressTrie, FirstNameAddressTrie>;
+
+//=======================================================
+//		CPreparedRecord : Record insertion prepared in every trie holding it
+//=======================================================
+struct CPreparedRecord
 {
-public:
-	// C-tor
-	LastNameAddressTrie();
+	CAddressRecordPtr mpRecord;
+	std::array<CAddressTrieInsertion<CAddressNameAlphabet>, kAddressBookTrieCount> mInsertions;
 
-private:
-	virtual std::string GetTrieKey(const AddressEntry& addressEntry) const;
+	// Record index entry is claimed while preparing, so duplicates within a batch are caught
+	bool mIndexed = false;
+
+	// Phone and substring indexes are updated while preparing too, they are only read under the lock
+	bool mPhoneIndexed = false;
+	bool mSubstringIndexed = false;
 };
 
 //=======================================================
@@ -39,13 +66,24 @@ class CAddressBook
 public:
 	// C-tor
 	CAddressBook();
+	CAddressBook(const CAddressBook&) = delete;
+	CAddressBook& operator=(const CAddressBook&) = delete;
+
+	// D-tor
+	~CAddressBook();
 
 	// Add address entry
 	AddressEntryError AddEntry(const AddressEntry& entry);
 
+	// Add address entries at once, nothing is added if any entry is rejected
+	AddressEntryError AddEntries(const AddressEntries& entries);
+
 	// Remove address entry with option to remove only matching entries
 	AddressEntryError RemoveEntry(const AddressEntry& entry, bool matching = true);
 
+	// Make the book hold exactly entries, adding and removing only the difference at once
+	AddressEntryError SyncEntries(const AddressEntries& entries, AddressEntrySyncStats& outStats);
+
 	// Retrieve address in desired order
 	AddressEntries RetrieveEntries(AddressEntryOrderType orderType) const;
 
@@ -53,19 +91,245 @@ public:
 	AddressEntries Search(const std::string& searchKey, 
 						  AddressEntrySearchType searchType = AddressEntrySearchType::FirstAndLastNameSearch) const;
 
+	// Highest scored entries in desired search type, at most *count*, ties in the order added
+	AddressEntries SearchRanked(const std::string& searchKey,
+								size_t count,
+								AddressEntrySearchType searchType = AddressEntrySearchType::FirstAndLastNameSearch) const;
+
+	// Set the score ranked searches order an entry by, entries start at zero
+	AddressEntryError SetEntryScore(const AddressEntry& entry, uint64_t score);
+
+	// Entries matching a compound query, in first name order
+	AddressEntries Query(const AddressQuery& query) const;
+
 	// Pass in a function to iterate through each entry in trie
 	void ForEach(const AddressEntryCallback& callback) const;
 
+	// Pass in a function to iterate through each entry, traversing tries on worker threads
+	void ParallelForEach(const AddressEntryCallback& callback,
+						 AddressEntryTraversalType traversalType = AddressEntryTraversalType::Unordered) const;
+
+	// Read-only copy of the book at its current version, records are gathered under the lock
+	// and packed outside it, pins of an unchanged book share the same copy
+	std::shared_ptr<const CAddressBookVersion> PinVersion() const;
+
 	// Clear address book
 	void Reset();
 
+	// Set search cache memory budget, zero disables the cache
+	void SetSearchCacheBudget(size_t budgetBytes);
+
+	// Get search cache counters
+	AddressSearchCacheStats GetSearchCacheStats() const;
+
+	// Snapshot of instrumentation counters and trie sizes
+	AddressBookMetrics GetMetrics() const;
+
+	// Count live and dead trie nodes
+	AddressBookMemoryUsage GetMemoryUsage() const;
+
+	// Rebuild tries without dead nodes and with nodes allocated in alphabetical order,
+	// rebuilding happens outside the lock and the new tries are swapped in
+	AddressBookMemoryUsage Compact();
+
+	// Build or drop the substring index, building happens outside the lock
+	// substring searches scan every entry while the index is disabled
+	void SetSubstringIndexEnabled(bool enabled);
+
+	// Convert the book into packed read-only tries served without the lock,
+	// writes fail with kAddressEntryReadOnly until thawed
+	AddressBookMemoryUsage Freeze();
+
+	// Convert a frozen book back into mutable tries
+	AddressBookMemoryUsage Thaw();
+
+	// Replace every entry with those pulled from source, packed straight into a frozen book
+	AddressEntryError LoadFrozen(const AddressEntrySource& source);
+
+	// Spill entries of books frozen from now on to a payload file in directory, read back through a page cache
+	// of *cacheBytes*, an empty directory keeps them in memory (default)
+	AddressEntryError SetTieredStorage(const std::string& directory, size_t cacheBytes);
+
+	// Page cache counters of the frozen book
+	AddressBookTierStats GetTierStats() const;
+
+	// Answer lookups of absent entries and names from a counting Bloom filter sized for *expectedEntries*
+	// at *falsePositiveRate*, without the lock, zero entries drops the filter (default)
+	AddressEntryError SetLookupFilter(size_t expectedEntries, double falsePositiveRate);
+
+	// Lookup filter counters
+	AddressLookupFilterStats GetLookupFilterStats() const;
+
+	// Keep up to *capacity* latest changes for followers, zero disables the ring (default)
+	void SetChangeFeedCapacity(size_t capacity);
+
+	// Append changes to a log file, an empty path closes it
+	AddressEntryError SetChangeLog(const std::string& path);
+
+	// kAddressEntryIOFailure once a write to the change log failed and closed it
+	AddressEntryError GetChangeLogStatus() const;
+
+	// Changes published after sequence, waiting up to timeout for the first one
+	AddressEntryError ReadChanges(uint64_t afterSequence,
+								  size_t maxCount,
+								  std::chrono::milliseconds timeout,
+								  AddressChanges& outChanges) const;
+
+	// Every entry in the order added, and the sequence of the last change they include
+	AddressEntries RetrieveChangeSnapshot(uint64_t& outSequence) const;
+
+	// Apply a leader's changes in sequence order, changes already applied are skipped
+	AddressEntryError ApplyChanges(const AddressChanges& changes);
+
+	// Replace every entry with a leader's snapshot, for followers that fell behind its feed
+	AddressEntryError ApplyChangeSnapshot(const AddressEntries& entries, uint64_t sequence);
+
+	// Sequence of the last leader change applied
+	uint64_t GetAppliedSequence() const;
+
+private:
+	// Pin the frozen book, or lock the mutable book if it is not frozen
+	// returns the pinned frozen book, null if the lock was taken
+	const CAddressFrozenBook* BeginRead(CAddressFrozenReader& frozenReader,
+										std::optional<CMetricsLockGuard>& lock) const;
+
+	// Check if the book is frozen, lock must be held
+	bool IsFrozen() const;
+
+	// Publish the frozen book for reads and pinned versions, lock must be held
+	void PublishFrozenBook(std::shared_ptr<const CAddressFrozenBook> pFrozenBook);
+
+	// Unpublish the frozen book, lock must be held, the caller drops it once Synchronise of the readers,
+	// called without the lock, returns
+	std::shared_ptr<const CAddressFrozenBook> DetachFrozenBook();
+
+	// Call function with the slot, as an integral constant, and the trie of every trie in record slot order
+	template <typename Function>
+	void ForEachTrie(Function&& function);
+
+	// Remove record from every trie holding it and from the record index, lock must be held
+	void RemoveRecord(const CAddressRecordPtr& pRecord);
+
+	// Add entries by preparing every record first and then committing them together, lock must be held
+	template <typename Iterator>
+	AddressEntryError InsertEntries(Iterator begin, Iterator end);
+
+	// Add entries and publish them to the change feed, lock must be held
+	template <typename Iterator>
+	AddressEntryError InsertAndPublish(Iterator begin, Iterator end);
+
+	// Remove entry, or every entry of the same name, and publish the removals, lock must be held
+	AddressEntryError RemoveAndPublish(const AddressEntry& entry, bool removeMatchingOnly);
+
+	// Drop every entry and publish the clear, lock must be held
+	void ClearAndPublish();
+
+	// Claim record index entry and allocate trie positions for entry, lock must be held
+	AddressEntryError PrepareRecord(const AddressEntry& entry, CPreparedRecord& outPrepared);
+
+	// Publish prepared record in every trie, cannot fail, lock must be held
+	void CommitRecord(CPreparedRecord& prepared) noexcept;
+
+	// Release everything held by prepared records, lock must be held
+	void AbortRecords(std::vector<CPreparedRecord>& prepared) noexcept;
+
+	// Worker threads are only started on first use
+	CThreadPool& GetThreadPool() const;
+
+	// Retrieve trie entries in alphabetical order, traversing partitions on worker threads
+	template <typename Trie>
+	AddressEntries ParallelAlphabeticOrder(const Trie& trie) const;
+
+	// Search tries in desired search type, lock must be held
+	AddressEntries SearchTries(const std::string& searchKey,
+							   AddressEntrySearchType searchType) const;
+
+	// Entries whose first or last name contains key in first name order, lock must be held
+	AddressEntries SearchSubstring(const std::string& searchKey) const;
+
+	// Records whose first or last name contains key, lock must be held
+	void CollectSubstringRecords(const std::string& searchKey, std::vector<const CAddressRecord*>& outRecords) const;
+
+	// Highest ranked records in desired search type, lock must be held
+	AddressEntries SearchRankedTries(const std::string& searchKey,
+									 size_t count,
+									 AddressEntrySearchType searchType) const;
+
+	// Records matching a query term as a stream, lock must be held
+	void QueryTerm(const AddressQueryTerm& term, CAddressRecordStream& outStream) const;
+
+	// Records a query term may match, counted up to limit, lock must be held
+	size_t CountQueryTerm(const AddressQueryTerm& term, size_t limit) const;
+
 private:
 	mutable std::mutex mMutex;
 
+	// Bumped by every write, guarded by mMutex
+	uint64_t mGeneration;
+
+	// Operation, lock and callback instrumentation
+	mutable CAddressBookMetrics mMetrics;
+
+	mutable std::once_flag mThreadPoolFlag;
+	mutable std::unique_ptr<CThreadPool> mpThreadPool;
+
 	// Trie sorted in first name order
 	FirstNameAddressTrie mFirstNameTrie;
 
 	// Trie sorted in last name order
 	LastNameAddressTrie mLastNameTrie;
+
+	// Side index of entries without a first name, sorted in last name order
+	LastNameAddressTrie mNoFirstNameTrie;
+
+	// Side index of entries without a last name, sorted in first name order
+	FirstNameAddressTrie mNoLastNameTrie;
+
+	// Every record by its full entry, for duplicate checks and exact removes
+	CAddressRecordIndex mRecordIndex;
+
+	// Id given to the next record
+	uint64_t mNextRecordId;
+
+	// Bumped by every SyncEntries, records found in its entry set are marked with it
+	uint64_t mSyncPass;
+
+	// Records by phone number, for phone terms of compound queries
+	CAddressPhoneIndex mPhoneIndex;
+
+	// Trigram index of names for substring searches, disabled by default
+	CAddressSubstringIndex mSubstringIndex;
+	bool mSubstringIndexEnabled;
+
+	// Read-only copy serving every read while frozen, null while mutable
+	std::atomic<const CAddressFrozenBook*> mpFrozenBook;
+
+	// Owns the frozen book, versions pinned while frozen share it so it outlives a thaw until they are gone
+	std::shared_ptr<const CAddressFrozenBook> mpFrozenBookOwner;
+
+	// Reads currently served by the frozen book, a detached book is freed once those that pinned it are done
+	mutable CAddressReaderEpoch mFrozenReaders;
+
+	// Committed mutations for followers
+	CAddressChangeFeed mChangeFeed;
+
+	// Sequence of the last change applied from a leader
+	uint64_t mAppliedSequence;
+
+	// Results of recent searches, disabled by default
+	mutable CAddressSearchCache mSearchCache;
+
+	// Approximate membership of entries and name prefixes, null while disabled,
+	// updated under the lock and read without it
+	std::atomic<CAddressLookupFilter*> mpLookupFilter;
+
+	// Lookups currently reading the filter, one swapped out is freed once those that pinned it are done
+	mutable CAddressReaderEpoch mLookupFilterReaders;
+
+	// Where books frozen from now on keep their entries
+	CAddressTierOptions mTierOptions;
+
+	// Latest version pinned, reused until the next write, not kept alive once every snapshot is released
+	mutable std::weak_ptr<const CAddressBookVersion> mpLatestVersion;
 };
 #endif // C_ADDRESS_BOOK_H
\ No newline at end of file
@@ -9,6 +9,7 @@
 //		Forward declaration
 //=======================================================
 class CAddressBook;
+class CThreadPool;
 
 //=======================================================
 //		CAddressBookManager : Manager class for address book(s)
@@ -27,7 +28,20 @@ public:
 	// Get address book
 	CAddressBook* GetAddressBook();
 
+	// Get executor for asynchronous requests, started on first use
+	CThreadPool* GetExecutor();
+
+	// Get executor for result streams and asynchronous iterations, started on first use
+	// kept apart from the executor, so producers blocked on slow consumers never hold up Compact, Freeze or Thaw
+	CThreadPool* GetStreamExecutor();
+
 private:
 	std::unique_ptr<CAddressBook> mpAddressBook;
+
+	std::once_flag mExecutorFlag;
+	std::unique_ptr<CThreadPool> mpExecutor;
+
+	std::once_flag mStreamExecutorFlag;
+	std::unique_ptr<CThreadPool> mpStreamExecutor;
 };
 #endif // C_ADDRESS_BOOK_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,221 @@
+#ifndef C_ADDRESS_BOOK_METRICS_H
+#define C_ADDRESS_BOOK_METRICS_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookTypes.h"
+#include "AddressBookCommon.h"
+
+// System
+#include <chrono>
+
+//=======================================================
+//		Macros
+//=======================================================
+// Instrumentation is compiled out unless enabled by the build
+#ifndef ADDRESS_BOOK_METRICS
+#define ADDRESS_BOOK_METRICS 0
+#endif
+
+#if ADDRESS_BOOK_METRICS
+#define ADDRESS_BOOK_METRICS_SCOPE(metrics, operation) CScopedOperation scopedOperation(metrics, operation)
+#define ADDRESS_BOOK_METRICS_ENTRIES(count) scopedOperation.AddEntries(count)
+#else
+#define ADDRESS_BOOK_METRICS_SCOPE(metrics, operation)
+#define ADDRESS_BOOK_METRICS_ENTRIES(count)
+#endif
+
+//=======================================================
+//		Aliases
+//=======================================================
+using MetricsClock = std::chrono::steady_clock;
+
+//=======================================================
+//		CLatencyHistogram : Lock-free power of two latency histogram
+//=======================================================
+class CLatencyHistogram
+{
+public:
+	// C-tor
+	CLatencyHistogram();
+
+	// Record a latency sample
+	void Record(uint64_t nanoseconds);
+
+	// Record time elapsed since *start*
+	void RecordSince(const MetricsClock::time_point& start);
+
+	// Copy current counts
+	AddressBookLatencyHistogram Snapshot() const;
+
+private:
+	std::array<std::atomic<uint64_t>, kAddressBookLatencyBuckets> mBuckets;
+	std::atomic<uint64_t> mCount;
+	std::atomic<uint64_t> mTotalNanoseconds;
+	std::atomic<uint64_t> mMaxNanoseconds;
+};
+
+//=======================================================
+//		CAddressBookMetrics : Counters and histograms of an address book
+//=======================================================
+class CAddressBookMetrics
+{
+public:
+	// Operation latency
+	CLatencyHistogram& GetOperation(AddressBookOperation operation);
+
+	// Count entries returned or visited by an operation
+	void AddEntries(AddressBookOperation operation, uint64_t count);
+
+	// Time spent waiting for and holding the book's mutex
+	CLatencyHistogram& GetLockWait() { return mLockWait; }
+	CLatencyHistogram& GetLockHold() { return mLockHold; }
+
+	// Time spent in user ForEach callbacks, one sample per ForEach
+	CLatencyHistogram& GetForEachCallback() { return mForEachCallback; }
+
+	// Copy operation and lock counters, trie counters are filled in by the book
+	void Snapshot(AddressBookMetrics& outMetrics) const;
+
+private:
+	std::array<CLatencyHistogram, kAddressBookOperationCount> mOperations;
+	std::array<std::atomic<uint64_t>, kAddressBookOperationCount> mOperationEntries{};
+
+	CLatencyHistogram mLockWait;
+	CLatencyHistogram mLockHold;
+	CLatencyHistogram mForEachCallback;
+};
+
+//=======================================================
+//		CScopedOperation : Records latency of an operation on scope exit
+//=======================================================
+class CScopedOperation
+{
+public:
+	CScopedOperation(CAddressBookMetrics& metrics, AddressBookOperation operation) :
+		mMetrics(metrics),
+		mOperation(operation),
+		mStart(MetricsClock::now())
+	{
+
+	}
+
+	~CScopedOperation()
+	{
+		mMetrics.GetOperation(mOperation).RecordSince(mStart);
+	}
+
+	void AddEntries(uint64_t count)
+	{
+		mMetrics.AddEntries(mOperation, count);
+	}
+
+private:
+	CAddressBookMetrics& mMetrics;
+	AddressBookOperation mOperation;
+	MetricsClock::time_point mStart;
+};
+
+//=======================================================
+//		CCallbackTimer : Accumulates time spent in a ForEach callback
+//=======================================================
+class CCallbackTimer
+{
+public:
+	CCallbackTimer(CAddressBookMetrics& metrics, const AddressEntryCallback& callback) :
+		mCallback(callback)
+#if ADDRESS_BOOK_METRICS
+		, mMetrics(metrics),
+		mNanoseconds(0),
+		mEntries(0)
+#endif
+	{
+#if ADDRESS_BOOK_METRICS
+		mTimedCallback = [this](const AddressEntry& entry)
+			{
+				MetricsClock::time_point start = MetricsClock::now();
+				mCallback(entry);
+
+				mNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(MetricsClock::now() - start).count(),
+									   std::memory_order_relaxed);
+				mEntries.fetch_add(1, std::memory_order_relaxed);
+			};
+#else
+		(void)metrics;
+#endif
+	}
+
+	~CCallbackTimer()
+	{
+#if ADDRESS_BOOK_METRICS
+		mMetrics.GetForEachCallback().Record(mNanoseconds.load());
+		mMetrics.AddEntries(AddressBookOperation::ForEach, mEntries.load());
+#endif
+	}
+
+	// Callback to pass on to the traversal, may be invoked concurrently
+	const AddressEntryCallback& Get() const
+	{
+#if ADDRESS_BOOK_METRICS
+		return mTimedCallback;
+#else
+		return mCallback;
+#endif
+	}
+
+	CCallbackTimer(const CCallbackTimer&) = delete;
+	CCallbackTimer& operator=(const CCallbackTimer&) = delete;
+
+private:
+	const AddressEntryCallback& mCallback;
+#if ADDRESS_BOOK_METRICS
+	CAddressBookMetrics& mMetrics;
+	AddressEntryCallback mTimedCallback;
+	std::atomic<uint64_t> mNanoseconds;
+	std::atomic<uint64_t> mEntries;
+#endif
+};
+
+//=======================================================
+//		CMetricsLockGuard : Lock guard recording wait and hold times
+//=======================================================
+class CMetricsLockGuard
+{
+public:
+	CMetricsLockGuard(std::mutex& mutex, CAddressBookMetrics& metrics) :
+		mMutex(mutex)
+#if ADDRESS_BOOK_METRICS
+		, mMetrics(metrics)
+#endif
+	{
+#if ADDRESS_BOOK_METRICS
+		MetricsClock::time_point waitStart = MetricsClock::now();
+		mMutex.lock();
+		mAcquired = MetricsClock::now();
+
+		mMetrics.GetLockWait().Record(std::chrono::duration_cast<std::chrono::nanoseconds>(mAcquired - waitStart).count());
+#else
+		(void)metrics;
+		mMutex.lock();
+#endif
+	}
+
+	~CMetricsLockGuard()
+	{
+#if ADDRESS_BOOK_METRICS
+		mMetrics.GetLockHold().RecordSince(mAcquired);
+#endif
+		mMutex.unlock();
+	}
+
+	CMetricsLockGuard(const CMetricsLockGuard&) = delete;
+	CMetricsLockGuard& operator=(const CMetricsLockGuard&) = delete;
+
+private:
+	std::mutex& mMutex;
+#if ADDRESS_BOOK_METRICS
+	CAddressBookMetrics& mMetrics;
+	MetricsClock::time_point mAcquired;
+#endif
+};
+#endif // C_ADDRESS_BOOK_METRICS_H
\ No newline at end of file
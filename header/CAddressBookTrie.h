@@ -5,35 +5,173 @@
 //=======================================================
 #include "AddressBookTypes.h"
 #include "AddressBookCommon.h"
+#include "CAddressRecordStream.h"
 
 //=======================================================
 //		Constants
 //=======================================================
-constexpr uint32_t kAddressTrieCharactersMax = 26;
+// Depth at which tries are split for parallel traversals
+constexpr uint32_t kAddressTriePartitionDepth = 2;
+
+// Returned by alphabets for characters without a child slot
+constexpr uint32_t kAddressTrieInvalidIndex = UINT32_MAX;
 
 //=======================================================
 //		LowerCaseString : Lowercase a string
 //=======================================================
 void LowerCaseString(std::string& str);
 
+//=======================================================
+//		Alphabets : Map key characters to child slots
+//		kSize is the number of slots per node, Index returns kAddressTrieInvalidIndex
+//		for characters the alphabet can't hold, slot order is the traversal order
+//=======================================================
+// Letters a-z, upper case letters share the slot of their lower case letter
+struct CAddressLetterAlphabet
+{
+	static constexpr uint32_t kSize = 26;
+
+	static uint32_t Index(char c)
+	{
+		if (c >= 'a' && c <= 'z')
+		{
+			return c - 'a';
+		}
+
+		return (c >= 'A' && c <= 'Z') ? c - 'A' : kAddressTrieInvalidIndex;
+	}
+};
+
+// Digits 0-9
+struct CAddressDigitAlphabet
+{
+	static constexpr uint32_t kSize = 10;
+
+	static uint32_t Index(char c)
+	{
+		return (c >= '0' && c <= '9') ? c - '0' : kAddressTrieInvalidIndex;
+	}
+};
+
+// Every byte, case sensitive
+struct CAddressByteAlphabet
+{
+	static constexpr uint32_t kSize = 256;
+
+	static uint32_t Index(char c)
+	{
+		return static_cast<uint8_t>(c);
+	}
+};
+
+// Every byte with ASCII letters folded to lower case, UTF-8 sequences are kept
+// byte by byte so they still sort by code point
+struct CAddressFoldedAlphabet
+{
+	static constexpr uint32_t kSize = 256 - 26;
+
+	static uint32_t Index(char c)
+	{
+		uint32_t byte = static_cast<uint8_t>(c);
+		if (byte < 'A')
+		{
+			return byte;
+		}
+
+		// Upper case letters take the slot of their lower case letter, later bytes close the gap
+		return (byte <= 'Z') ? byte + ('a' - 'A') - 26 : byte - 26;
+	}
+};
+
+//=======================================================
+//		Key policies : Key an entry is filed under
+//=======================================================
+// First name, then last name
+struct CAddressFirstNameKey
+{
+	static std::string Get(const AddressEntry& addressEntry)
+	{
+		return addressEntry.mFirstName + addressEntry.mLastName;
+	}
+};
+
+// Last name, then first name
+struct CAddressLastNameKey
+{
+	static std::string Get(const AddressEntry& addressEntry)
+	{
+		return addressEntry.mLastName + addressEntry.mFirstName;
+	}
+};
+
+// Phone number
+struct CAddressPhoneNumberKey
+{
+	static std::string Get(const AddressEntry& addressEntry)
+	{
+		return addressEntry.mPhoneNumber;
+	}
+};
+
 //====================================================================
-//		CAddressTrieNode : Address trie node
+//		CAddressTrieNode : Address trie node with a child slot per character of the alphabet
 //====================================================================
+template <typename Alphabet>
 struct CAddressTrieNode
 {
-	std::list<std::shared_ptr<AddressEntry>> mEntries;
-	std::array<std::unique_ptr<CAddressTrieNode>, kAddressTrieCharactersMax> mCharacters;
+	CAddressRecordList mEntries;
+	std::array<std::unique_ptr<CAddressTrieNode>, Alphabet::kSize> mCharacters;
+	uint32_t mChildCount;
+
+	// Highest ranked records of the subtree, rebuilt by the next ranked search once a change below clears mTopValid
+	mutable std::vector<const CAddressRecord*> mTopRecords;
+	mutable bool mTopValid;
 
-	CAddressTrieNode() {}
+	CAddressTrieNode() : mChildCount(0), mTopValid(false) {}
 	CAddressTrieNode(const CAddressTrieNode&) = delete;
 	CAddressTrieNode& operator=(const CAddressTrieNode&) = delete;
 };
 
+//====================================================================
+//		CAddressTriePartition : Disjoint part of a trie
+//====================================================================
+template <typename Alphabet>
+struct CAddressTriePartition
+{
+	const CAddressTrieNode<Alphabet>* mpNode;
+
+	// If false, only the entries held by the node itself are included
+	bool mSubtree;
+};
+
+//=======================================================
+//		CAddressTrieInsertion : Record insertion prepared but not yet visible in the trie
+//=======================================================
+template <typename Alphabet>
+struct CAddressTrieInsertion
+{
+	std::string mKey;
+
+	// Node at the end of key, null until prepared
+	CAddressTrieNode<Alphabet>* mpNode = nullptr;
+
+	// Preallocated list node holding the record, spliced into mpNode on commit
+	CAddressRecordList mPending;
+};
+
 //=======================================================
 //		CAddressTrie : Trie holding address entries
+//		Alphabet sizes the nodes and maps characters to slots, KeyPolicy picks the key of an entry
+//		both are resolved at compile time, instantiations live in CAddressBookTrie.cpp
 //=======================================================
+template <typename Alphabet, typename KeyPolicy>
 class CAddressTrie
 {
+public:
+	using TrieNode = CAddressTrieNode<Alphabet>;
+	using TriePartition = CAddressTriePartition<Alphabet>;
+	using TrieInsertion = CAddressTrieInsertion<Alphabet>;
+
 private:
 	// To identify duplicates in entry
 	using AddressDuplicateLookup = std::unordered_set<const AddressEntry*>;
@@ -49,12 +187,24 @@ public:
 	// C-tor
 	CAddressTrie();
 
-	// Insert entry to trie
-	AddressEntryError Insert(const AddressEntry& addressEntry);
+	// Insert record to trie, duplicates are rejected by the book's record index beforehand
+	AddressEntryError Insert(const CAddressRecordPtr& pRecord, CAddressRecordHandle& outHandle);
+
+	// Allocate everything the insertion needs, the record stays invisible until committed
+	AddressEntryError PrepareInsert(const CAddressRecordPtr& pRecord, TrieInsertion& outInsertion);
+
+	// Publish a prepared insertion, cannot fail
+	CAddressRecordHandle CommitInsert(TrieInsertion& insertion) noexcept;
+
+	// Drop a prepared insertion, freeing nodes it allocated
+	// insertions sharing nodes must be aborted in reverse order of preparation
+	void AbortInsert(TrieInsertion& insertion) noexcept;
+
+	// Remove record from trie, freeing nodes no longer leading to any entry
+	void Remove(CAddressRecordHandle handle);
 
-	// Remove entry from trie
-	AddressEntryError Remove(const AddressEntry& addressEntry,
-							 bool matching = true);
+	// Records stored under the same key as the entry
+	void Find(const AddressEntry& addressEntry, std::vector<CAddressRecordPtr>& outRecords) const;
 
 	// Search for entry in trie
 	AddressSearchResult Search(const std::string& searchKey,
@@ -66,23 +216,97 @@ public:
 	// Pass in a function to iterate through each entry in trie
 	void ForEach(const AddressEntryCallback& callback) const;
 
+	// Split trie into disjoint partitions, listed in alphabetical order
+	std::vector<TriePartition> Partition(uint32_t depth = kAddressTriePartitionDepth) const;
+
+	// Pass in a function to iterate through each entry in a partition of the trie
+	void ForEach(const TriePartition& partition, 
+				 const AddressEntryCallback& callback) const;
+
 	// Clear address trie
 	void Clear();
 
-protected:
-	// Determines how trie is sorted
-	virtual std::string GetTrieKey(const AddressEntry& addressEntry) const = 0;
+	// Number of entries held by trie
+	size_t GetEntryCount() const;
+
+	// Node, entry and approximate memory counts
+	AddressTrieMetrics GetMetrics() const;
+
+	// Add live and dead node counts by walking the trie
+	void GetMemoryUsage(AddressBookMemoryUsage& outUsage) const;
+
+	// Exchange contents with another trie of the same key order
+	void Swap(CAddressTrie& other);
+
+	// Records in alphabetical order, inserting them into an empty trie rebuilds it
+	void CollectRecords(std::vector<CAddressRecordPtr>& outRecords) const;
+
+	// Records whose key starts with the lower case key, in alphabetical order
+	void CollectRecords(const std::string& key, CAddressRecordStream& outRecords) const;
+
+	// Number of records whose key starts with the lower case key, counting stops at limit
+	size_t CountRecords(const std::string& key, size_t limit) const;
+
+	// Highest ranked records whose key starts with key, at most *count*, in rank order
+	// stale node rankings are rebuilt on the way, so calls must not overlap writes
+	void CollectTopRecords(const std::string& key, size_t count, std::vector<const CAddressRecord*>& outRecords) const;
+
+	// Mark rankings along the entry's key stale after its score changed
+	void InvalidateRanking(const AddressEntry& addressEntry) noexcept;
 
 private:
-	void PreOrderTraverse(CAddressTrieNode* currentNode,
+	void PreOrderTraverse(const TrieNode* currentNode,
 						  AddressEntries& outAddresses,
 						  AddressDuplicateLookup& duplicatesHash,
 						  const EntryPredicate& predicate) const;
 	
-	void PreOrderTraverseForEach(CAddressTrieNode* currentNode,
+	void PreOrderTraverseForEach(const TrieNode* currentNode,
 								 const AddressEntryCallback& callback) const;
 
+	void PreOrderPartition(const TrieNode* currentNode,
+						   uint32_t depth,
+						   std::vector<TriePartition>& outPartitions) const;
+
+	void PreOrderCollect(const TrieNode* currentNode,
+						 std::vector<CAddressRecordPtr>& outRecords) const;
+
+	void PreOrderCollect(const TrieNode* currentNode,
+						 CAddressRecordStream& outRecords) const;
+
+	void PreOrderCount(const TrieNode* currentNode,
+					   size_t limit,
+					   size_t& outCount) const;
+
+	// Rebuild stale rankings of node and below
+	void RankSubtree(const TrieNode* currentNode) const;
+
+	// Slot of each key character, false if the alphabet can't hold one of them
+	static bool IsValidKey(const std::string& key);
+
+	// Node at the end of key, or null
+	const TrieNode* FindNode(const std::string& key) const;
+
+	// Free the branch at the end of key if nothing is left below it
+	void PruneBranch(const std::string& key) noexcept;
+
+	bool CountNodes(const TrieNode* currentNode,
+					AddressBookMemoryUsage& outUsage) const;
+
 private:
-	std::unique_ptr<CAddressTrieNode> mRootNode;
+	std::unique_ptr<TrieNode> mRootNode;
+	size_t mEntryCount;
+	size_t mNodeCount;
+	size_t mEntryBytes;
 };
+
+//=======================================================
+//		Instantiations
+//=======================================================
+extern template class CAddressTrie<CAddressLetterAlphabet, CAddressFirstNameKey>;
+extern template class CAddressTrie<CAddressLetterAlphabet, CAddressLastNameKey>;
+extern template class CAddressTrie<CAddressFoldedAlphabet, CAddressFirstNameKey>;
+extern template class CAddressTrie<CAddressFoldedAlphabet, CAddressLastNameKey>;
+extern template class CAddressTrie<CAddressByteAlphabet, CAddressFirstNameKey>;
+extern template class CAddressTrie<CAddressByteAlphabet, CAddressLastNameKey>;
+extern template class CAddressTrie<CAddressDigitAlphabet, CAddressPhoneNumberKey>;
 #endif // C_ADDRESS_BOOK_TRIE_H
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef C_ADDRESS_BOOK_VERSION_H
+#define C_ADDRESS_BOOK_VERSION_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressFrozenBook.h"
+
+//=======================================================
+//		CAddressBookVersion : Packed read-only copy of the book as of one version
+//		built from the records live at that version, so it stays consistent while writers move on,
+//		or the frozen book itself while the book is frozen, as that never changes,
+//		shared by every snapshot pinning the version and freed with the last of them
+//=======================================================
+class CAddressBookVersion
+{
+public:
+	// C-tor, records may be in any order
+	CAddressBookVersion(uint64_t version, const std::vector<CAddressRecordPtr>& records);
+	// C-tor, shares a frozen book
+	CAddressBookVersion(uint64_t version, std::shared_ptr<const CAddressFrozenBook> pBook);
+	CAddressBookVersion(const CAddressBookVersion&) = delete;
+	CAddressBookVersion& operator=(const CAddressBookVersion&) = delete;
+
+	// Book generation the copy was taken at
+	uint64_t GetVersion() const;
+
+	const CAddressFrozenBook& GetBook() const;
+
+private:
+	const uint64_t mVersion;
+	const std::shared_ptr<const CAddressFrozenBook> mpBook;
+};
+#endif // C_ADDRESS_BOOK_VERSION_H
@@ -0,0 +1,78 @@
+#ifndef C_ADDRESS_CHANGE_FEED_H
+#define C_ADDRESS_CHANGE_FEED_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookTypes.h"
+#include "AddressBookCommon.h"
+
+// System
+#include <fstream>
+
+//=======================================================
+//		Constants
+//=======================================================
+// Sequence, type and the three field lengths ahead of the field bytes
+constexpr size_t kAddressChangeHeaderBytes = sizeof(uint64_t) + sizeof(uint8_t) + 3 * sizeof(uint32_t);
+
+//=======================================================
+//		CAddressChangeFeed : Sequence-numbered stream of committed book mutations
+//		kept in a bounded ring for in-process readers and optionally appended to a log file
+//=======================================================
+class CAddressChangeFeed
+{
+public:
+	// C-tor, feed is disabled until given a capacity or a log
+	CAddressChangeFeed();
+	CAddressChangeFeed(const CAddressChangeFeed&) = delete;
+	CAddressChangeFeed& operator=(const CAddressChangeFeed&) = delete;
+
+	// Keep up to *capacity* latest changes for readers, zero disables the ring
+	void SetCapacity(size_t capacity);
+
+	// Append changes to the file at path, an empty path closes the log, either clears a failure of the last log
+	AddressEntryError SetLog(const std::string& path);
+
+	// kAddressEntryIOFailure once a write to the log failed and closed it, success otherwise
+	AddressEntryError GetLogStatus() const;
+
+	// Check if changes are kept anywhere, writers skip building them otherwise
+	bool IsEnabled() const;
+
+	// Number changes and publish them in order, cannot fail
+	// a failed log write closes the log and is kept for GetLogStatus, the ring is unaffected
+	// the log is written and flushed holding mMutex, so under the book's lock too, and every write waits on the disk
+	void Publish(AddressChanges& changes) noexcept;
+
+	// Changes after sequence, at most maxCount, waiting up to timeout for the first one
+	// returns kAddressEntryOutOfSequence if the ring no longer holds the change after sequence
+	AddressEntryError Read(uint64_t afterSequence,
+						   size_t maxCount,
+						   std::chrono::milliseconds timeout,
+						   AddressChanges& outChanges) const;
+
+	// Sequence of the latest published change, zero if none
+	uint64_t GetLastSequence() const;
+
+	// Append the log record of change to buffer
+	static void Encode(const AddressChange& change, std::string& outBuffer);
+
+	// Decode the log record at the start of data, returns bytes consumed or zero if the record is incomplete
+	static size_t Decode(const char* data, size_t size, AddressChange& outChange);
+
+private:
+	mutable std::mutex mMutex;
+	mutable std::condition_variable mPublished;
+
+	// Slot of a change is its sequence modulo the capacity, preallocated so publishing only moves
+	std::vector<AddressChange> mRing;
+
+	// Oldest sequence still held by the ring
+	uint64_t mFirstSequence;
+	uint64_t mLastSequence;
+
+	std::ofstream mLog;
+	std::string mLogBuffer;
+	AddressEntryError mLogStatus;
+};
+#endif // C_ADDRESS_CHANGE_FEED_H
@@ -0,0 +1,128 @@
+#ifndef C_ADDRESS_ENTRY_STORE_H
+#define C_ADDRESS_ENTRY_STORE_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookTypes.h"
+#include "AddressBookCommon.h"
+
+// System
+#include <fstream>
+
+//=======================================================
+//		Constants
+//=======================================================
+// Bytes of the payload file read and cached together
+constexpr size_t kAddressEntryPageBytes = 4096;
+
+// Page cache shards, each with its own lock and file handle so misses on different shards read in parallel
+constexpr size_t kAddressEntryCacheShards = 16;
+
+// The three field lengths ahead of the field bytes of a payload record
+constexpr size_t kAddressEntryRecordHeaderBytes = 3 * sizeof(uint32_t);
+
+//=======================================================
+//		CAddressTierOptions : Where a frozen book keeps its entries
+//=======================================================
+struct CAddressTierOptions
+{
+	// Directory of the payload file, empty keeps entries in memory
+	std::string mDirectory;
+
+	// Page cache budget of a tiered store
+	size_t mCacheBytes = 0;
+};
+
+//=======================================================
+//		CAddressEntryStore : Entries of a frozen book by index
+//		either held in memory, or appended to a payload file and read back through a sharded LRU page cache
+//		keeping only a file offset per entry in memory
+//=======================================================
+class CAddressEntryStore
+{
+public:
+	// C-tor, tiered stores create their payload file in the options' directory
+	// throws std::ios_base::failure if it cannot be created
+	explicit CAddressEntryStore(const CAddressTierOptions& options);
+	CAddressEntryStore(const CAddressEntryStore&) = delete;
+	CAddressEntryStore& operator=(const CAddressEntryStore&) = delete;
+
+	// D-tor, removes the payload file
+	~CAddressEntryStore();
+
+	void Reserve(size_t count);
+
+	// Append entry at the next index, tiered stores only write it out on Seal
+	void Append(const AddressEntry& entry);
+
+	// Finish appending, throws std::ios_base::failure if the payload file could not be written
+	void Seal();
+
+	size_t GetCount() const;
+
+	bool IsTiered() const;
+
+	// Copy of the entry at index, tiered stores read it through the page cache
+	// throws std::ios_base::failure if the payload file cannot be read
+	void Read(uint32_t index, AddressEntry& outEntry) const;
+	AddressEntry Read(uint32_t index) const;
+
+	// Pass entries [begin, end) in index order to callback, tiered stores read the file sequentially
+	// and bypass the page cache, so sweeps do not evict the pages searches keep hitting
+	void Scan(uint32_t begin, uint32_t end, const std::function<void(uint32_t, const AddressEntry&)>& callback) const;
+
+	// Page cache counters, zero for in-memory stores
+	AddressBookTierStats GetStats() const;
+
+	// Approximate heap bytes held in memory, entries or file offsets and cached pages
+	size_t GetMemoryBytes() const;
+
+private:
+	struct CPage
+	{
+		uint64_t mNumber;
+		std::string mData;
+	};
+
+	struct CCacheShard
+	{
+		std::mutex mMutex;
+		std::ifstream mFile;
+
+		// Most recently used first
+		std::list<CPage> mPages;
+		std::unordered_map<uint64_t, std::list<CPage>::iterator> mPageIndex;
+	};
+
+	// Copy *size* bytes at *offset* of the payload file through the page cache
+	void ReadBytes(uint64_t offset, size_t size, char* outBytes) const;
+
+	// Page of the payload file, cached or read in, shard lock must be held
+	// throws std::ios_base::failure if the payload file cannot be read
+	const std::string& FetchPage(CCacheShard& shard, uint64_t pageNumber) const;
+
+	// Decode the payload record of entry
+	static void DecodeEntry(const char* header, const char* fields, AddressEntry& outEntry);
+
+private:
+	// In-memory entries
+	std::vector<AddressEntry> mEntries;
+
+	// Tiered entries, the payload file is append-only and owned by the store
+	std::string mPath;
+	std::ofstream mWriter;
+	std::string mWriteBuffer;
+	std::vector<uint64_t> mOffsets;
+	uint64_t mPayloadBytes;
+
+	size_t mCacheBudgetBytes;
+	size_t mShardPageCapacity;
+	mutable std::array<CCacheShard, kAddressEntryCacheShards> mShards;
+
+	mutable std::atomic<uint64_t> mHits;
+	mutable std::atomic<uint64_t> mMisses;
+	mutable std::atomic<uint64_t> mEvictions;
+	mutable std::atomic<uint64_t> mScannedEntries;
+	mutable std::atomic<size_t> mCachedBytes;
+};
+#endif // C_ADDRESS_ENTRY_STORE_H
@@ -0,0 +1,53 @@
+#ifndef C_ADDRESS_ENTRY_STREAM_STATE_H
+#define C_ADDRESS_ENTRY_STREAM_STATE_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressEntryStream.h"
+
+//=======================================================
+//		CAddressEntryStreamState : Produced entries shared by producer and consumer, handed out in chunks
+//=======================================================
+class CAddressEntryStreamState
+{
+public:
+	// C-tor
+	explicit CAddressEntryStreamState(size_t chunkSize);
+
+	// Producer: hand over entries to be read in chunks, never waits on the consumer
+	// returns false once the stream is cancelled
+	bool Write(AddressEntries&& entries);
+
+	// Producer: mark end of stream
+	void Close();
+
+	// Producer: end stream with an error to be rethrown to the consumer
+	void Fail(std::exception_ptr error);
+
+	// Consumer: cut next chunk off the entries, optionally waiting for one
+	AddressEntryStreamStatus Read(AddressEntries& outChunk, bool wait);
+
+	// Consumer: notify on new chunks or end of stream
+	void SetReadyCallback(const std::function<void()>& callback);
+
+	// Either end: stop producing and drop pending entries
+	void Cancel();
+
+	bool IsCancelled() const;
+
+private:
+	void NotifyReady(std::unique_lock<std::mutex>& lock);
+
+private:
+	mutable std::mutex mMutex;
+	std::condition_variable mCondition;
+
+	AddressEntries mEntries;
+	const size_t mChunkSize;
+
+	bool mClosed;
+	bool mCancelled;
+	std::exception_ptr mError;
+	std::function<void()> mReadyCallback;
+};
+#endif // C_ADDRESS_ENTRY_STREAM_STATE_H
\ No newline at end of file
@@ -0,0 +1,134 @@
+#ifndef C_ADDRESS_FROZEN_BOOK_H
+#define C_ADDRESS_FROZEN_BOOK_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressEntryStore.h"
+#include "CAddressFrozenTrie.h"
+#include "CAddressReaderEpoch.h"
+#include "CAddressRecord.h"
+
+//=======================================================
+//		CAddressFrozenBook : Immutable copy of an address book for lock-free reads
+//		entries are packed once, both tries refer to them by index,
+//		the entries themselves may be spilled to a payload file leaving only the tries and offsets in memory
+//=======================================================
+class CAddressFrozenBook
+{
+public:
+	// C-tor, records may be in any order, entries are kept where the options say
+	// throws std::ios_base::failure if a payload file cannot be written
+	explicit CAddressFrozenBook(const std::vector<CAddressRecordPtr>& records,
+								const CAddressTierOptions& tierOptions = CAddressTierOptions());
+	CAddressFrozenBook(const CAddressFrozenBook&) = delete;
+	CAddressFrozenBook& operator=(const CAddressFrozenBook&) = delete;
+
+	// Pack entries pulled from source, in the order added, without records in between
+	// tiered books stage the entries in a payload file first, so only their sort keys are held while building
+	// returns null with kAddressEntryDuplicate in outResult if an entry repeats,
+	// throws std::ios_base::failure if a payload file cannot be written
+	static std::unique_ptr<CAddressFrozenBook> Load(const AddressEntrySource& source,
+													const CAddressTierOptions& tierOptions,
+													AddressEntryError& outResult);
+
+	// Retrieve address in desired order
+	AddressEntries RetrieveEntries(AddressEntryOrderType orderType) const;
+
+	// Search address in desired search type, the key must be alphabets only
+	AddressEntries Search(const std::string& searchKey, AddressEntrySearchType searchType) const;
+
+	// Highest scored entries in desired search type, at most *count*, the key must be alphabets only
+	AddressEntries SearchRanked(const std::string& searchKey, size_t count, AddressEntrySearchType searchType) const;
+
+	// Entries matching a compound query, in first name order
+	AddressEntries Query(const AddressQuery& query) const;
+
+	// Pass in a function to iterate through each entry, in the mutable book's ForEach order
+	void ForEach(const AddressEntryCallback& callback) const;
+
+	// Pass in a function to iterate through entries [begin, end) of ForEach order
+	void ForEach(size_t begin, size_t end, const AddressEntryCallback& callback) const;
+
+	// Pass in a function to iterate through entries in desired order, the order RetrieveEntries returns them in
+	void ForEach(AddressEntryOrderType orderType, const AddressEntryCallback& callback) const;
+
+	// Pass in a function to iterate through entries in the order they were added
+	void ForEachInAddedOrder(const AddressEntryCallback& callback) const;
+
+	// Pass in a function called with every entry scored above zero and its score
+	// entries passed are copies if the book is tiered, look them up by value
+	void ForEachScored(const std::function<void(const AddressEntry&, uint64_t)>& callback) const;
+
+	size_t GetEntryCount() const;
+
+	// Check if entries live in a payload file, those passed to callbacks are then only valid during the call
+	bool IsTiered() const;
+
+	// Page cache counters of a tiered book
+	AddressBookTierStats GetTierStats() const;
+
+	// Trie sizes
+	void GetMetrics(AddressBookMetrics& outMetrics) const;
+
+	// Node and entry memory
+	AddressBookMemoryUsage GetMemoryUsage() const;
+
+private:
+	// C-tor of an empty book, filled in by Load
+	explicit CAddressFrozenBook(const CAddressTierOptions& tierOptions);
+
+	// Pass entries and their indexes in first name order to callback
+	void ForEachInFirstNameOrder(const std::function<void(uint32_t, const AddressEntry&)>& callback) const;
+
+	void CopyEntries(const CAddressFrozenRange& range, AddressEntries& outEntries) const;
+
+private:
+	// Entries with a first name in first name order, then those without in last name order
+	CAddressEntryStore mEntries;
+	uint32_t mFirstNameCount;
+
+	CAddressFrozenTrie mFirstNameTrie;
+	CAddressFrozenTrie mLastNameTrie;
+
+	// Entries without a last name, in first name order
+	std::vector<uint32_t> mNoLastNameEntries;
+
+	// Entry indexes in the order the entries were added
+	std::vector<uint32_t> mAddedOrder;
+
+	// Score of each entry, and its position in ranked order, highest score first
+	std::vector<uint64_t> mScores;
+	std::vector<uint32_t> mRanks;
+};
+
+//=======================================================
+//		CAddressFrozenReader : Pins a frozen book for the duration of a read
+//		a detached book is only freed once every reader that pinned it is gone
+//=======================================================
+class CAddressFrozenReader
+{
+public:
+	// C-tor
+	CAddressFrozenReader(const std::atomic<const CAddressFrozenBook*>& pBook, CAddressReaderEpoch& readers);
+	CAddressFrozenReader(const CAddressFrozenReader&) = delete;
+	CAddressFrozenReader& operator=(const CAddressFrozenReader&) = delete;
+
+	// D-tor, unpins the book
+	~CAddressFrozenReader();
+
+	// Pin the book if there is one, returns null otherwise
+	const CAddressFrozenBook* Pin();
+
+	const CAddressFrozenBook* Get() const;
+
+	// Detach the book without waiting for its readers, returns it for the caller to free
+	// once Synchronise of the readers, called without the book's lock, returns
+	static const CAddressFrozenBook* Detach(std::atomic<const CAddressFrozenBook*>& pBook);
+
+private:
+	const std::atomic<const CAddressFrozenBook*>& mpBookSlot;
+	CAddressReaderEpoch& mReaders;
+	const CAddressFrozenBook* mpBook;
+	uint32_t mEpoch;
+};
+#endif // C_ADDRESS_FROZEN_BOOK_H
@@ -0,0 +1,105 @@
+#ifndef C_ADDRESS_FROZEN_TRIE_H
+#define C_ADDRESS_FROZEN_TRIE_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookTypes.h"
+#include "AddressBookCommon.h"
+
+//=======================================================
+//		Constants
+//=======================================================
+// Subtrees holding up to this many entries are ranked by scanning them, larger ones keep their top entries
+constexpr uint32_t kAddressFrozenRankScanMax = 64;
+
+// Top entry offset of nodes ranked by scanning
+constexpr uint32_t kAddressFrozenNoRanking = UINT32_MAX;
+
+static_assert(kAddressFrozenRankScanMax >= kAddressBookRankedTopCount, "Ranked subtrees must hold a full top list");
+
+//=======================================================
+//		CAddressFrozenTrieNode : Node of a packed trie
+//		children of a node are stored next to each other, entries of a subtree are contiguous
+//=======================================================
+struct CAddressFrozenTrieNode
+{
+	// First child in the node array
+	uint32_t mChildBegin;
+
+	// Own entries, followed by those of the subtree up to mSubtreeEnd
+	uint32_t mEntryBegin;
+	uint32_t mEntryEnd;
+	uint32_t mSubtreeEnd;
+
+	uint8_t mChildCount;
+
+	// Character leading to this node
+	char mLabel;
+};
+
+//=======================================================
+//		CAddressFrozenRange : Contiguous run of entry indexes
+//=======================================================
+struct CAddressFrozenRange
+{
+	const uint32_t* mpBegin = nullptr;
+	const uint32_t* mpEnd = nullptr;
+
+	const uint32_t* begin() const { return mpBegin; }
+	const uint32_t* end() const { return mpEnd; }
+	size_t size() const { return mpEnd - mpBegin; }
+};
+
+//=======================================================
+//		CAddressFrozenTrie : Immutable trie packed into arrays
+//=======================================================
+class CAddressFrozenTrie
+{
+public:
+	// C-tor
+	CAddressFrozenTrie();
+
+	// Build from lower case keys sorted alphabetically, each with the index of its entry
+	void Build(const std::vector<std::pair<std::string, uint32_t>>& sortedKeys);
+
+	// Entry indexes whose key starts with the lower case key, in alphabetical order
+	CAddressFrozenRange Search(const std::string& key) const;
+
+	// Every entry index in alphabetical order
+	CAddressFrozenRange All() const;
+
+	// Keep the top entries of large subtrees, entry i ranks *ranks[i]*, lower first
+	void BuildRanking(const std::vector<uint32_t>& ranks);
+
+	// Highest ranked entry indexes whose key starts with the lower case key, at most *count*, in rank order
+	void SearchRanked(const std::string& key,
+					  size_t count,
+					  const std::vector<uint32_t>& ranks,
+					  std::vector<uint32_t>& outEntries) const;
+
+	// Node, entry and memory counts
+	AddressTrieMetrics GetMetrics() const;
+
+private:
+	// Node at the end of the lower case key, or null
+	const CAddressFrozenTrieNode* FindNode(const std::string& key) const;
+
+	// Fill node with keys in [begin, end), which share their first *depth* characters
+	void BuildNode(uint32_t nodeIndex,
+				   const std::vector<std::pair<std::string, uint32_t>>& sortedKeys,
+				   size_t begin,
+				   size_t end,
+				   size_t depth);
+
+private:
+	// Root first
+	std::vector<CAddressFrozenTrieNode> mNodes;
+
+	// Entry indexes in preorder
+	std::vector<uint32_t> mEntries;
+
+	// Offset of each node's top entries in mTopEntries, kAddressFrozenNoRanking for small subtrees
+	std::vector<uint32_t> mTopOffsets;
+	std::vector<uint32_t> mTopEntries;
+};
+#endif // C_ADDRESS_FROZEN_TRIE_H
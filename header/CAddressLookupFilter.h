@@ -0,0 +1,122 @@
+#ifndef C_ADDRESS_LOOKUP_FILTER_H
+#define C_ADDRESS_LOOKUP_FILTER_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookTypes.h"
+#include "AddressBookCommon.h"
+#include "CAddressReaderEpoch.h"
+
+//=======================================================
+//		Constants
+//=======================================================
+// Name prefixes of these lengths are held, shorter search keys are not filtered
+// and longer ones are checked by their prefix of the maximum length
+constexpr size_t kAddressFilterPrefixMin = 3;
+constexpr size_t kAddressFilterPrefixMax = 6;
+
+// Keys held per entry, the entry itself and its prefixes in both name orders
+constexpr size_t kAddressFilterKeysPerEntry = 1 + 2 * (kAddressFilterPrefixMax - kAddressFilterPrefixMin + 1);
+
+// Counters are 4 bits, one stuck at the maximum is never decremented again
+constexpr uint32_t kAddressFilterCounterBits = 4;
+constexpr uint32_t kAddressFilterCounterMax = (1u << kAddressFilterCounterBits) - 1;
+constexpr uint32_t kAddressFilterCountersPerWord = 64 / kAddressFilterCounterBits;
+
+//=======================================================
+//		CAddressLookupFilter : Counting Bloom filter over exact entries and name prefixes
+//		answers lookups for absent keys without the book's lock, never rejects a key that is present
+//		writers update it under the book's lock, readers only load counters
+//=======================================================
+class CAddressLookupFilter
+{
+public:
+	// C-tor, sized as if every key of *expectedEntries* entries was distinct
+	CAddressLookupFilter(size_t expectedEntries, double falsePositiveRate);
+	CAddressLookupFilter(const CAddressLookupFilter&) = delete;
+	CAddressLookupFilter& operator=(const CAddressLookupFilter&) = delete;
+
+	// Count entry and its name prefixes in, book's lock must be held, cannot fail
+	void Insert(const AddressEntry& entry) noexcept;
+
+	// Count entry and its name prefixes out, book's lock must be held, cannot fail
+	void Remove(const AddressEntry& entry) noexcept;
+
+	// Drop every key, book's lock must be held
+	void Clear();
+
+	// False if entry is certainly not in the book
+	bool MayContain(const AddressEntry& entry) const;
+
+	// False if no entry can match the alphabets only *searchKey* in prefix search type
+	bool MayMatch(const std::string& searchKey, AddressEntrySearchType searchType) const;
+
+	// Check if MayMatch can reject searchKey in search type, short keys and substring searches are let through
+	static bool IsFiltered(const std::string& searchKey, AddressEntrySearchType searchType);
+
+	// Count a lookup that was let through but found nothing
+	void CountFalsePositive() const;
+
+	AddressLookupFilterStats GetStats() const;
+
+private:
+	enum class KeyDomain : uint8_t
+	{
+		Entry,
+		FirstNamePrefix,
+		LastNamePrefix
+	};
+
+	// Apply function to the hash of every key of entry
+	template <typename Function>
+	static void ForEachKey(const AddressEntry& entry, Function&& function);
+
+	// Hash of the exact entry
+	static uint64_t HashEntry(const AddressEntry& entry);
+
+	// Hash of the first *length* characters of name followed by rest, case folded
+	static uint64_t HashPrefix(KeyDomain domain, const std::string& name, const std::string& rest, size_t length);
+
+	// Add delta to the counters of hash, saturated counters are left alone
+	void Update(uint64_t hash, int delta);
+
+	// Check if every counter of hash is set
+	bool Test(uint64_t hash) const;
+
+private:
+	std::unique_ptr<std::atomic<uint64_t>[]> mWords;
+	size_t mWordCount;
+	size_t mCounterCount;
+	uint32_t mHashCount;
+	double mFalsePositiveRate;
+
+	mutable std::atomic<uint64_t> mLookups;
+	mutable std::atomic<uint64_t> mRejected;
+	mutable std::atomic<uint64_t> mFalsePositives;
+};
+
+//=======================================================
+//		CAddressLookupFilterReader : Pins the book's lookup filter for the duration of a lookup
+//		like CAddressFrozenReader, but without entering an epoch while no filter is set
+//=======================================================
+class CAddressLookupFilterReader
+{
+public:
+	// C-tor
+	CAddressLookupFilterReader(const std::atomic<CAddressLookupFilter*>& pFilter, CAddressReaderEpoch& readers);
+	CAddressLookupFilterReader(const CAddressLookupFilterReader&) = delete;
+	CAddressLookupFilterReader& operator=(const CAddressLookupFilterReader&) = delete;
+
+	// D-tor, unpins the filter
+	~CAddressLookupFilterReader();
+
+	// Pin the filter if there is one, returns null otherwise
+	const CAddressLookupFilter* Pin();
+
+private:
+	const std::atomic<CAddressLookupFilter*>& mpFilterSlot;
+	CAddressReaderEpoch& mReaders;
+	const CAddressLookupFilter* mpFilter;
+	uint32_t mEpoch;
+};
+#endif // C_ADDRESS_LOOKUP_FILTER_H
@@ -0,0 +1,39 @@
+#ifndef C_ADDRESS_READER_EPOCH_H
+#define C_ADDRESS_READER_EPOCH_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookCommon.h"
+
+//=======================================================
+//		CAddressReaderEpoch : Counts lock-free readers of a structure the book swaps out under its lock
+//		readers are counted against the current epoch, Synchronise moves on to the next one
+//		and waits only for readers counted against the previous, so a steady stream of new readers
+//		never holds it up
+//=======================================================
+class CAddressReaderEpoch
+{
+public:
+	// C-tor
+	CAddressReaderEpoch();
+	CAddressReaderEpoch(const CAddressReaderEpoch&) = delete;
+	CAddressReaderEpoch& operator=(const CAddressReaderEpoch&) = delete;
+
+	// Count a reader in, returns the epoch to count it out of
+	uint32_t Enter();
+
+	// Count a reader out of the epoch it entered
+	void Exit(uint32_t epoch);
+
+	// Wait until every reader that entered before the call has exited, so a structure unpublished before it can be freed
+	// call without the book's lock, readers may be waiting for it
+	void Synchronise();
+
+private:
+	std::atomic<uint32_t> mEpoch;
+	std::array<std::atomic<uint32_t>, 2> mReaders;
+
+	// Synchronising callers take turns, each drains the epoch it moved on from
+	std::mutex mSynchroniseMutex;
+};
+#endif // C_ADDRESS_READER_EPOCH_H
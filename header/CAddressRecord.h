@@ -0,0 +1,117 @@
+#ifndef C_ADDRESS_RECORD_H
+#define C_ADDRESS_RECORD_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookTypes.h"
+#include "AddressBookCommon.h"
+
+//=======================================================
+//		Constants
+//=======================================================
+// Tries indexing the address book, used as slots into CAddressRecord::mHandles
+constexpr uint32_t kFirstNameTrieSlot = 0;
+constexpr uint32_t kLastNameTrieSlot = 1;
+constexpr uint32_t kNoFirstNameTrieSlot = 2;
+constexpr uint32_t kNoLastNameTrieSlot = 3;
+constexpr uint32_t kAddressBookTrieCount = 4;
+
+//=======================================================
+//		Aliases
+//=======================================================
+struct CAddressRecord;
+using CAddressRecordPtr = std::shared_ptr<CAddressRecord>;
+using CAddressRecordList = std::list<CAddressRecordPtr>;
+
+// Position of a record in a trie node, stays valid until the record is removed
+using CAddressRecordHandle = CAddressRecordList::iterator;
+
+// Records by phone number, ordered for prefix ranges
+using CAddressPhoneIndex = std::multimap<std::string, const CAddressRecord*>;
+
+//=======================================================
+//		CAddressRecord : Address entry shared by every trie of a book
+//=======================================================
+struct CAddressRecord
+{
+	// Never modified once the record is added, so it can be read through a shared reference without the lock
+	const AddressEntry mEntry;
+
+	// Unique within a book, later records have greater ids
+	const uint64_t mId;
+
+	// Position in each trie holding the record, only meaningful for those tries
+	std::array<CAddressRecordHandle, kAddressBookTrieCount> mHandles;
+
+	// Position in the phone index
+	CAddressPhoneIndex::iterator mPhoneHandle;
+
+	// Last SyncEntries pass that found the record in its entry set
+	uint64_t mSyncPass = 0;
+
+	// Popularity for ranked searches, only changed under the book's lock,
+	// atomic as off-lock rebuilds may read it while a writer holds the lock
+	std::atomic<uint64_t> mScore{ 0 };
+
+	CAddressRecord(const AddressEntry& entry, uint64_t id) : mEntry(entry), mId(id) {}
+	CAddressRecord(const CAddressRecord&) = delete;
+	CAddressRecord& operator=(const CAddressRecord&) = delete;
+};
+
+//=======================================================
+//		CAddressEntryHash : FNV-1a over first name, last name and phone number
+//=======================================================
+struct CAddressEntryHash
+{
+	size_t operator()(const AddressEntry* pEntry) const
+	{
+		constexpr uint64_t kOffsetBasis = 14695981039346656037ull;
+		constexpr uint64_t kPrime = 1099511628211ull;
+
+		uint64_t hash = kOffsetBasis;
+		for (const std::string* field : { &pEntry->mFirstName, &pEntry->mLastName, &pEntry->mPhoneNumber })
+		{
+			for (unsigned char c : *field)
+			{
+				hash = (hash ^ c) * kPrime;
+			}
+
+			// Field separator, so "ab"+"c" and "a"+"bc" differ
+			hash = (hash ^ 0xff) * kPrime;
+		}
+
+		return static_cast<size_t>(hash);
+	}
+};
+
+//=======================================================
+//		CAddressEntryEqual : Compare entries behind pointers
+//=======================================================
+struct CAddressEntryEqual
+{
+	bool operator()(const AddressEntry* pLhs, const AddressEntry* pRhs) const
+	{
+		return *pLhs == *pRhs;
+	}
+};
+
+//=======================================================
+//		CAddressRecordRank : Order records by descending score, ties in the order they were added
+//=======================================================
+struct CAddressRecordRank
+{
+	bool operator()(const CAddressRecord* pLhs, const CAddressRecord* pRhs) const
+	{
+		uint64_t lhsScore = pLhs->mScore.load(std::memory_order_relaxed);
+		uint64_t rhsScore = pRhs->mScore.load(std::memory_order_relaxed);
+
+		return lhsScore != rhsScore ? lhsScore > rhsScore : pLhs->mId < pRhs->mId;
+	}
+};
+
+//=======================================================
+//		CAddressRecordIndex : Hash index of records by their full entry
+//		keyed on the record's own entry, so any AddressEntry can be used for lookups
+//=======================================================
+using CAddressRecordIndex = std::unordered_map<const AddressEntry*, CAddressRecordPtr, CAddressEntryHash, CAddressEntryEqual>;
+#endif // C_ADDRESS_RECORD_H
\ No newline at end of file
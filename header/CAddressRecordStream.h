@@ -0,0 +1,24 @@
+#ifndef C_ADDRESS_RECORD_STREAM_H
+#define C_ADDRESS_RECORD_STREAM_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressRecord.h"
+
+//=======================================================
+//		Aliases
+//=======================================================
+// Records in ascending id order, the form every index answers compound queries in
+using CAddressRecordStream = std::vector<const CAddressRecord*>;
+
+//=======================================================
+//		Functions
+//=======================================================
+// Sort records into a stream
+void SortRecordStream(CAddressRecordStream& stream);
+
+// Records in either stream
+void UniteRecordStreams(const CAddressRecordStream& lhs,
+						const CAddressRecordStream& rhs,
+						CAddressRecordStream& outStream);
+#endif // C_ADDRESS_RECORD_STREAM_H
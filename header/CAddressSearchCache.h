@@ -0,0 +1,73 @@
+#ifndef C_ADDRESS_SEARCH_CACHE_H
+#define C_ADDRESS_SEARCH_CACHE_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookTypes.h"
+#include "AddressBookCommon.h"
+
+//=======================================================
+//		CAddressSearchCache : LRU cache of search results with a memory budget
+//=======================================================
+class CAddressSearchCache
+{
+public:
+	// Shared handle to a cached search result
+	using SearchResult = std::shared_ptr<const AddressEntries>;
+
+public:
+	// C-tor, cache is disabled until given a budget
+	CAddressSearchCache();
+
+	// Set memory budget in bytes, zero disables the cache
+	void SetBudget(size_t budgetBytes);
+
+	bool IsEnabled() const;
+
+	// Look up result for a lower case search key, null on miss
+	SearchResult Find(AddressEntrySearchType searchType, const std::string& searchKey);
+
+	// Cache result for a lower case search key
+	void Insert(AddressEntrySearchType searchType, const std::string& searchKey, const SearchResult& result);
+
+	// Drop results for every search key that prefixes the entry's trie keys or is contained in its names
+	void Invalidate(const AddressEntry& entry);
+
+	// Drop all results
+	void Clear();
+
+	// Get counters
+	AddressSearchCacheStats GetStats() const;
+
+private:
+	struct CacheItem
+	{
+		std::string mLookupKey;
+		SearchResult mResult;
+		size_t mBytes;
+	};
+
+	using CacheList = std::list<CacheItem>;
+
+	static std::string LookupKey(AddressEntrySearchType searchType, const std::string& searchKey);
+
+	// Erase results of a search type for every prefix of key
+	void InvalidatePrefixes(AddressEntrySearchType searchType, const std::string& key);
+
+	// Erase results of a search type for every substring of key
+	void InvalidateSubstrings(AddressEntrySearchType searchType, const std::string& key);
+
+	void Erase(CacheList::iterator it);
+
+	void EvictToBudget();
+
+private:
+	// Most recently used at the front
+	CacheList mItems;
+	std::unordered_map<std::string, CacheList::iterator> mLookup;
+
+	size_t mBudgetBytes;
+	size_t mBytes;
+	AddressSearchCacheStats mStats;
+};
+#endif // C_ADDRESS_SEARCH_CACHE_H
\ No newline at end of file
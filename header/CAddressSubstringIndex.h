@@ -0,0 +1,79 @@
+#ifndef C_ADDRESS_SUBSTRING_INDEX_H
+#define C_ADDRESS_SUBSTRING_INDEX_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressRecord.h"
+
+//=======================================================
+//		Constants
+//=======================================================
+// Characters of the longest indexed gram, keys of up to this many characters have a posting list of their own
+constexpr size_t kAddressSubstringGramLength = 3;
+
+//=======================================================
+//		CAddressSubstringIndex : Inverted index of the 1, 2 and 3 character grams of first and last names
+//		posting lists hold record ids in ascending order, removed ids are dropped lazily
+//=======================================================
+class CAddressSubstringIndex
+{
+public:
+	// C-tor
+	CAddressSubstringIndex();
+
+	// Index record, its id must be greater than that of any record indexed before
+	void Insert(const CAddressRecordPtr& pRecord);
+
+	// Stop matching record, ids are left in posting lists so nothing is allocated
+	void Remove(const CAddressRecord& record) noexcept;
+
+	// Records whose first or last name contains the lower case key, in no particular order
+	void Search(const std::string& key, std::vector<const CAddressRecord*>& outRecords) const;
+
+	// Drop all records
+	void Clear();
+
+	// Number of indexed records
+	size_t GetRecordCount() const;
+
+	// Exchange contents, used to swap in an index built outside the lock
+	void Swap(CAddressSubstringIndex& other);
+
+	// Check if first or last name contains the lower case key
+	static bool Contains(const CAddressRecord& record, const std::string& key);
+
+private:
+	using Gram = uint32_t;
+	using Posting = std::vector<uint64_t>;
+
+	struct IndexedRecord
+	{
+		const CAddressRecord* mpRecord;
+
+		// Posting lists holding the record's id
+		size_t mGramCount;
+	};
+
+	// Distinct grams of the record's first and last names
+	static void CollectGrams(const CAddressRecord& record, std::vector<Gram>& outGrams);
+
+	// Grams of *length* characters of a lower case string
+	static void CollectGrams(const std::string& str, size_t length, std::vector<Gram>& outGrams);
+
+	// Grams a lower case key is searched by, the key itself if it is no longer than a gram
+	static void CollectKeyGrams(const std::string& key, std::vector<Gram>& outGrams);
+
+	// Drop ids of removed records from every posting list
+	void CompactPostings() noexcept;
+
+private:
+	std::unordered_map<Gram, Posting> mPostings;
+
+	// Live records by id
+	std::unordered_map<uint64_t, IndexedRecord> mRecords;
+
+	// Ids held by posting lists, and how many of them belong to removed records
+	size_t mPostingIds;
+	size_t mDeadPostingIds;
+};
+#endif // C_ADDRESS_SUBSTRING_INDEX_H
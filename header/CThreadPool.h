@@ -0,0 +1,53 @@
+#ifndef C_THREAD_POOL_H
+#define C_THREAD_POOL_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookCommon.h"
+
+//=======================================================
+//		CThreadPool : Fixed size pool of worker threads
+//=======================================================
+class CThreadPool
+{
+public:
+	// C-tor, zero thread count uses hardware concurrency
+	explicit CThreadPool(uint32_t threadCount = 0);
+	CThreadPool(const CThreadPool&) = delete;
+	CThreadPool& operator=(const CThreadPool&) = delete;
+
+	// D-tor, finishes queued tasks before joining workers
+	~CThreadPool();
+
+	// Queue a task, result is retrieved through the returned future
+	template <typename Task>
+	auto Submit(Task&& task) -> std::future<decltype(task())>
+	{
+		using Result = decltype(task());
+
+		auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+		std::future<Result> result = packagedTask->get_future();
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mTasks.emplace_back([packagedTask]() { (*packagedTask)(); });
+		}
+
+		mCondition.notify_one();
+		return result;
+	}
+
+	// Number of worker threads
+	uint32_t GetThreadCount() const;
+
+private:
+	void WorkerLoop();
+
+private:
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::deque<std::function<void()>> mTasks;
+	std::vector<std::thread> mWorkers;
+	bool mStopping;
+};
+#endif // C_THREAD_POOL_H
\ No newline at end of file
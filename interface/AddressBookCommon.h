@@ -10,6 +10,19 @@
 #include <mutex>
 #include <array>
 #include <unordered_set>
+#include <unordered_map>
+#include <map>
+#include <optional>
+#include <tuple>
+#include <chrono>
 #include <memory>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <thread>
+#include <future>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
 
 #endif // ADDRESS_BOOK_COMMON_H
\ No newline at end of file
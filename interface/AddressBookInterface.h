@@ -4,6 +4,9 @@
 //		Includes
 //=======================================================
 #include "AddressBookTypes.h"
+#include "AddressEntryStream.h"
+#include "AddressChangeLog.h"
+#include "AddressBookSnapshot.h"
 
 //=======================================================
 //		AddressBookInterface
@@ -13,11 +16,20 @@ namespace AddressBookInterface
 	// Add an address entry to the address book
 	AddressEntryError AddEntry(const AddressEntry& entry);
 
+	// Add address entries to the address book at once
+	// either every entry is added, or none is and the first rejection is returned
+	AddressEntryError AddEntries(const AddressEntries& entries);
+
 	// Remove an address entry from the address book
 	// if *match* is true, only entries that match exactly will be removed
 	AddressEntryError RemoveEntry(const AddressEntry& entry, 
 								  bool match = true);
 
+	// Make the address book hold exactly *entries*, e.g. a fresh full export,
+	// only entries missing from either side are added or removed, and readers see the old or the new book, never a mix
+	// nothing changes if any entry is invalid, repeated entries are added once
+	AddressEntryError SyncEntries(const AddressEntries& entries, AddressEntrySyncStats& outStats);
+
 	// Retrieve entries in specified order
 	AddressEntries RetrieveEntries(AddressEntryOrderType orderType);
 
@@ -25,10 +37,142 @@ namespace AddressBookInterface
 	AddressEntries Search(const std::string& searchKey, 
 						  AddressEntrySearchType searchType = AddressEntrySearchType::FirstAndLastNameSearch);
 
+	// Query for the *count* highest scored addresses with specified search type, ties in the order they were added
+	// ranked searches for up to kAddressBookRankedTopCount entries cost about the key length, whatever the number of matches
+	AddressEntries SearchRanked(const std::string& searchKey,
+								size_t count,
+								AddressEntrySearchType searchType = AddressEntrySearchType::FirstAndLastNameSearch);
+
+	// Set the score of an address entry for ranked searches, e.g. how often it was contacted
+	// every entry starts at zero, scores are local to this book and not published to the change feed
+	AddressEntryError SetEntryScore(const AddressEntry& entry, uint64_t score);
+
+	// Query for addresses matching every (And) or any (Or) of the query's terms, in first name order
+	// e.g. first name starts with "jo" and phone number starts with "555"
+	AddressEntries Query(const AddressQuery& query);
+
 	// Pass in function iteratively applied to each address entry in the book
 	void ForEach(const AddressEntryCallback& callback);
 
+	// Pass in function applied to each address entry in the book, traversing the book on worker threads
+	// if *traversalType* is Unordered, the callback must be thread-safe
+	void ParallelForEach(const AddressEntryCallback& callback,
+						 AddressEntryTraversalType traversalType = AddressEntryTraversalType::Unordered);
+
+	// Pin the book's current version for long-running reads, e.g. reports sweeping every entry
+	// the snapshot is read without the lock while writers keep committing, pins of an unchanged book share one copy,
+	// a new version of a mutable book costs a full copy of it (see AddressBookSnapshot) while a frozen one is shared
+	AddressBookSnapshot PinSnapshot();
+
 	// Clear address book
 	void Clear();
+
+	// Cache results of frequent searches within *budgetBytes*, zero disables the cache (default)
+	void SetSearchCacheBudget(size_t budgetBytes);
+
+	// Get search cache hit/miss counters
+	AddressSearchCacheStats GetSearchCacheStats();
+
+	// Lookup filter: a counting Bloom filter over exact entries and name prefixes answers Search, SearchRanked
+	// and exact RemoveEntry calls for names no entry has without taking the lock, keys shorter than 3 letters
+	// and substring searches always go to the book, sized for *expectedEntries* at *falsePositiveRate* (0-1),
+	// zero entries drops the filter (default), the rate rises once the book outgrows *expectedEntries*
+	AddressEntryError SetLookupFilter(size_t expectedEntries, double falsePositiveRate);
+
+	// Get lookup filter counters, false positives are lookups let through that found nothing
+	AddressLookupFilterStats GetLookupFilterStats();
+
+	// Snapshot of operation latencies, lock wait/hold times and trie sizes
+	// latencies are only recorded if the library was built with ADDRESS_BOOK_ENABLE_METRICS
+	AddressBookMetrics GetMetrics();
+
+	// Count live and dead trie nodes
+	AddressBookMemoryUsage GetMemoryUsage();
+
+	// Rebuild tries in the background into a freshly allocated layout and swap them in,
+	// returns memory usage after compaction
+	std::future<AddressBookMemoryUsage> Compact();
+
+	// Build (or drop) an index of the 1 to 3 letter grams of names in the background, speeding up SubstringSearch
+	// substring searches scan every entry while the index is disabled (default)
+	std::future<void> SetSubstringIndexEnabled(bool enabled);
+
+	// Pack the book into read-only tries in the background, reads then take no lock
+	// and writes fail with kAddressEntryReadOnly until thawed, returns memory usage after freezing
+	std::future<AddressBookMemoryUsage> Freeze();
+
+	// Convert a frozen book back into mutable tries in the background
+	std::future<AddressBookMemoryUsage> Thaw();
+
+	// Replace every entry with those pulled from *source*, packed straight into a frozen book without building
+	// mutable tries, kept where SetTieredStorage says: a tiered load stages entries in a payload file and only holds
+	// their sort keys, then the packed tries and an offset per entry, in memory
+	// the book is left as it was if an entry is rejected (kAddressEntryInvalid, kAddressEntryDuplicate)
+	// or the payload file cannot be written (kAddressEntryIOFailure), with the change feed enabled the loaded
+	// entries are published as adds after a clear, which reads them all back
+	AddressEntryError LoadFrozen(const AddressEntrySource& source);
+
+	// Tiered storage: books frozen from now on keep only their tries and an offset per entry in memory,
+	// entries go to an append-only payload file in *directory* and are read back through a page cache of *cacheBytes*
+	// an empty directory keeps entries in memory (default), returns kAddressEntryIOFailure if directory does not exist
+	// Freeze fails with std::ios_base::failure if the payload file cannot be written, the book then stays mutable
+	AddressEntryError SetTieredStorage(const std::string& directory, size_t cacheBytes);
+
+	// Page cache hits, misses and sizes of the frozen book, zero unless it is tiered
+	AddressBookTierStats GetTierStats();
+
+	// Change feed: every committed Add, Remove and Clear gets the next sequence number
+	// followers apply them in order to stay in sync without re-importing the book
+
+	// Keep up to *capacity* latest changes in memory for ReadChanges, zero disables it (default)
+	void SetChangeFeedCapacity(size_t capacity);
+
+	// Append changes to a log file, read back with AddressChangeLogReader, an empty path closes it
+	// every commit writes and flushes its changes before releasing the book's lock, so a slow disk slows writers down
+	AddressEntryError SetChangeLog(const std::string& path);
+
+	// kAddressEntryIOFailure once a write to the change log failed, the log is closed then so it never holds a gap,
+	// and stays closed until SetChangeLog is called again, success otherwise
+	AddressEntryError GetChangeLogStatus();
+
+	// Changes published after *afterSequence*, at most *maxCount*, waiting up to *timeout* for the first one
+	// returns kAddressEntryOutOfSequence once the feed dropped them, resynchronise from a snapshot then
+	AddressEntryError ReadChanges(uint64_t afterSequence,
+								  size_t maxCount,
+								  std::chrono::milliseconds timeout,
+								  AddressChanges& outChanges);
+
+	// Every entry and the sequence of the last change it includes
+	AddressEntries RetrieveChangeSnapshot(uint64_t& outSequence);
+
+	// Apply changes read from a leader, changes already applied are skipped
+	// returns kAddressEntryOutOfSequence on a gap, changes before it stay applied
+	AddressEntryError ApplyChanges(const AddressChanges& changes);
+
+	// Replace every entry with a leader's snapshot taken at *sequence*
+	AddressEntryError ApplyChangeSnapshot(const AddressEntries& entries, uint64_t sequence);
+
+	// Sequence of the last leader change applied
+	uint64_t GetAppliedSequence();
+
+	// Asynchronous variants below run on an internal executor of their own and never block the caller,
+	// nor the background Compact, Freeze and Thaw, however slowly their results are consumed
+	// results are copied under the book's lock, then handed to the stream and read back in chunks of *chunkSize*:
+	// the whole result is built first, just as by the synchronous call, so streaming saves no memory,
+	// but an unread stream holds no executor thread
+
+	// Retrieve entries in specified order
+	AddressEntryStream RetrieveEntriesAsync(AddressEntryOrderType orderType,
+											size_t chunkSize = kAddressEntryStreamChunkSize);
+
+	// Query for addresses in the address book with specified search type
+	AddressEntryStream SearchAsync(const std::string& searchKey,
+								   AddressEntrySearchType searchType = AddressEntrySearchType::FirstAndLastNameSearch,
+								   size_t chunkSize = kAddressEntryStreamChunkSize);
+
+	// Pass in function iteratively applied to each address entry of a snapshot, so writers are not held up
+	// setting *cancelFlag* stops the iteration before the next entry
+	std::future<void> ForEachAsync(const AddressEntryCallback& callback,
+								   AddressBookCancelFlag cancelFlag = nullptr);
 }
 #endif // ADDRESS_BOOK_INTERFACE_H
\ No newline at end of file
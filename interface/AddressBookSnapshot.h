@@ -0,0 +1,57 @@
+#ifndef ADDRESS_BOOK_SNAPSHOT_H
+#define ADDRESS_BOOK_SNAPSHOT_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookTypes.h"
+#include "AddressEntryBlocks.h"
+
+//=======================================================
+//		Forward declaration
+//=======================================================
+class CAddressBookVersion;
+
+//=======================================================
+//		AddressBookSnapshot : Consistent read-only view of the address book at one version
+//		reads take no lock and writers keep committing newer versions while it is held,
+//		the version is reclaimed once every snapshot pinning it is gone
+//		pinning a version of a mutable book copies a pointer per entry under the book's lock, O(n),
+//		and then packs a full read-only copy of the book outside it, O(n log n) time and O(n) memory per version,
+//		so pins of frequently changing books are best kept coarse; a frozen book is shared as is at no cost,
+//		and pins of an unchanged version share its copy
+//=======================================================
+class AddressBookSnapshot
+{
+public:
+	// C-tor, copies pin the same version
+	explicit AddressBookSnapshot(std::shared_ptr<const CAddressBookVersion> pVersion);
+
+	// Version of the book the snapshot shows, later versions include later writes
+	uint64_t GetVersion() const;
+
+	size_t GetEntryCount() const;
+
+	// Retrieve entries in specified order
+	AddressEntries RetrieveEntries(AddressEntryOrderType orderType) const;
+
+	// Query for addresses with specified search type
+	AddressEntries Search(const std::string& searchKey,
+						  AddressEntrySearchType searchType = AddressEntrySearchType::FirstAndLastNameSearch) const;
+
+	// Query for addresses matching a compound query, in first name order
+	AddressEntries Query(const AddressQuery& query) const;
+
+	// Pass in function iteratively applied to each address entry, in the order of AddressBookInterface::ForEach
+	void ForEach(const AddressEntryCallback& callback) const;
+
+	// Entries in specified order, encoded into the compressed block format for export or replication
+	// decode with AddressEntryBlockReader
+	std::string Encode(AddressEntryOrderType orderType, size_t blockSize = kAddressEntryBlockSize) const;
+
+	// Unpin the version early, the snapshot is empty afterwards
+	void Release();
+
+private:
+	std::shared_ptr<const CAddressBookVersion> mpVersion;
+};
+#endif // ADDRESS_BOOK_SNAPSHOT_H
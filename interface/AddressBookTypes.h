@@ -15,7 +15,10 @@ enum class AddressEntryError : uint32_t
 	kAddressEntryDuplicate,
 	kAddressEntryInvalid,
 	kAddressEntryNotFound,
-	kAddressEntryNotAttempted
+	kAddressEntryNotAttempted,
+	kAddressEntryReadOnly,
+	kAddressEntryOutOfSequence,
+	kAddressEntryIOFailure
 };
 
 // Retrieval order type
@@ -30,15 +33,82 @@ enum class AddressEntrySearchType : uint32_t
 {
 	FirstNameSearch,
 	LastNameSearch,
-	FirstAndLastNameSearch
+	FirstAndLastNameSearch,
+	SubstringSearch		// first or last name contains the key
+};
+
+// Entry field matched by compound query terms
+enum class AddressEntryField : uint32_t
+{
+	FirstName,
+	LastName,
+	PhoneNumber
+};
+
+// How compound query terms are combined
+enum class AddressQueryOperator : uint32_t
+{
+	And,
+	Or
+};
+
+// Parallel traversal type
+enum class AddressEntryTraversalType : uint32_t
+{
+	Ordered,	// callback invoked on the calling thread, in ForEach order
+	Unordered	// callback invoked concurrently from worker threads
+};
+
+// Asynchronous stream read status
+enum class AddressEntryStreamStatus : uint32_t
+{
+	kStreamChunk,		// a chunk was returned
+	kStreamPending,		// no chunk is ready yet
+	kStreamEnded,		// every chunk was returned
+	kStreamCancelled	// stream was cancelled
+};
+
+// Mutation published to the change feed
+enum class AddressChangeType : uint32_t
+{
+	Add,
+	Remove,
+	Clear
+};
+
+// Instrumented address book operations
+enum class AddressBookOperation : uint32_t
+{
+	AddEntry,
+	RemoveEntry,
+	RetrieveEntries,
+	Search,
+	ForEach,
+	Clear
 };
 
+//=======================================================
+//		Constants
+//=======================================================
+constexpr uint32_t kAddressBookOperationCount = 6;
+
+// Histogram bucket i counts latencies in [2^i, 2^(i+1)) nanoseconds
+constexpr uint32_t kAddressBookLatencyBuckets = 40;
+
+// Ranked searches for up to this many entries are answered from rankings kept in the tries,
+// longer ones rank every match
+constexpr size_t kAddressBookRankedTopCount = 10;
+
 //=======================================================
 //		Aliases
 //=======================================================
 struct AddressEntry;
 using AddressEntries = std::list<AddressEntry>;
 using AddressEntryCallback = std::function<void(const AddressEntry& addressEntry)>;
+using AddressBookCancelFlag = std::shared_ptr<std::atomic<bool>>;
+
+// Fills in the next entry of a bulk load, returns false once there is none left
+using AddressEntrySource = std::function<bool(AddressEntry& outEntry)>;
 
 //=======================================================
 //		AddressEntry : A single address entry
@@ -63,6 +133,193 @@ struct AddressEntry
 	}
 };
 
+//=======================================================
+//		AddressQueryTerm : Entries whose field starts with a prefix
+//=======================================================
+struct AddressQueryTerm
+{
+	AddressEntryField mField = AddressEntryField::FirstName;
+
+	// Names are matched case insensitively
+	std::string mPrefix;
+};
+
+//=======================================================
+//		AddressQuery : Query terms combined with a single operator
+//=======================================================
+struct AddressQuery
+{
+	std::vector<AddressQueryTerm> mTerms;
+	AddressQueryOperator mOperator = AddressQueryOperator::And;
+};
+
+//=======================================================
+//		AddressChange : One mutation of the address book, in the order it was committed
+//=======================================================
+struct AddressChange
+{
+	// Consecutive per book, starting from 1
+	uint64_t mSequence = 0;
+
+	AddressChangeType mType = AddressChangeType::Add;
+
+	// Entry added or removed, empty for Clear
+	AddressEntry mEntry;
+};
+
+using AddressChanges = std::vector<AddressChange>;
+
+//=======================================================
+//		AddressSearchCacheStats : Search result cache counters
+//=======================================================
+struct AddressSearchCacheStats
+{
+	uint64_t mHits = 0;
+	uint64_t mMisses = 0;
+	uint64_t mEvictions = 0;
+	uint64_t mInvalidations = 0;
+
+	size_t mResultCount = 0;
+	size_t mBytes = 0;
+	size_t mBudgetBytes = 0;
+};
+
+//=======================================================
+//		AddressLookupFilterStats : Lookup filter counters
+//=======================================================
+struct AddressLookupFilterStats
+{
+	bool mEnabled = false;
+
+	// Lookups checked, those answered without the lock, and those let through that found nothing
+	uint64_t mLookups = 0;
+	uint64_t mRejected = 0;
+	uint64_t mFalsePositives = 0;
+
+	double mFalsePositiveRate = 0.0;
+	uint32_t mHashCount = 0;
+	size_t mBytes = 0;
+};
+
+//=======================================================
+//		AddressBookTierStats : Page cache counters of a tiered frozen book
+//=======================================================
+struct AddressBookTierStats
+{
+	// False while entries are held in memory, the counters below are then zero
+	bool mTiered = false;
+
+	// Page reads served from and missing the cache
+	uint64_t mHits = 0;
+	uint64_t mMisses = 0;
+	uint64_t mEvictions = 0;
+
+	// Entries read by sequential sweeps, which bypass the cache
+	uint64_t mScannedEntries = 0;
+
+	size_t mEntryCount = 0;
+	uint64_t mPayloadBytes = 0;
+	size_t mCachedBytes = 0;
+	size_t mBudgetBytes = 0;
+};
+
+//=======================================================
+//		AddressBookLatencyHistogram : Latency distribution snapshot
+//=======================================================
+struct AddressBookLatencyHistogram
+{
+	std::array<uint64_t, kAddressBookLatencyBuckets> mBuckets{};
+	uint64_t mCount = 0;
+	uint64_t mTotalNanoseconds = 0;
+	uint64_t mMaxNanoseconds = 0;
+
+	// Mean latency in nanoseconds
+	double Mean() const;
+
+	// Upper bound of the bucket holding the *percentile* (0-100) sample, in nanoseconds
+	uint64_t Percentile(double percentile) const;
+};
+
+//=======================================================
+//		AddressBookOperationMetrics : Metrics of one operation type
+//=======================================================
+struct AddressBookOperationMetrics
+{
+	AddressBookLatencyHistogram mLatency;
+
+	// Entries returned or visited
+	uint64_t mEntries = 0;
+};
+
+//=======================================================
+//		AddressTrieMetrics : Size of one trie
+//=======================================================
+struct AddressTrieMetrics
+{
+	size_t mNodeCount = 0;
+	size_t mEntryCount = 0;
+
+	// Approximate heap bytes held by nodes and entries
+	size_t mBytes = 0;
+};
+
+//=======================================================
+//		AddressEntrySyncStats : Changes made by synchronising the book to a new entry set
+//=======================================================
+struct AddressEntrySyncStats
+{
+	// Entries of the new set not in the book
+	size_t mAdded = 0;
+
+	// Entries of the book not in the new set
+	size_t mRemoved = 0;
+
+	// Entries in both, left untouched
+	size_t mUnchanged = 0;
+};
+
+//=======================================================
+//		AddressBookMemoryUsage : Node and entry memory of the address book's tries
+//=======================================================
+struct AddressBookMemoryUsage
+{
+	// Nodes leading to at least one entry
+	size_t mLiveNodes = 0;
+
+	// Nodes with no entry below them
+	size_t mDeadNodes = 0;
+
+	// Entries held across tries, an entry with both names is held twice
+	size_t mEntries = 0;
+
+	// Approximate heap bytes held by nodes and entries
+	size_t mBytes = 0;
+};
+
+//=======================================================
+//		AddressBookMetrics : Snapshot of address book instrumentation
+//=======================================================
+struct AddressBookMetrics
+{
+	// False if instrumentation was compiled out, only trie sizes are then filled in
+	bool mEnabled = false;
+
+	// Indexed by AddressBookOperation
+	std::array<AddressBookOperationMetrics, kAddressBookOperationCount> mOperations;
+
+	// Time spent waiting for and holding the address book's lock
+	AddressBookLatencyHistogram mLockWait;
+	AddressBookLatencyHistogram mLockHold;
+
+	// Time spent in ForEach callbacks, one sample per ForEach
+	AddressBookLatencyHistogram mForEachCallback;
+
+	AddressTrieMetrics mFirstNameTrie;
+	AddressTrieMetrics mLastNameTrie;
+	AddressTrieMetrics mNoFirstNameTrie;
+	AddressTrieMetrics mNoLastNameTrie;
+};
+
 //=======================================================
 //		Stream operators
 //=======================================================
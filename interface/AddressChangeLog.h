@@ -0,0 +1,42 @@
+#ifndef ADDRESS_CHANGE_LOG_H
+#define ADDRESS_CHANGE_LOG_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookTypes.h"
+
+// System
+#include <fstream>
+
+//=======================================================
+//		Constants
+//=======================================================
+// Bytes read from the log file at a time
+constexpr size_t kAddressChangeLogReadSize = 64 * 1024;
+
+//=======================================================
+//		AddressChangeLogReader : Follows a change log file appended to by another book
+//=======================================================
+class AddressChangeLogReader
+{
+public:
+	// C-tor
+	AddressChangeLogReader();
+	AddressChangeLogReader(const AddressChangeLogReader&) = delete;
+	AddressChangeLogReader& operator=(const AddressChangeLogReader&) = delete;
+
+	// Open the log at path, reading from its start
+	AddressEntryError Open(const std::string& path);
+
+	// Changes appended since the last read, at most *maxCount*
+	// a record still being written is returned by a later read
+	AddressEntryError Read(size_t maxCount, AddressChanges& outChanges);
+
+private:
+	std::ifstream mFile;
+
+	// Bytes read but not decoded yet, from mBufferOffset on
+	std::string mBuffer;
+	size_t mBufferOffset;
+};
+#endif // ADDRESS_CHANGE_LOG_H
@@ -0,0 +1,100 @@
+#ifndef ADDRESS_ENTRY_BLOCKS_H
+#define ADDRESS_ENTRY_BLOCKS_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookTypes.h"
+
+//=======================================================
+//		Constants
+//=======================================================
+// Entries per block, the unit of random access, names are front coded against the previous entry of their block
+constexpr size_t kAddressEntryBlockSize = 64;
+
+// Header, index offset and entry count ahead of and after the blocks
+constexpr uint32_t kAddressEntryBlocksMagic = 0x314b4241;	// "ABK1"
+constexpr size_t kAddressEntryBlocksHeaderBytes = 2 * sizeof(uint32_t) + sizeof(uint8_t);
+constexpr size_t kAddressEntryBlocksFooterBytes = 2 * sizeof(uint64_t);
+
+//=======================================================
+//		AddressEntryBlockWriter : Encodes entries into the compressed block format
+//		e.g. a snapshot or an export, sent to a follower or written to a file
+//
+//		blocks hold kAddressEntryBlockSize entries each, in the order appended:
+//		the name sort key (first then last name in first name order, last then first in last name order)
+//		shares a prefix with the previous entry's and only the rest is stored, phone numbers are packed two digits a byte,
+//		an index of block offsets at the end gives random access to any entry by decoding a single block
+//=======================================================
+class AddressEntryBlockWriter
+{
+public:
+	// C-tor, entries appended in *orderType* compress best, any order round trips
+	explicit AddressEntryBlockWriter(AddressEntryOrderType orderType, size_t blockSize = kAddressEntryBlockSize);
+
+	// Append entry to the current block
+	void Append(const AddressEntry& entry);
+
+	// Append the index and move the encoded entries out, the writer starts over afterwards
+	std::string Finish();
+
+	// Entries appended since the writer started
+	size_t GetCount() const;
+
+private:
+	AddressEntryOrderType mOrderType;
+	size_t mBlockSize;
+
+	std::string mBuffer;
+	std::vector<uint64_t> mBlockOffsets;
+	uint64_t mCount;
+
+	// Sort keys of the entry being appended and of the previous entry of the block
+	std::string mKey;
+	std::string mPreviousKey;
+};
+
+//=======================================================
+//		AddressEntryBlockReader : Decodes entries of the compressed block format
+//		every read is bounds checked, malformed buffers are rejected with kAddressEntryInvalid
+//=======================================================
+class AddressEntryBlockReader
+{
+public:
+	// C-tor
+	AddressEntryBlockReader();
+
+	// Take encoded entries and check their header and index
+	AddressEntryError Open(std::string buffer);
+
+	size_t GetCount() const;
+
+	size_t GetBlockCount() const;
+
+	// Order the entries were encoded for
+	AddressEntryOrderType GetOrderType() const;
+
+	// Append the entries of block
+	AddressEntryError ReadBlock(size_t block, AddressEntries& outEntries) const;
+
+	// Entry at index, decoding its block up to it
+	AddressEntryError Read(size_t index, AddressEntry& outEntry) const;
+
+	// Append every entry, in the order they were encoded
+	AddressEntryError ReadAll(AddressEntries& outEntries) const;
+
+	// Pass in function iteratively applied to each entry, in the order they were encoded
+	AddressEntryError ForEach(const AddressEntryCallback& callback) const;
+
+private:
+	// Decode block up to entry *last* of it, passing each entry to callback
+	template <typename Callback>
+	AddressEntryError DecodeBlock(size_t block, size_t last, Callback&& callback) const;
+
+private:
+	std::string mBuffer;
+	AddressEntryOrderType mOrderType;
+	size_t mBlockSize;
+	uint64_t mCount;
+	uint64_t mIndexOffset;
+};
+#endif // ADDRESS_ENTRY_BLOCKS_H
@@ -0,0 +1,51 @@
+#ifndef ADDRESS_ENTRY_STREAM_H
+#define ADDRESS_ENTRY_STREAM_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookTypes.h"
+
+//=======================================================
+//		Constants
+//=======================================================
+// Default number of entries per streamed chunk
+constexpr size_t kAddressEntryStreamChunkSize = 256;
+
+//=======================================================
+//		Forward declaration
+//=======================================================
+class CAddressEntryStreamState;
+
+//=======================================================
+//		AddressEntryStream : Consumer end of asynchronously produced entries
+//=======================================================
+class AddressEntryStream
+{
+public:
+	// C-tor
+	explicit AddressEntryStream(std::shared_ptr<CAddressEntryStreamState> pState);
+	AddressEntryStream(AddressEntryStream&& other) noexcept;
+	AddressEntryStream& operator=(AddressEntryStream&& other) noexcept;
+	AddressEntryStream(const AddressEntryStream&) = delete;
+	AddressEntryStream& operator=(const AddressEntryStream&) = delete;
+
+	// D-tor, cancels the stream if it was not consumed to the end
+	~AddressEntryStream();
+
+	// Wait for the next chunk, rethrows if the producer failed
+	AddressEntryStreamStatus Next(AddressEntries& outChunk);
+
+	// Take the next chunk if one is ready, rethrows if the producer failed
+	AddressEntryStreamStatus TryNext(AddressEntries& outChunk);
+
+	// Notify when chunks are ready or the stream ended, called from the producer thread
+	// one notification may cover several chunks, so take them with TryNext until it is pending
+	void SetReadyCallback(const std::function<void()>& callback);
+
+	// Stop producing and drop pending chunks
+	void Cancel();
+
+private:
+	std::shared_ptr<CAddressEntryStreamState> mpState;
+};
+#endif // ADDRESS_ENTRY_STREAM_H
\ No newline at end of file
@@ -4,6 +4,46 @@
 #include "AddressBookInterface.h"
 #include "CAddressBookManager.h"
 #include "CAddressBook.h"
+#include "CAddressEntryStreamState.h"
+#include "CThreadPool.h"
+
+//=======================================================
+//		StreamAsync : Produce entries on the stream executor into a new stream
+//=======================================================
+template <typename Producer>
+static AddressEntryStream StreamAsync(Producer&& producer, size_t chunkSize)
+{
+	auto pState = std::make_shared<CAddressEntryStreamState>(chunkSize);
+
+	// Producers only build the result and hand it over, the consumer reads it in chunks without holding a thread
+	CAddressBookManager::Get()->GetStreamExecutor()->Submit([pState, producer]()
+		{
+			// Consumer may have gone away before we were scheduled
+			if (pState->IsCancelled())
+			{
+				return;
+			}
+
+			try
+			{
+				if (pState->Write(producer()))
+				{
+					pState->Close();
+				}
+			}
+			catch (...)
+			{
+				pState->Fail(std::current_exception());
+			}
+		});
+
+	return AddressEntryStream(pState);
+}
+
+//=======================================================
+//		ForEachCancelled : Unwinds an iteration once cancelled
+//=======================================================
+struct ForEachCancelled {};
 
 namespace AddressBookInterface
 {
@@ -15,6 +55,22 @@ namespace AddressBookInterface
 		return CAddressBookManager::Get()->GetAddressBook()->AddEntry(entry);
 	}
 
+	//=======================================================
+	//		AddEntries : Add address entries to the address book at once
+	//=======================================================
+	AddressEntryError AddEntries(const AddressEntries& entries)
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->AddEntries(entries);
+	}
+
+	//=======================================================
+	//		SyncEntries : Make the address book hold exactly entries
+	//=======================================================
+	AddressEntryError SyncEntries(const AddressEntries& entries, AddressEntrySyncStats& outStats)
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->SyncEntries(entries, outStats);
+	}
+
 	//=======================================================
 	//		RemoveEntry : Remove an address entry from the address book
 	//					  if *match* is true, only entries that match exactly will be removed
@@ -40,6 +96,30 @@ namespace AddressBookInterface
 		return CAddressBookManager::Get()->GetAddressBook()->Search(searchKey, searchType);
 	}
 
+	//=======================================================
+	//		SearchRanked : Query for the highest scored addresses with specified search type
+	//=======================================================
+	AddressEntries SearchRanked(const std::string& searchKey, size_t count, AddressEntrySearchType searchType)
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->SearchRanked(searchKey, count, searchType);
+	}
+
+	//=======================================================
+	//		SetEntryScore : Set the score of an address entry for ranked searches
+	//=======================================================
+	AddressEntryError SetEntryScore(const AddressEntry& entry, uint64_t score)
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->SetEntryScore(entry, score);
+	}
+
+	//=======================================================
+	//		Query : Query for addresses matching a compound query
+	//=======================================================
+	AddressEntries Query(const AddressQuery& query)
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->Query(query);
+	}
+
 	//=======================================================
 	//		ForEach : Pass in function iteratively applied to each address entry in the book
 	//=======================================================
@@ -48,6 +128,23 @@ namespace AddressBookInterface
 		CAddressBookManager::Get()->GetAddressBook()->ForEach(callback);
 	}
 
+	//=======================================================
+	//		ParallelForEach : Pass in function applied to each address entry in the book,
+	//						  traversing the book on worker threads
+	//=======================================================
+	void ParallelForEach(const AddressEntryCallback& callback, AddressEntryTraversalType traversalType)
+	{
+		CAddressBookManager::Get()->GetAddressBook()->ParallelForEach(callback, traversalType);
+	}
+
+	//=======================================================
+	//		PinSnapshot : Pin the book's current version for long-running reads
+	//=======================================================
+	AddressBookSnapshot PinSnapshot()
+	{
+		return AddressBookSnapshot(CAddressBookManager::Get()->GetAddressBook()->PinVersion());
+	}
+
 	//=======================================================
 	//		Clear : Clear address book
 	//=======================================================
@@ -55,4 +152,238 @@ namespace AddressBookInterface
 	{
 		CAddressBookManager::Get()->GetAddressBook()->Reset();
 	}
-}
+
+	//=======================================================
+	//		SetSearchCacheBudget : Cache results of frequent searches within budget
+	//=======================================================
+	void SetSearchCacheBudget(size_t budgetBytes)
+	{
+		CAddressBookManager::Get()->GetAddressBook()->SetSearchCacheBudget(budgetBytes);
+	}
+
+	//=======================================================
+	//		GetSearchCacheStats : Get search cache hit/miss counters
+	//=======================================================
+	AddressSearchCacheStats GetSearchCacheStats()
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->GetSearchCacheStats();
+	}
+
+	//=======================================================
+	//		SetLookupFilter : Answer lookups of absent names from a counting Bloom filter without the lock
+	//=======================================================
+	AddressEntryError SetLookupFilter(size_t expectedEntries, double falsePositiveRate)
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->SetLookupFilter(expectedEntries, falsePositiveRate);
+	}
+
+	//=======================================================
+	//		GetLookupFilterStats : Get lookup filter counters
+	//=======================================================
+	AddressLookupFilterStats GetLookupFilterStats()
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->GetLookupFilterStats();
+	}
+
+	//=======================================================
+	//		GetMetrics : Snapshot of operation latencies, lock wait/hold times and trie sizes
+	//=======================================================
+	AddressBookMetrics GetMetrics()
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->GetMetrics();
+	}
+
+	//=======================================================
+	//		GetMemoryUsage : Count live and dead trie nodes
+	//=======================================================
+	AddressBookMemoryUsage GetMemoryUsage()
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->GetMemoryUsage();
+	}
+
+	//=======================================================
+	//		Compact : Rebuild tries in the background and swap them in
+	//=======================================================
+	std::future<AddressBookMemoryUsage> Compact()
+	{
+		return CAddressBookManager::Get()->GetExecutor()->Submit([]()
+			{
+				return CAddressBookManager::Get()->GetAddressBook()->Compact();
+			});
+	}
+
+	//=======================================================
+	//		SetSubstringIndexEnabled : Build or drop the substring index in the background
+	//=======================================================
+	std::future<void> SetSubstringIndexEnabled(bool enabled)
+	{
+		return CAddressBookManager::Get()->GetExecutor()->Submit([enabled]()
+			{
+				CAddressBookManager::Get()->GetAddressBook()->SetSubstringIndexEnabled(enabled);
+			});
+	}
+
+	//=======================================================
+	//		Freeze : Pack the book into read-only tries in the background
+	//=======================================================
+	std::future<AddressBookMemoryUsage> Freeze()
+	{
+		return CAddressBookManager::Get()->GetExecutor()->Submit([]()
+			{
+				return CAddressBookManager::Get()->GetAddressBook()->Freeze();
+			});
+	}
+
+	//=======================================================
+	//		Thaw : Convert a frozen book back into mutable tries in the background
+	//=======================================================
+	std::future<AddressBookMemoryUsage> Thaw()
+	{
+		return CAddressBookManager::Get()->GetExecutor()->Submit([]()
+			{
+				return CAddressBookManager::Get()->GetAddressBook()->Thaw();
+			});
+	}
+
+	//=======================================================
+	//		LoadFrozen : Replace every entry with those pulled from source, packed straight into a frozen book
+	//=======================================================
+	AddressEntryError LoadFrozen(const AddressEntrySource& source)
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->LoadFrozen(source);
+	}
+
+	//=======================================================
+	//		SetTieredStorage : Spill entries of books frozen from now on to a payload file
+	//=======================================================
+	AddressEntryError SetTieredStorage(const std::string& directory, size_t cacheBytes)
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->SetTieredStorage(directory, cacheBytes);
+	}
+
+	//=======================================================
+	//		GetTierStats : Page cache counters of a tiered frozen book
+	//=======================================================
+	AddressBookTierStats GetTierStats()
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->GetTierStats();
+	}
+
+	//=======================================================
+	//		SetChangeFeedCapacity : Keep latest changes in memory for followers
+	//=======================================================
+	void SetChangeFeedCapacity(size_t capacity)
+	{
+		CAddressBookManager::Get()->GetAddressBook()->SetChangeFeedCapacity(capacity);
+	}
+
+	//=======================================================
+	//		SetChangeLog : Append changes to a log file
+	//=======================================================
+	AddressEntryError SetChangeLog(const std::string& path)
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->SetChangeLog(path);
+	}
+
+	//=======================================================
+	//		GetChangeLogStatus : Check if a write to the change log failed
+	//=======================================================
+	AddressEntryError GetChangeLogStatus()
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->GetChangeLogStatus();
+	}
+
+	//=======================================================
+	//		ReadChanges : Changes published after a sequence
+	//=======================================================
+	AddressEntryError ReadChanges(uint64_t afterSequence,
+								  size_t maxCount,
+								  std::chrono::milliseconds timeout,
+								  AddressChanges& outChanges)
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->ReadChanges(afterSequence, maxCount, timeout, outChanges);
+	}
+
+	//=======================================================
+	//		RetrieveChangeSnapshot : Every entry and the sequence it was taken at
+	//=======================================================
+	AddressEntries RetrieveChangeSnapshot(uint64_t& outSequence)
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->RetrieveChangeSnapshot(outSequence);
+	}
+
+	//=======================================================
+	//		ApplyChanges : Apply changes read from a leader
+	//=======================================================
+	AddressEntryError ApplyChanges(const AddressChanges& changes)
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->ApplyChanges(changes);
+	}
+
+	//=======================================================
+	//		ApplyChangeSnapshot : Replace every entry with a leader's snapshot
+	//=======================================================
+	AddressEntryError ApplyChangeSnapshot(const AddressEntries& entries, uint64_t sequence)
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->ApplyChangeSnapshot(entries, sequence);
+	}
+
+	//=======================================================
+	//		GetAppliedSequence : Sequence of the last leader change applied
+	//=======================================================
+	uint64_t GetAppliedSequence()
+	{
+		return CAddressBookManager::Get()->GetAddressBook()->GetAppliedSequence();
+	}
+
+	//=======================================================
+	//		RetrieveEntriesAsync : Retrieve entries in specified order on the stream executor
+	//=======================================================
+	AddressEntryStream RetrieveEntriesAsync(AddressEntryOrderType orderType, size_t chunkSize)
+	{
+		return StreamAsync([orderType]()
+			{
+				return CAddressBookManager::Get()->GetAddressBook()->RetrieveEntries(orderType);
+			}, chunkSize);
+	}
+
+	//=======================================================
+	//		SearchAsync : Query for addresses with specified search type on the stream executor
+	//=======================================================
+	AddressEntryStream SearchAsync(const std::string& searchKey, AddressEntrySearchType searchType, size_t chunkSize)
+	{
+		return StreamAsync([searchKey, searchType]()
+			{
+				return CAddressBookManager::Get()->GetAddressBook()->Search(searchKey, searchType);
+			}, chunkSize);
+	}
+
+	//=======================================================
+	//		ForEachAsync : Apply function to each address entry on the stream executor
+	//=======================================================
+	std::future<void> ForEachAsync(const AddressEntryCallback& callback, AddressBookCancelFlag cancelFlag)
+	{
+		// Callbacks may be slow, so the sweep stays off the executor running maintenance
+		return CAddressBookManager::Get()->GetStreamExecutor()->Submit([callback, cancelFlag]()
+			{
+				try
+				{
+					// Callbacks may be slow, the snapshot keeps the book's lock out of the sweep
+					AddressBookSnapshot snapshot(CAddressBookManager::Get()->GetAddressBook()->PinVersion());
+					snapshot.ForEach([&callback, &cancelFlag](const AddressEntry& entry)
+						{
+							if (cancelFlag && cancelFlag->load())
+							{
+								throw ForEachCancelled();
+							}
+
+							callback(entry);
+						});
+				}
+				catch (const ForEachCancelled&)
+				{
+					// Cancellation is not an error
+				}
+			});
+	}
+}
\ No newline at end of file
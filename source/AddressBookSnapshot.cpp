@@ -0,0 +1,105 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookSnapshot.h"
+#include "CAddressBookVersion.h"
+
+// System
+#include <cctype>
+
+//=======================================================
+//		IsAlphaOnly : Check if string is alphabets only
+//=======================================================
+static bool IsAlphaOnly(const std::string& str)
+{
+	return std::find_if(str.cbegin(), str.cend(), [](const char& c) {return !isalpha(c); }) == str.cend();
+}
+
+//=======================================================
+//		AddressBookSnapshot
+//=======================================================
+AddressBookSnapshot::AddressBookSnapshot(std::shared_ptr<const CAddressBookVersion> pVersion) :
+	mpVersion(std::move(pVersion))
+{
+
+}
+
+//=======================================================
+//		GetVersion : Version of the book the snapshot shows
+//=======================================================
+uint64_t AddressBookSnapshot::GetVersion() const
+{
+	return mpVersion ? mpVersion->GetVersion() : 0;
+}
+
+//=======================================================
+//		GetEntryCount
+//=======================================================
+size_t AddressBookSnapshot::GetEntryCount() const
+{
+	return mpVersion ? mpVersion->GetBook().GetEntryCount() : 0;
+}
+
+//=======================================================
+//		RetrieveEntries : Retrieve entries in specified order
+//=======================================================
+AddressEntries AddressBookSnapshot::RetrieveEntries(AddressEntryOrderType orderType) const
+{
+	return mpVersion ? mpVersion->GetBook().RetrieveEntries(orderType) : AddressEntries();
+}
+
+//=======================================================
+//		Search : Query for addresses with specified search type
+//=======================================================
+AddressEntries AddressBookSnapshot::Search(const std::string& searchKey,
+										   AddressEntrySearchType searchType /* = AddressEntrySearchType::FirstAndLastNameSearch */) const
+{
+	// Same key rules as the book's searches
+	if (!mpVersion || !IsAlphaOnly(searchKey))
+	{
+		return AddressEntries();
+	}
+
+	return mpVersion->GetBook().Search(searchKey, searchType);
+}
+
+//=======================================================
+//		Query : Query for addresses matching a compound query
+//=======================================================
+AddressEntries AddressBookSnapshot::Query(const AddressQuery& query) const
+{
+	return mpVersion ? mpVersion->GetBook().Query(query) : AddressEntries();
+}
+
+//=======================================================
+//		ForEach : Apply function to each entry of the snapshot
+//=======================================================
+void AddressBookSnapshot::ForEach(const AddressEntryCallback& callback) const
+{
+	if (mpVersion)
+	{
+		mpVersion->GetBook().ForEach(callback);
+	}
+}
+
+//=======================================================
+//		Encode : Entries in specified order, encoded into the compressed block format
+//=======================================================
+std::string AddressBookSnapshot::Encode(AddressEntryOrderType orderType, size_t blockSize /* = kAddressEntryBlockSize */) const
+{
+	AddressEntryBlockWriter writer(orderType, blockSize);
+	if (mpVersion)
+	{
+		mpVersion->GetBook().ForEach(orderType, [&writer](const AddressEntry& entry) { writer.Append(entry); });
+	}
+
+	return writer.Finish();
+}
+
+//=======================================================
+//		Release : Unpin the version early
+//=======================================================
+void AddressBookSnapshot::Release()
+{
+	mpVersion.reset();
+}
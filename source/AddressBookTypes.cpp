@@ -28,4 +28,39 @@ std::istream& operator>>(std::istream& is, AddressEntry& addressEntry)
 	is >> addressEntry.mPhoneNumber;
 
 	return is;
+}
+
+//=======================================================
+//		Mean : Mean latency in nanoseconds
+//=======================================================
+double AddressBookLatencyHistogram::Mean() const
+{
+	return mCount == 0 ? 0.0 : static_cast<double>(mTotalNanoseconds) / mCount;
+}
+
+//=======================================================
+//		Percentile : Upper bound of the bucket holding the percentile sample
+//=======================================================
+uint64_t AddressBookLatencyHistogram::Percentile(double percentile) const
+{
+	if (mCount == 0)
+	{
+		return 0;
+	}
+
+	// Rank of the sample, 1-based
+	uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * mCount + 0.5);
+	rank = std::max<uint64_t>(1, std::min(rank, mCount));
+
+	uint64_t seen = 0;
+	for (uint32_t i = 0; i < kAddressBookLatencyBuckets; i++)
+	{
+		seen += mBuckets[i];
+		if (seen >= rank)
+		{
+			return std::min(mMaxNanoseconds, (uint64_t(2) << i) - 1);
+		}
+	}
+
+	return mMaxNanoseconds;
 }
\ No newline at end of file
@@ -0,0 +1,75 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressChangeLog.h"
+#include "CAddressChangeFeed.h"
+
+//=======================================================
+//		AddressChangeLogReader
+//=======================================================
+AddressChangeLogReader::AddressChangeLogReader() :
+	mBufferOffset(0)
+{
+
+}
+
+//=======================================================
+//		Open : Open the log at path, reading from its start
+//=======================================================
+AddressEntryError AddressChangeLogReader::Open(const std::string& path)
+{
+	if (mFile.is_open())
+	{
+		mFile.close();
+	}
+
+	mFile.clear();
+	mBuffer.clear();
+	mBufferOffset = 0;
+
+	mFile.open(path, std::ios::binary);
+	return mFile.is_open() ? AddressEntryError::kAddressEntrySuccess : AddressEntryError::kAddressEntryIOFailure;
+}
+
+//=======================================================
+//		Read : Changes appended since the last read
+//=======================================================
+AddressEntryError AddressChangeLogReader::Read(size_t maxCount, AddressChanges& outChanges)
+{
+	if (!mFile.is_open())
+	{
+		return AddressEntryError::kAddressEntryIOFailure;
+	}
+
+	for (size_t count = 0; count < maxCount;)
+	{
+		AddressChange change;
+		size_t consumed = CAddressChangeFeed::Decode(mBuffer.data() + mBufferOffset, mBuffer.size() - mBufferOffset, change);
+		if (consumed > 0)
+		{
+			mBufferOffset += consumed;
+			outChanges.push_back(std::move(change));
+			count++;
+			continue;
+		}
+
+		// Keep the partial record, then read whatever the writer appended since
+		mBuffer.erase(0, mBufferOffset);
+		mBufferOffset = 0;
+
+		size_t bufferSize = mBuffer.size();
+		mBuffer.resize(bufferSize + kAddressChangeLogReadSize);
+
+		// End of file is only where the writer currently is
+		mFile.clear();
+		mFile.read(&mBuffer[bufferSize], kAddressChangeLogReadSize);
+		mBuffer.resize(bufferSize + static_cast<size_t>(mFile.gcount()));
+
+		if (mBuffer.size() == bufferSize)
+		{
+			break;
+		}
+	}
+
+	return mFile.bad() ? AddressEntryError::kAddressEntryIOFailure : AddressEntryError::kAddressEntrySuccess;
+}
@@ -0,0 +1,399 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressEntryBlocks.h"
+
+//=======================================================
+//		Constants
+//=======================================================
+// Low bit of a phone number's length, set if its bytes are stored as they are rather than packed digits
+constexpr uint64_t kAddressEntryRawPhoneFlag = 1;
+
+// A 64-bit varint takes at most 10 bytes
+constexpr size_t kAddressEntryVarintBytesMax = 10;
+
+//=======================================================
+//		AppendLittleEndian : Append the low *bytes* bytes of value, least significant first
+//=======================================================
+static void AppendLittleEndian(uint64_t value, size_t bytes, std::string& outBuffer)
+{
+	for (size_t i = 0; i < bytes; i++)
+	{
+		outBuffer.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+	}
+}
+
+//=======================================================
+//		ReadLittleEndian : Read *bytes* bytes, least significant first
+//=======================================================
+static uint64_t ReadLittleEndian(const char* data, size_t bytes)
+{
+	uint64_t value = 0;
+	for (size_t i = 0; i < bytes; i++)
+	{
+		value |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << (8 * i);
+	}
+
+	return value;
+}
+
+//=======================================================
+//		WriteVarint : Write value 7 bits a byte, least significant first, high bit set on all but the last
+//		and move past it, room for kAddressEntryVarintBytesMax bytes must be left
+//=======================================================
+static void WriteVarint(uint64_t value, char*& out)
+{
+	while (value >= 0x80)
+	{
+		*out++ = static_cast<char>((value & 0x7f) | 0x80);
+		value >>= 7;
+	}
+
+	*out++ = static_cast<char>(value);
+}
+
+//=======================================================
+//		ReadVarint : Read a varint at data and move past it, false if it runs past end
+//=======================================================
+static bool ReadVarint(const char*& data, const char* end, uint64_t& outValue)
+{
+	outValue = 0;
+	for (size_t i = 0; i < kAddressEntryVarintBytesMax && data != end; i++)
+	{
+		uint8_t byte = static_cast<uint8_t>(*data++);
+		outValue |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+		if ((byte & 0x80) == 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//=======================================================
+//		IsDigitsOnly : Check if string is digits only
+//=======================================================
+static bool IsDigitsOnly(const std::string& str)
+{
+	return std::find_if(str.cbegin(), str.cend(), [](const char& c) {return c < '0' || c > '9'; }) == str.cend();
+}
+
+//=======================================================
+//		AddressEntryBlockWriter
+//=======================================================
+AddressEntryBlockWriter::AddressEntryBlockWriter(AddressEntryOrderType orderType, size_t blockSize /* = kAddressEntryBlockSize */) :
+	mOrderType(orderType),
+	mBlockSize(std::max<size_t>(1, std::min<size_t>(blockSize, UINT32_MAX))),
+	mCount(0)
+{
+	// Magic, entries per block, order type
+	AppendLittleEndian(kAddressEntryBlocksMagic, sizeof(uint32_t), mBuffer);
+	AppendLittleEndian(mBlockSize, sizeof(uint32_t), mBuffer);
+	AppendLittleEndian(static_cast<uint8_t>(mOrderType), sizeof(uint8_t), mBuffer);
+}
+
+//=======================================================
+//		Append : Append entry to the current block
+//		shared key bytes, rest of the key, leading name length and phone number length (varints),
+//		then the rest of the key and the phone number
+//=======================================================
+void AddressEntryBlockWriter::Append(const AddressEntry& entry)
+{
+	if (mCount % mBlockSize == 0)
+	{
+		// Every block starts with a whole key, so it decodes on its own
+		mBlockOffsets.push_back(mBuffer.size());
+		mPreviousKey.clear();
+	}
+
+	bool firstNameOrder = mOrderType == AddressEntryOrderType::FirstNameOrder;
+	const std::string& leadingName = firstNameOrder ? entry.mFirstName : entry.mLastName;
+	const std::string& trailingName = firstNameOrder ? entry.mLastName : entry.mFirstName;
+	mKey.assign(leadingName).append(trailingName);
+
+	size_t shared = 0;
+	size_t sharedMax = std::min(mKey.size(), mPreviousKey.size());
+	while (shared < sharedMax && mKey[shared] == mPreviousKey[shared])
+	{
+		shared++;
+	}
+
+	const std::string& phoneNumber = entry.mPhoneNumber;
+	bool packed = IsDigitsOnly(phoneNumber);
+
+	// Grow once for the longest the record can be, then write it through a pointer
+	size_t size = mBuffer.size();
+	mBuffer.resize(size + 4 * kAddressEntryVarintBytesMax + mKey.size() - shared + phoneNumber.size());
+	char* out = &mBuffer[size];
+
+	WriteVarint(shared, out);
+	WriteVarint(mKey.size() - shared, out);
+	WriteVarint(leadingName.size(), out);
+	WriteVarint((static_cast<uint64_t>(phoneNumber.size()) << 1) | (packed ? 0 : kAddressEntryRawPhoneFlag), out);
+	out = std::copy(mKey.cbegin() + shared, mKey.cend(), out);
+
+	if (!packed)
+	{
+		out = std::copy(phoneNumber.cbegin(), phoneNumber.cend(), out);
+	}
+	else
+	{
+		// Two digits a byte, high nibble first
+		for (size_t i = 0; i < phoneNumber.size(); i += 2)
+		{
+			uint8_t high = static_cast<uint8_t>(phoneNumber[i] - '0');
+			uint8_t low = (i + 1 < phoneNumber.size()) ? static_cast<uint8_t>(phoneNumber[i + 1] - '0') : 0;
+			*out++ = static_cast<char>((high << 4) | low);
+		}
+	}
+
+	mBuffer.resize(static_cast<size_t>(out - mBuffer.data()));
+	mKey.swap(mPreviousKey);
+	mCount++;
+}
+
+//=======================================================
+//		Finish : Append the index and move the encoded entries out
+//		block offsets (8 each), then index offset and entry count (8 each), little endian
+//=======================================================
+std::string AddressEntryBlockWriter::Finish()
+{
+	uint64_t indexOffset = mBuffer.size();
+	for (uint64_t offset : mBlockOffsets)
+	{
+		AppendLittleEndian(offset, sizeof(uint64_t), mBuffer);
+	}
+
+	AppendLittleEndian(indexOffset, sizeof(uint64_t), mBuffer);
+	AppendLittleEndian(mCount, sizeof(uint64_t), mBuffer);
+
+	std::string result(std::move(mBuffer));
+	*this = AddressEntryBlockWriter(mOrderType, mBlockSize);
+	return result;
+}
+
+//=======================================================
+//		GetCount : Entries appended since the writer started
+//=======================================================
+size_t AddressEntryBlockWriter::GetCount() const
+{
+	return static_cast<size_t>(mCount);
+}
+
+//=======================================================
+//		AddressEntryBlockReader
+//=======================================================
+AddressEntryBlockReader::AddressEntryBlockReader() :
+	mOrderType(AddressEntryOrderType::FirstNameOrder),
+	mBlockSize(1),
+	mCount(0),
+	mIndexOffset(0)
+{
+
+}
+
+//=======================================================
+//		Open : Take encoded entries and check their header and index
+//=======================================================
+AddressEntryError AddressEntryBlockReader::Open(std::string buffer)
+{
+	*this = AddressEntryBlockReader();
+	if (buffer.size() < kAddressEntryBlocksHeaderBytes + kAddressEntryBlocksFooterBytes ||
+		ReadLittleEndian(buffer.data(), sizeof(uint32_t)) != kAddressEntryBlocksMagic)
+	{
+		return AddressEntryError::kAddressEntryInvalid;
+	}
+
+	uint64_t blockSize = ReadLittleEndian(buffer.data() + sizeof(uint32_t), sizeof(uint32_t));
+	uint64_t orderType = ReadLittleEndian(buffer.data() + 2 * sizeof(uint32_t), sizeof(uint8_t));
+	if (blockSize == 0 || orderType > static_cast<uint64_t>(AddressEntryOrderType::LastNameOrder))
+	{
+		return AddressEntryError::kAddressEntryInvalid;
+	}
+
+	const char* footer = buffer.data() + buffer.size() - kAddressEntryBlocksFooterBytes;
+	uint64_t indexOffset = ReadLittleEndian(footer, sizeof(uint64_t));
+	uint64_t count = ReadLittleEndian(footer + sizeof(uint64_t), sizeof(uint64_t));
+
+	// The index fills the space between the blocks and the footer exactly
+	uint64_t indexBytesMax = buffer.size() - kAddressEntryBlocksHeaderBytes - kAddressEntryBlocksFooterBytes;
+	uint64_t blockCount = count / blockSize + (count % blockSize != 0 ? 1 : 0);
+	if (indexOffset < kAddressEntryBlocksHeaderBytes ||
+		blockCount > indexBytesMax / sizeof(uint64_t) ||
+		indexOffset + blockCount * sizeof(uint64_t) + kAddressEntryBlocksFooterBytes != buffer.size())
+	{
+		return AddressEntryError::kAddressEntryInvalid;
+	}
+
+	mBuffer = std::move(buffer);
+	mOrderType = static_cast<AddressEntryOrderType>(orderType);
+	mBlockSize = static_cast<size_t>(blockSize);
+	mCount = count;
+	mIndexOffset = indexOffset;
+	return AddressEntryError::kAddressEntrySuccess;
+}
+
+//=======================================================
+//		GetCount
+//=======================================================
+size_t AddressEntryBlockReader::GetCount() const
+{
+	return static_cast<size_t>(mCount);
+}
+
+//=======================================================
+//		GetBlockCount
+//=======================================================
+size_t AddressEntryBlockReader::GetBlockCount() const
+{
+	return static_cast<size_t>((mCount + mBlockSize - 1) / mBlockSize);
+}
+
+//=======================================================
+//		GetOrderType : Order the entries were encoded for
+//=======================================================
+AddressEntryOrderType AddressEntryBlockReader::GetOrderType() const
+{
+	return mOrderType;
+}
+
+//=======================================================
+//		ReadBlock : Append the entries of block
+//=======================================================
+AddressEntryError AddressEntryBlockReader::ReadBlock(size_t block, AddressEntries& outEntries) const
+{
+	if (block >= GetBlockCount())
+	{
+		return AddressEntryError::kAddressEntryNotFound;
+	}
+
+	return DecodeBlock(block, mBlockSize, [&outEntries](size_t, const AddressEntry& entry) { outEntries.push_back(entry); });
+}
+
+//=======================================================
+//		Read : Entry at index, decoding its block up to it
+//=======================================================
+AddressEntryError AddressEntryBlockReader::Read(size_t index, AddressEntry& outEntry) const
+{
+	if (index >= mCount)
+	{
+		return AddressEntryError::kAddressEntryNotFound;
+	}
+
+	size_t position = index % mBlockSize;
+	return DecodeBlock(index / mBlockSize, position + 1, [&outEntry, position](size_t current, const AddressEntry& entry)
+		{
+			if (current == position)
+			{
+				outEntry = entry;
+			}
+		});
+}
+
+//=======================================================
+//		ReadAll : Append every entry, in the order they were encoded
+//=======================================================
+AddressEntryError AddressEntryBlockReader::ReadAll(AddressEntries& outEntries) const
+{
+	return ForEach([&outEntries](const AddressEntry& entry) { outEntries.push_back(entry); });
+}
+
+//=======================================================
+//		ForEach : Apply function to each entry, in the order they were encoded
+//=======================================================
+AddressEntryError AddressEntryBlockReader::ForEach(const AddressEntryCallback& callback) const
+{
+	for (size_t block = 0; block < GetBlockCount(); block++)
+	{
+		AddressEntryError result = DecodeBlock(block, mBlockSize, [&callback](size_t, const AddressEntry& entry) { callback(entry); });
+		if (result != AddressEntryError::kAddressEntrySuccess)
+		{
+			return result;
+		}
+	}
+
+	return AddressEntryError::kAddressEntrySuccess;
+}
+
+//=======================================================
+//		DecodeBlock : Decode block up to entry *last* of it, passing each entry to callback
+//		the entry passed is reused for the next one, callbacks copy what they keep
+//=======================================================
+template <typename Callback>
+AddressEntryError AddressEntryBlockReader::DecodeBlock(size_t block, size_t last, Callback&& callback) const
+{
+	const char* index = mBuffer.data() + mIndexOffset;
+	uint64_t begin = ReadLittleEndian(index + block * sizeof(uint64_t), sizeof(uint64_t));
+	uint64_t end = (block + 1 < GetBlockCount()) ? ReadLittleEndian(index + (block + 1) * sizeof(uint64_t), sizeof(uint64_t)) : mIndexOffset;
+	if (begin < kAddressEntryBlocksHeaderBytes || begin > end || end > mIndexOffset)
+	{
+		return AddressEntryError::kAddressEntryInvalid;
+	}
+
+	const char* data = mBuffer.data() + begin;
+	const char* dataEnd = mBuffer.data() + end;
+	size_t count = std::min<uint64_t>(std::min(last, mBlockSize), mCount - block * mBlockSize);
+	bool firstNameOrder = mOrderType == AddressEntryOrderType::FirstNameOrder;
+
+	std::string key;
+	AddressEntry entry;
+	for (size_t i = 0; i < count; i++)
+	{
+		uint64_t shared;
+		uint64_t suffixSize;
+		uint64_t leadingSize;
+		uint64_t phoneTag;
+		if (!ReadVarint(data, dataEnd, shared) ||
+			!ReadVarint(data, dataEnd, suffixSize) ||
+			!ReadVarint(data, dataEnd, leadingSize) ||
+			!ReadVarint(data, dataEnd, phoneTag))
+		{
+			return AddressEntryError::kAddressEntryInvalid;
+		}
+
+		uint64_t phoneSize = phoneTag >> 1;
+		bool packed = (phoneTag & kAddressEntryRawPhoneFlag) == 0;
+		uint64_t phoneBytes = packed ? phoneSize / 2 + phoneSize % 2 : phoneSize;
+		uint64_t remaining = static_cast<uint64_t>(dataEnd - data);
+		if (shared > key.size() || suffixSize > remaining || phoneBytes > remaining - suffixSize || leadingSize > shared + suffixSize)
+		{
+			return AddressEntryError::kAddressEntryInvalid;
+		}
+
+		key.resize(static_cast<size_t>(shared));
+		key.append(data, static_cast<size_t>(suffixSize));
+		data += suffixSize;
+
+		std::string& leadingName = firstNameOrder ? entry.mFirstName : entry.mLastName;
+		std::string& trailingName = firstNameOrder ? entry.mLastName : entry.mFirstName;
+		leadingName.assign(key, 0, static_cast<size_t>(leadingSize));
+		trailingName.assign(key, static_cast<size_t>(leadingSize), std::string::npos);
+
+		if (!packed)
+		{
+			entry.mPhoneNumber.assign(data, static_cast<size_t>(phoneSize));
+		}
+		else
+		{
+			entry.mPhoneNumber.resize(static_cast<size_t>(phoneSize));
+			char* digits = &entry.mPhoneNumber[0];
+			for (size_t digit = 0; digit + 1 < phoneSize; digit += 2)
+			{
+				uint8_t byte = static_cast<uint8_t>(data[digit / 2]);
+				digits[digit] = static_cast<char>('0' + (byte >> 4));
+				digits[digit + 1] = static_cast<char>('0' + (byte & 0x0f));
+			}
+
+			if (phoneSize % 2 != 0)
+			{
+				digits[phoneSize - 1] = static_cast<char>('0' + (static_cast<uint8_t>(data[phoneSize / 2]) >> 4));
+			}
+		}
+
+		data += phoneBytes;
+		callback(i, entry);
+	}
+
+	return AddressEntryError::kAddressEntrySuccess;
+}
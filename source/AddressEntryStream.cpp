@@ -0,0 +1,87 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressEntryStream.h"
+#include "CAddressEntryStreamState.h"
+
+//=======================================================
+//		AddressEntryStream
+//=======================================================
+AddressEntryStream::AddressEntryStream(std::shared_ptr<CAddressEntryStreamState> pState) :
+	mpState(std::move(pState))
+{
+
+}
+
+AddressEntryStream::AddressEntryStream(AddressEntryStream&& other) noexcept :
+	mpState(std::move(other.mpState))
+{
+
+}
+
+AddressEntryStream& AddressEntryStream::operator=(AddressEntryStream&& other) noexcept
+{
+	if (this != &other)
+	{
+		Cancel();
+		mpState = std::move(other.mpState);
+	}
+
+	return *this;
+}
+
+//=======================================================
+//		~AddressEntryStream : Producer stops once the consumer is gone
+//=======================================================
+AddressEntryStream::~AddressEntryStream()
+{
+	Cancel();
+}
+
+//=======================================================
+//		Next : Wait for the next chunk
+//=======================================================
+AddressEntryStreamStatus AddressEntryStream::Next(AddressEntries& outChunk)
+{
+	if (!mpState)
+	{
+		return AddressEntryStreamStatus::kStreamCancelled;
+	}
+
+	return mpState->Read(outChunk, true);
+}
+
+//=======================================================
+//		TryNext : Take the next chunk if one is ready
+//=======================================================
+AddressEntryStreamStatus AddressEntryStream::TryNext(AddressEntries& outChunk)
+{
+	if (!mpState)
+	{
+		return AddressEntryStreamStatus::kStreamCancelled;
+	}
+
+	return mpState->Read(outChunk, false);
+}
+
+//=======================================================
+//		SetReadyCallback : Notify when a chunk is ready or the stream ended
+//=======================================================
+void AddressEntryStream::SetReadyCallback(const std::function<void()>& callback)
+{
+	if (mpState)
+	{
+		mpState->SetReadyCallback(callback);
+	}
+}
+
+//=======================================================
+//		Cancel : Stop producing and drop pending chunks
+//=======================================================
+void AddressEntryStream::Cancel()
+{
+	if (mpState)
+	{
+		mpState->Cancel();
+	}
+}
\ No newline at end of file
@@ -5,6 +5,7 @@
 
 // System
 #include <cctype>
+#include <filesystem>
 #include <signal.h>
 
 //=======================================================
@@ -27,6 +28,14 @@ static bool IsDigitOnly(const std::string& str)
     return std::find_if(str.cbegin(), str.cend(), [](const char& c) {return !isdigit(c); }) == str.cend();
 }
 
+//=======================================================
+//		IsValidEntry : Check if either first or last name is not empty, and phone number is valid
+//=======================================================
+static bool IsValidEntry(const AddressEntry& entry)
+{
+    return !(entry.mFirstName.empty() && entry.mLastName.empty()) && IsDigitOnly(entry.mPhoneNumber);
+}
+
 //=======================================================
 //		IsAlphaOnly : Check if string is alphabets only
 //=======================================================
@@ -36,162 +45,347 @@ static bool IsAlphaOnly(const std::string& str)
 }
 
 
+//=======================================================
+//		WaitForAll : Wait until every pending task is done
+//=======================================================
+template <typename Result>
+static void WaitForAll(std::vector<std::future<Result>>& results)
+{
+    for (auto& result : results)
+    {
+        if (result.valid())
+        {
+            result.wait();
+        }
+    }
+}
+
+//=======================================================
+//		FirstNameOrderEntries : Copy records' entries in the order of retrieving in first name order
+//=======================================================
+static AddressEntries FirstNameOrderEntries(const std::vector<const CAddressRecord*>& records)
+{
+    // Entries without a first name come first
+    using SortKey = std::pair<std::string, const CAddressRecord*>;
+
+    std::vector<SortKey> sortKeys;
+    sortKeys.reserve(records.size());
+    for (const CAddressRecord* record : records)
+    {
+        std::string sortKey(record->mEntry.mFirstName.empty() ? "0" : "1");
+        sortKey += record->mEntry.mFirstName + record->mEntry.mLastName;
+        LowerCaseString(sortKey);
+        sortKeys.emplace_back(std::move(sortKey), record);
+    }
+
+    std::sort(sortKeys.begin(), sortKeys.end(), [](const SortKey& lhs, const SortKey& rhs)
+        {
+            return lhs.first != rhs.first ? lhs.first < rhs.first : lhs.second->mId < rhs.second->mId;
+        });
+
+    AddressEntries result;
+    for (const SortKey& sortKey : sortKeys)
+    {
+        result.push_back(sortKey.second->mEntry);
+    }
+
+    return result;
+}
+
+//=======================================================
+//		StartsWithCaseInsensitive : Check if str starts with the lower case prefix, ignoring case
+//=======================================================
+static bool StartsWithCaseInsensitive(const std::string& str, const std::string& prefix)
+{
+    return str.size() >= prefix.size() &&
+           std::equal(prefix.cbegin(), prefix.cend(), str.cbegin(), [](const char& lhs, const char& rhs) { return lhs == tolower(rhs); });
+}
+
+//=======================================================
+//		MatchesQueryTerm : Check if entry's field starts with the term's lower case prefix
+//=======================================================
+static bool MatchesQueryTerm(const AddressEntry& entry, const AddressQueryTerm& term)
+{
+    switch (term.mField)
+    {
+    case AddressEntryField::FirstName:
+        return StartsWithCaseInsensitive(entry.mFirstName, term.mPrefix);
+    case AddressEntryField::LastName:
+        return StartsWithCaseInsensitive(entry.mLastName, term.mPrefix);
+    case AddressEntryField::PhoneNumber:
+        return entry.mPhoneNumber.compare(0, term.mPrefix.size(), term.mPrefix) == 0;
+    default:
+        return false;
+    }
+}
+
+//=======================================================
+//		IsInTrie : Check if entry belongs to the trie in slot
+//=======================================================
+static bool IsInTrie(const AddressEntry& entry, uint32_t slot)
+{
+    switch (slot)
+    {
+    case kFirstNameTrieSlot:
+        return !entry.mFirstName.empty();
+    case kLastNameTrieSlot:
+        return !entry.mLastName.empty();
+    case kNoFirstNameTrieSlot:
+        return entry.mFirstName.empty();
+    case kNoLastNameTrieSlot:
+        return !entry.mFirstName.empty() && entry.mLastName.empty();
+    default:
+        return false;
+    }
+}
+
+//=======================================================
+//		RebuildTrie : Refill trie with records given in alphabetical order,
+//                    their new positions are returned in the same order
+//=======================================================
+template <typename Trie>
+static void RebuildTrie(Trie& trie,
+                        const std::vector<CAddressRecordPtr>& records,
+                        std::vector<CAddressRecordHandle>& outHandles)
+{
+    trie.Clear();
+    outHandles.resize(records.size());
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        trie.Insert(records[i], outHandles[i]);
+    }
+}
+
 //====================================================================
-//		FirstNameAddressTrie
+//		CAddressBook
 //====================================================================
-FirstNameAddressTrie::FirstNameAddressTrie() :
-    CAddressTrie()
+CAddressBook::CAddressBook() :
+    mGeneration(0),
+    mNextRecordId(0),
+    mSyncPass(0),
+    mSubstringIndexEnabled(false),
+    mpFrozenBook(nullptr),
+    mAppliedSequence(0),
+    mpLookupFilter(nullptr)
 {
 
 }
 
 //====================================================================
-//		GetTrieKey : First name, then last name
+//		~CAddressBook
 //====================================================================
-std::string FirstNameAddressTrie::GetTrieKey(const AddressEntry& addressEntry) const
+CAddressBook::~CAddressBook()
 {
-    std::string key(addressEntry.mFirstName + addressEntry.mLastName);
-    LowerCaseString(key);
-    return key;
+    delete mpLookupFilter.load();
 }
 
 //====================================================================
-//		LastNameAddressTrie
+//		AddEntry : Add address entry
 //====================================================================
-LastNameAddressTrie::LastNameAddressTrie() :
-    CAddressTrie()
+AddressEntryError CAddressBook::AddEntry(const AddressEntry& entry)
 {
+    ADDRESS_BOOK_METRICS_SCOPE(mMetrics, AddressBookOperation::AddEntry);
+
+    CMetricsLockGuard lock(mMutex, mMetrics);
+    if (IsFrozen())
+    {
+        return AddressEntryError::kAddressEntryReadOnly;
+    }
 
+    return InsertAndPublish(&entry, &entry + 1);
 }
 
 //====================================================================
-//		GetTrieKey : Last name, then first name
+//		AddEntries : Add address entries at once, nothing is added if any entry is rejected
 //====================================================================
-std::string LastNameAddressTrie::GetTrieKey(const AddressEntry& addressEntry) const
+AddressEntryError CAddressBook::AddEntries(const AddressEntries& entries)
 {
-    std::string key(addressEntry.mLastName + addressEntry.mFirstName);
-    LowerCaseString(key);
-    return key;
+    ADDRESS_BOOK_METRICS_SCOPE(mMetrics, AddressBookOperation::AddEntry);
+    ADDRESS_BOOK_METRICS_ENTRIES(entries.size());
+
+    CMetricsLockGuard lock(mMutex, mMetrics);
+    if (IsFrozen())
+    {
+        return AddressEntryError::kAddressEntryReadOnly;
+    }
+
+    return InsertAndPublish(entries.cbegin(), entries.cend());
 }
 
 //====================================================================
-//		CAddressBook
+//		RemoveEntry : Remove address entry with option to remove only matching entries
 //====================================================================
-CAddressBook::CAddressBook()
+AddressEntryError CAddressBook::RemoveEntry(const AddressEntry& entry, bool removeMatchingOnly /* = true */)
 {
+    ADDRESS_BOOK_METRICS_SCOPE(mMetrics, AddressBookOperation::RemoveEntry);
+
+    if (!IsValidEntry(entry))
+    {
+        return AddressEntryError::kAddressEntryInvalid;
+    }
+
+    // Absent entries are answered by the lookup filter without the lock, a frozen book still reports ReadOnly
+    CAddressLookupFilterReader filterReader(mpLookupFilter, mLookupFilterReaders);
+    const CAddressLookupFilter* pLookupFilter = removeMatchingOnly ? filterReader.Pin() : nullptr;
+    if (pLookupFilter != nullptr && mpFrozenBook.load() == nullptr && !pLookupFilter->MayContain(entry))
+    {
+        return AddressEntryError::kAddressEntryNotFound;
+    }
+
+    CMetricsLockGuard lock(mMutex, mMetrics);
+    if (IsFrozen())
+    {
+        return AddressEntryError::kAddressEntryReadOnly;
+    }
 
+    AddressEntryError result = RemoveAndPublish(entry, removeMatchingOnly);
+    if (pLookupFilter != nullptr && result == AddressEntryError::kAddressEntryNotFound)
+    {
+        pLookupFilter->CountFalsePositive();
+    }
+
+    return result;
 }
 
 //====================================================================
-//		AddEntry : Add address entry
+//		SyncEntries : Make the book hold exactly entries, adding and removing only the difference at once
 //====================================================================
-AddressEntryError CAddressBook::AddEntry(const AddressEntry& entry)
+AddressEntryError CAddressBook::SyncEntries(const AddressEntries& entries, AddressEntrySyncStats& outStats)
 {
-    // Ensure either first or last name is not empty, and phone number is valid
-    if (entry.mFirstName.empty() && entry.mLastName.empty() || !IsDigitOnly(entry.mPhoneNumber))
+    outStats = AddressEntrySyncStats();
+    for (const auto& entry : entries)
     {
-        return AddressEntryError::kAddressEntryInvalid;
+        if (!IsValidEntry(entry))
+        {
+            return AddressEntryError::kAddressEntryInvalid;
+        }
     }
 
+    CMetricsLockGuard lock(mMutex, mMetrics);
+    if (IsFrozen())
     {
-        std::lock_guard<std::mutex> lock(mMutex);
-
-        AddressEntryError firstNameResult = AddressEntryError::kAddressEntryNotAttempted;
-        AddressEntryError lastNameResult = AddressEntryError::kAddressEntryNotAttempted;
+        return AddressEntryError::kAddressEntryReadOnly;
+    }
 
-        // Add to first name trie depending on entry
-        if (!entry.mFirstName.empty())
+    // Entries already in the book are marked with a single lookup each, the rest are added
+    const uint64_t syncPass = ++mSyncPass;
+    std::vector<const AddressEntry*> addedEntries;
+    for (const auto& entry : entries)
+    {
+        auto it = mRecordIndex.find(&entry);
+        if (it == mRecordIndex.end())
         {
-            firstNameResult = mFirstNameTrie.Insert(entry);
+            addedEntries.push_back(&entry);
         }
-        
-        // Return if we attempted and failed
-        if (firstNameResult != AddressEntryError::kAddressEntryNotAttempted && 
-            firstNameResult != AddressEntryError::kAddressEntrySuccess)
+        else if (it->second->mSyncPass != syncPass)
         {
-            return firstNameResult;
+            it->second->mSyncPass = syncPass;
+            outStats.mUnchanged++;
         }
+    }
 
-        // Add to last name trie depending on entry
-        if (!entry.mLastName.empty())
+    // Collected before preparing, prepared records are in the index too
+    std::vector<CAddressRecordPtr> removedRecords;
+    if (outStats.mUnchanged < mRecordIndex.size())
+    {
+        for (const auto& record : mRecordIndex)
         {
-            lastNameResult = mLastNameTrie.Insert(entry);
+            if (record.second->mSyncPass != syncPass)
+            {
+                removedRecords.push_back(record.second);
+            }
         }
 
-        // Return if we attempted and failed
-        if (lastNameResult != AddressEntryError::kAddressEntryNotAttempted &&
-            lastNameResult != AddressEntryError::kAddressEntrySuccess)
+        // Published in the order they were added
+        std::sort(removedRecords.begin(), removedRecords.end(),
+                  [](const CAddressRecordPtr& lhs, const CAddressRecordPtr& rhs) { return lhs->mId < rhs->mId; });
+    }
+
+    // Nothing is visible to readers until every addition is prepared and every change is built
+    std::vector<CPreparedRecord> prepared;
+    AddressChanges changes;
+    try
+    {
+        prepared.reserve(addedEntries.size());
+        for (const AddressEntry* pEntry : addedEntries)
         {
-            // If we attempted on inserting, check if we've also attempted on the other trie
-            if (firstNameResult == AddressEntryError::kAddressEntrySuccess)
+            prepared.emplace_back();
+            AddressEntryError result = PrepareRecord(*pEntry, prepared.back());
+
+            // Repeated entry of the new set, its first occurrence is added
+            if (result == AddressEntryError::kAddressEntryDuplicate)
             {
-                DebugBreak(); // this shouldn't happen
+                prepared.pop_back();
+            }
+            else if (result != AddressEntryError::kAddressEntrySuccess)
+            {
+                AbortRecords(prepared);
+                outStats = AddressEntrySyncStats();
+                return result;
+            }
+        }
 
-                // Remove if insertion succeeded
-                mFirstNameTrie.Remove(entry);
+        if (mChangeFeed.IsEnabled())
+        {
+            changes.reserve(prepared.size() + removedRecords.size());
+            for (const auto& record : prepared)
+            {
+                changes.push_back({ 0, AddressChangeType::Add, record.mpRecord->mEntry });
             }
 
-            return lastNameResult;
+            for (const auto& pRecord : removedRecords)
+            {
+                changes.push_back({ 0, AddressChangeType::Remove, pRecord->mEntry });
+            }
         }
+    }
+    catch (...)
+    {
+        AbortRecords(prepared);
+        throw;
+    }
 
+    outStats.mAdded = prepared.size();
+    outStats.mRemoved = removedRecords.size();
+    if (prepared.empty() && removedRecords.empty())
+    {
         return AddressEntryError::kAddressEntrySuccess;
     }
-}
 
-//====================================================================
-//		RemoveEntry : Remove address entry with option to remove only matching entries
-//====================================================================
-AddressEntryError CAddressBook::RemoveEntry(const AddressEntry& entry, bool removeMatchingOnly /* = true */)
-{
-    // Ensure either first or last name is not empty, and phone number is valid
-    if (entry.mFirstName.empty() && entry.mLastName.empty() || !IsDigitOnly(entry.mPhoneNumber))
+    // Swap in the difference under the same lock hold, additions first,
+    // since removals may release nodes prepared insertions sit on
+    mGeneration++;
+    for (auto& record : prepared)
     {
-        return AddressEntryError::kAddressEntryInvalid;
+        CommitRecord(record);
     }
 
+    for (const auto& pRecord : removedRecords)
     {
-        std::lock_guard<std::mutex> lock(mMutex);
-
-        AddressEntryError firstNameResult = AddressEntryError::kAddressEntryNotAttempted;
-        AddressEntryError lastNameResult = AddressEntryError::kAddressEntryNotAttempted;
-
-        // Remove from first name trie depending on entry
-        if (!entry.mFirstName.empty())
-        {
-            firstNameResult = mFirstNameTrie.Remove(entry, removeMatchingOnly);
-        }
+        RemoveRecord(pRecord);
+    }
 
-        // Return if we attempted and failed
-        if (firstNameResult != AddressEntryError::kAddressEntryNotAttempted &&
-            firstNameResult != AddressEntryError::kAddressEntrySuccess)
-        {
-            return firstNameResult;
-        }
+    mChangeFeed.Publish(changes);
 
-        // Remove from last name trie depending on entry
-        if (!entry.mLastName.empty())
+    try
+    {
+        for (const auto& pRecord : removedRecords)
         {
-            lastNameResult = mLastNameTrie.Remove(entry, removeMatchingOnly);
+            mSearchCache.Invalidate(pRecord->mEntry);
         }
 
-        // Return if we attempted and failed
-        if (lastNameResult != AddressEntryError::kAddressEntryNotAttempted &&
-            lastNameResult != AddressEntryError::kAddressEntrySuccess)
+        for (const auto& record : prepared)
         {
-            // If we attempted on removing, check if we've also attempted on the other trie
-            if (firstNameResult == AddressEntryError::kAddressEntrySuccess)
-            {
-                DebugBreak(); // this shouldn't happen
-
-                // Re-insert if removal succeeded
-                mFirstNameTrie.Insert(entry);
-            }
-
-            return lastNameResult;
+            mSearchCache.Invalidate(record.mpRecord->mEntry);
         }
-
-        return AddressEntryError::kAddressEntrySuccess;
     }
+    catch (...)
+    {
+        // Book is already synchronised, stale results must not outlive it
+        mSearchCache.Clear();
+    }
+
+    return AddressEntryError::kAddressEntrySuccess;
 }
 
 //====================================================================
@@ -199,7 +393,16 @@ AddressEntryError CAddressBook::RemoveEntry(const AddressEntry& entry, bool remo
 //====================================================================
 AddressEntries CAddressBook::RetrieveEntries(AddressEntryOrderType orderType) const
 {
-    std::lock_guard<std::mutex> lock(mMutex);
+    ADDRESS_BOOK_METRICS_SCOPE(mMetrics, AddressBookOperation::RetrieveEntries);
+
+    CAddressFrozenReader frozenReader(mpFrozenBook, mFrozenReaders);
+    std::optional<CMetricsLockGuard> lock;
+    if (const CAddressFrozenBook* pFrozenBook = BeginRead(frozenReader, lock))
+    {
+        AddressEntries result(pFrozenBook->RetrieveEntries(orderType));
+        ADDRESS_BOOK_METRICS_ENTRIES(result.size());
+        return result;
+    }
     
     // Populate result
     AddressEntries result;
@@ -208,24 +411,20 @@ AddressEntries CAddressBook::RetrieveEntries(AddressEntryOrderType orderType) co
     case AddressEntryOrderType::FirstNameOrder:
     {
         // Add all entries without a first name
-        result.splice(result.cend(), 
-                      mLastNameTrie.AlphabeticOrder([](const AddressEntry& entry) { return entry.mFirstName.empty(); }).second);
+        result.splice(result.cend(), mNoFirstNameTrie.AlphabeticOrder().second);
 
         // Add all entries with first name
-        result.splice(result.cend(),
-                      mFirstNameTrie.AlphabeticOrder().second);
+        result.splice(result.cend(), ParallelAlphabeticOrder(mFirstNameTrie));
 
         break;
     }
     case AddressEntryOrderType::LastNameOrder:
     {
         // Add all entries without a last name
-        result.splice(result.cend(),
-                      mFirstNameTrie.AlphabeticOrder([](const AddressEntry& entry) { return entry.mLastName.empty(); }).second);
+        result.splice(result.cend(), mNoLastNameTrie.AlphabeticOrder().second);
 
         // Add all entries with last name name
-        result.splice(result.cend(),
-                      mLastNameTrie.AlphabeticOrder().second);
+        result.splice(result.cend(), ParallelAlphabeticOrder(mLastNameTrie));
 
         break;
     }
@@ -234,6 +433,7 @@ AddressEntries CAddressBook::RetrieveEntries(AddressEntryOrderType orderType) co
         break;
     }
 
+    ADDRESS_BOOK_METRICS_ENTRIES(result.size());
     return result;
 }
 
@@ -243,77 +443,1815 @@ AddressEntries CAddressBook::RetrieveEntries(AddressEntryOrderType orderType) co
 AddressEntries CAddressBook::Search(const std::string& searchKey, 
                                     AddressEntrySearchType searchType /* = AddressEntrySearchType::FirstAndLastNameSearch */) const
 {
-    if (IsAlphaOnly(searchKey))
-    {
-        std::lock_guard<std::mutex> lock(mMutex);
+    ADDRESS_BOOK_METRICS_SCOPE(mMetrics, AddressBookOperation::Search);
 
-        switch (searchType)
-        {
-        case AddressEntrySearchType::FirstNameSearch:
+    // Names no entry starts with are answered by the lookup filter without the lock
+    CAddressLookupFilterReader filterReader(mpLookupFilter, mLookupFilterReaders);
+    const CAddressLookupFilter* pLookupFilter = filterReader.Pin();
+
+    AddressEntries result;
+    if (IsAlphaOnly(searchKey) && (pLookupFilter == nullptr || pLookupFilter->MayMatch(searchKey, searchType)))
+    {
+        CAddressFrozenReader frozenReader(mpFrozenBook, mFrozenReaders);
+        std::optional<CMetricsLockGuard> lock;
+        if (const CAddressFrozenBook* pFrozenBook = BeginRead(frozenReader, lock))
         {
-            return mFirstNameTrie.Search(searchKey).second;
+            result = pFrozenBook->Search(searchKey, searchType);
         }
-        case AddressEntrySearchType::LastNameSearch:
+        else if (!mSearchCache.IsEnabled())
         {
-            return mLastNameTrie.Search(searchKey).second;
+            result = SearchTries(searchKey, searchType);
         }
-
-        case AddressEntrySearchType::FirstAndLastNameSearch:
+        else
         {
-            AddressEntries result;
-            auto searchResult = mFirstNameTrie.Search(searchKey);
-            result.splice(result.cend(), searchResult.second);
+            // Tries are searched case insensitively, so are cached results
+            std::string key(searchKey);
+            LowerCaseString(key);
 
-            // Ensure there are no duplicates in output result
-            const auto& duplicateLookup = searchResult.first;
-            result.splice(result.cend(), mLastNameTrie.Search(searchKey, [duplicateLookup](const AddressEntry& entry)->bool
-                {
-                    return (duplicateLookup.find(&entry) == duplicateLookup.end());
-                }).second);
+            CAddressSearchCache::SearchResult cachedResult = mSearchCache.Find(searchType, key);
+            if (cachedResult == nullptr)
+            {
+                cachedResult = std::make_shared<const AddressEntries>(SearchTries(key, searchType));
+                mSearchCache.Insert(searchType, key, cachedResult);
+            }
 
-            return result;
+            result = *cachedResult;
         }
 
-        default:
-            DebugBreak();
-            break;
+        if (pLookupFilter != nullptr && result.empty() && CAddressLookupFilter::IsFiltered(searchKey, searchType))
+        {
+            pLookupFilter->CountFalsePositive();
         }
     }
 
+    ADDRESS_BOOK_METRICS_ENTRIES(result.size());
+    return result;
+}
+
+//====================================================================
+//		SearchTries : Search tries in desired search type, lock must be held
+//====================================================================
+AddressEntries CAddressBook::SearchTries(const std::string& searchKey,
+                                         AddressEntrySearchType searchType) const
+{
+    switch (searchType)
+    {
+    case AddressEntrySearchType::FirstNameSearch:
+    {
+        return mFirstNameTrie.Search(searchKey).second;
+    }
+    case AddressEntrySearchType::LastNameSearch:
+    {
+        return mLastNameTrie.Search(searchKey).second;
+    }
+
+    case AddressEntrySearchType::FirstAndLastNameSearch:
+    {
+        AddressEntries result;
+        auto searchResult = mFirstNameTrie.Search(searchKey);
+        result.splice(result.cend(), searchResult.second);
+
+        // Ensure there are no duplicates in output result
+        const auto& duplicateLookup = searchResult.first;
+        result.splice(result.cend(), mLastNameTrie.Search(searchKey, [duplicateLookup](const AddressEntry& entry)->bool
+            {
+                return (duplicateLookup.find(&entry) == duplicateLookup.end());
+            }).second);
+
+        return result;
+    }
+
+    case AddressEntrySearchType::SubstringSearch:
+    {
+        return SearchSubstring(searchKey);
+    }
+
+    default:
+        DebugBreak();
+        break;
+    }
+
     return AddressEntries();
 }
 
 //====================================================================
-//		ForEach : Process each entry in address book
+//		SearchSubstring : Entries whose first or last name contains key, lock must be held
 //====================================================================
-void CAddressBook::ForEach(const AddressEntryCallback& callback) const
+AddressEntries CAddressBook::SearchSubstring(const std::string& searchKey) const
 {
-    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<const CAddressRecord*> records;
+    CollectSubstringRecords(searchKey, records);
+
+    return FirstNameOrderEntries(records);
+}
+
+//====================================================================
+//		CollectSubstringRecords : Records whose first or last name contains key, lock must be held
+//====================================================================
+void CAddressBook::CollectSubstringRecords(const std::string& searchKey, std::vector<const CAddressRecord*>& outRecords) const
+{
+    std::string key(searchKey);
+    LowerCaseString(key);
+
+    if (mSubstringIndexEnabled)
+    {
+        mSubstringIndex.Search(key, outRecords);
+        return;
+    }
 
-    // Ensure each entry is call on exactly once
-    std::unordered_set<const AddressEntry*> duplicateLookup;
-    mFirstNameTrie.ForEach([&duplicateLookup, &callback](const AddressEntry& entry)
+    for (const auto& record : mRecordIndex)
+    {
+        if (CAddressSubstringIndex::Contains(*record.second, key))
         {
-            duplicateLookup.emplace(&entry);
-            callback(entry);
-        });
+            outRecords.push_back(record.second.get());
+        }
+    }
+}
+
+//====================================================================
+//		SearchRanked : Highest scored entries in desired search type
+//====================================================================
+AddressEntries CAddressBook::SearchRanked(const std::string& searchKey,
+                                          size_t count,
+                                          AddressEntrySearchType searchType /* = AddressEntrySearchType::FirstAndLastNameSearch */) const
+{
+    ADDRESS_BOOK_METRICS_SCOPE(mMetrics, AddressBookOperation::Search);
+
+    CAddressLookupFilterReader filterReader(mpLookupFilter, mLookupFilterReaders);
+    const CAddressLookupFilter* pLookupFilter = filterReader.Pin();
+
+    AddressEntries result;
+    if (IsAlphaOnly(searchKey) && (pLookupFilter == nullptr || pLookupFilter->MayMatch(searchKey, searchType)))
+    {
+        CAddressFrozenReader frozenReader(mpFrozenBook, mFrozenReaders);
+        std::optional<CMetricsLockGuard> lock;
+        if (const CAddressFrozenBook* pFrozenBook = BeginRead(frozenReader, lock))
+        {
+            result = pFrozenBook->SearchRanked(searchKey, count, searchType);
+        }
+        else
+        {
+            result = SearchRankedTries(searchKey, count, searchType);
+        }
 
-    mLastNameTrie.ForEach([&duplicateLookup, &callback](const AddressEntry& entry)
+        if (pLookupFilter != nullptr && result.empty() && count != 0 && CAddressLookupFilter::IsFiltered(searchKey, searchType))
         {
-            if (duplicateLookup.find(&entry) == duplicateLookup.end())
-            {
-                callback(entry);
-            }
-        });
+            pLookupFilter->CountFalsePositive();
+        }
+    }
+
+    ADDRESS_BOOK_METRICS_ENTRIES(result.size());
+    return result;
 }
 
 //====================================================================
-//	    Reset : Clear address book
+//		SearchRankedTries : Highest ranked records in desired search type, lock must be held
 //====================================================================
-void CAddressBook::Reset()
+AddressEntries CAddressBook::SearchRankedTries(const std::string& searchKey,
+                                               size_t count,
+                                               AddressEntrySearchType searchType) const
 {
-    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<const CAddressRecord*> records;
+    switch (searchType)
+    {
+    case AddressEntrySearchType::FirstNameSearch:
+    {
+        mFirstNameTrie.CollectTopRecords(searchKey, count, records);
+        break;
+    }
+    case AddressEntrySearchType::LastNameSearch:
+    {
+        mLastNameTrie.CollectTopRecords(searchKey, count, records);
+        break;
+    }
+    case AddressEntrySearchType::FirstAndLastNameSearch:
+    {
+        // Every record of the combined top is in the top of at least one trie
+        mFirstNameTrie.CollectTopRecords(searchKey, count, records);
+        mLastNameTrie.CollectTopRecords(searchKey, count, records);
 
-    mFirstNameTrie.Clear();
-    mLastNameTrie.Clear();
+        std::sort(records.begin(), records.end(), CAddressRecordRank());
+        records.erase(std::unique(records.begin(), records.end()), records.end());
+        break;
+    }
+    case AddressEntrySearchType::SubstringSearch:
+    {
+        CollectSubstringRecords(searchKey, records);
+
+        size_t ranked = std::min(count, records.size());
+        std::partial_sort(records.begin(), records.begin() + ranked, records.end(), CAddressRecordRank());
+        break;
+    }
+    default:
+        DebugBreak();
+        break;
+    }
+
+    AddressEntries result;
+    for (size_t i = 0; i < records.size() && i < count; i++)
+    {
+        result.push_back(records[i]->mEntry);
+    }
+
+    return result;
+}
+
+//====================================================================
+//		SetEntryScore : Set the score ranked searches order an entry by
+//====================================================================
+AddressEntryError CAddressBook::SetEntryScore(const AddressEntry& entry, uint64_t score)
+{
+    if (!IsValidEntry(entry))
+    {
+        return AddressEntryError::kAddressEntryInvalid;
+    }
+
+    CMetricsLockGuard lock(mMutex, mMetrics);
+    if (IsFrozen())
+    {
+        return AddressEntryError::kAddressEntryReadOnly;
+    }
+
+    auto it = mRecordIndex.find(&entry);
+    if (it == mRecordIndex.end())
+    {
+        return AddressEntryError::kAddressEntryNotFound;
+    }
+
+    // Off-lock rebuilds copying scores start over
+    mGeneration++;
+
+    const CAddressRecordPtr& pRecord = it->second;
+    pRecord->mScore.store(score, std::memory_order_relaxed);
+
+    // Only rankings along the record's keys are stale, the tries are otherwise untouched
+    ForEachTrie([&pRecord](auto slot, auto& trie)
+        {
+            if (IsInTrie(pRecord->mEntry, slot))
+            {
+                trie.InvalidateRanking(pRecord->mEntry);
+            }
+        });
+
+    return AddressEntryError::kAddressEntrySuccess;
+}
+
+//====================================================================
+//		Query : Entries matching a compound query, in first name order
+//====================================================================
+AddressEntries CAddressBook::Query(const AddressQuery& query) const
+{
+    ADDRESS_BOOK_METRICS_SCOPE(mMetrics, AddressBookOperation::Search);
+
+    CAddressFrozenReader frozenReader(mpFrozenBook, mFrozenReaders);
+    std::optional<CMetricsLockGuard> lock;
+    if (const CAddressFrozenBook* pFrozenBook = BeginRead(frozenReader, lock))
+    {
+        AddressEntries result(pFrozenBook->Query(query));
+        ADDRESS_BOOK_METRICS_ENTRIES(result.size());
+        return result;
+    }
+
+    CAddressRecordStream result;
+    switch (query.mOperator)
+    {
+    case AddressQueryOperator::And:
+    {
+        if (query.mTerms.empty())
+        {
+            break;
+        }
+
+        // Count every term up to a limit doubled until one of them is counted in full,
+        // so finding the smallest term costs about as much as collecting it
+        const AddressQueryTerm* pSmallestTerm = nullptr;
+        for (size_t limit = kAddressBookQueryCountMin; pSmallestTerm == nullptr; limit *= 2)
+        {
+            size_t smallestCount = limit;
+            for (const auto& term : query.mTerms)
+            {
+                size_t count = CountQueryTerm(term, limit);
+
+                // Nothing can match every term
+                if (count == 0)
+                {
+                    return AddressEntries();
+                }
+
+                if (count < smallestCount)
+                {
+                    smallestCount = count;
+                    pSmallestTerm = &term;
+                }
+            }
+        }
+
+        // Only the smallest term is collected, its records are tested against the other terms
+        std::vector<AddressQueryTerm> otherTerms;
+        for (const auto& term : query.mTerms)
+        {
+            if (&term != pSmallestTerm)
+            {
+                otherTerms.push_back(term);
+                LowerCaseString(otherTerms.back().mPrefix);
+            }
+        }
+
+        QueryTerm(*pSmallestTerm, result);
+        result.erase(std::remove_if(result.begin(), result.end(), [&otherTerms](const CAddressRecord* record)
+            {
+                return !std::all_of(otherTerms.cbegin(), otherTerms.cend(), [record](const AddressQueryTerm& term) { return MatchesQueryTerm(record->mEntry, term); });
+            }), result.end());
+
+        break;
+    }
+    case AddressQueryOperator::Or:
+    {
+        for (const auto& term : query.mTerms)
+        {
+            CAddressRecordStream stream;
+            QueryTerm(term, stream);
+
+            CAddressRecordStream unionStream;
+            UniteRecordStreams(result, stream, unionStream);
+            result.swap(unionStream);
+        }
+
+        break;
+    }
+    default:
+        DebugBreak();
+        break;
+    }
+
+    ADDRESS_BOOK_METRICS_ENTRIES(result.size());
+    return FirstNameOrderEntries(result);
+}
+
+//====================================================================
+//		CountQueryTerm : Records a query term may match, counted up to limit, lock must be held
+//		name tries join both names, so their counts include keys matching across the boundary
+//====================================================================
+size_t CAddressBook::CountQueryTerm(const AddressQueryTerm& term, size_t limit) const
+{
+    switch (term.mField)
+    {
+    case AddressEntryField::FirstName:
+    case AddressEntryField::LastName:
+    {
+        if (!IsAlphaOnly(term.mPrefix))
+        {
+            return 0;
+        }
+
+        // Every entry matches an empty prefix, including those missing the name
+        if (term.mPrefix.empty())
+        {
+            return std::min(mRecordIndex.size(), limit);
+        }
+
+        std::string prefix(term.mPrefix);
+        LowerCaseString(prefix);
+
+        return term.mField == AddressEntryField::FirstName ? mFirstNameTrie.CountRecords(prefix, limit)
+                                                           : mLastNameTrie.CountRecords(prefix, limit);
+    }
+    case AddressEntryField::PhoneNumber:
+    {
+        if (!IsDigitOnly(term.mPrefix))
+        {
+            return 0;
+        }
+
+        size_t count = 0;
+        for (auto it = mPhoneIndex.lower_bound(term.mPrefix);
+             count < limit && it != mPhoneIndex.end() && it->first.compare(0, term.mPrefix.size(), term.mPrefix) == 0;
+             ++it)
+        {
+            count++;
+        }
+
+        return count;
+    }
+    default:
+        DebugBreak();
+        return 0;
+    }
+}
+
+//====================================================================
+//		QueryTerm : Records matching a query term as a stream, lock must be held
+//====================================================================
+void CAddressBook::QueryTerm(const AddressQueryTerm& term, CAddressRecordStream& outStream) const
+{
+    switch (term.mField)
+    {
+    case AddressEntryField::FirstName:
+    case AddressEntryField::LastName:
+    {
+        if (!IsAlphaOnly(term.mPrefix))
+        {
+            return;
+        }
+
+        bool firstName = term.mField == AddressEntryField::FirstName;
+
+        // Every entry matches an empty prefix, including those missing the name
+        if (term.mPrefix.empty())
+        {
+            outStream.reserve(mRecordIndex.size());
+            for (const auto& record : mRecordIndex)
+            {
+                outStream.push_back(record.second.get());
+            }
+
+            break;
+        }
+
+        std::string prefix(term.mPrefix);
+        LowerCaseString(prefix);
+
+        // Trie keys join both names, so keys may start with the prefix across the boundary
+        if (firstName)
+        {
+            mFirstNameTrie.CollectRecords(prefix, outStream);
+        }
+        else
+        {
+            mLastNameTrie.CollectRecords(prefix, outStream);
+        }
+
+        outStream.erase(std::remove_if(outStream.begin(), outStream.end(), [&prefix, firstName](const CAddressRecord* record)
+            {
+                return !StartsWithCaseInsensitive(firstName ? record->mEntry.mFirstName : record->mEntry.mLastName, prefix);
+            }), outStream.end());
+
+        break;
+    }
+    case AddressEntryField::PhoneNumber:
+    {
+        if (!IsDigitOnly(term.mPrefix))
+        {
+            return;
+        }
+
+        // Phone numbers starting with the prefix are one contiguous range
+        for (auto it = mPhoneIndex.lower_bound(term.mPrefix);
+             it != mPhoneIndex.end() && it->first.compare(0, term.mPrefix.size(), term.mPrefix) == 0;
+             ++it)
+        {
+            outStream.push_back(it->second);
+        }
+
+        break;
+    }
+    default:
+        DebugBreak();
+        return;
+    }
+
+    SortRecordStream(outStream);
+}
+
+//====================================================================
+//		ForEach : Process each entry in address book
+//====================================================================
+void CAddressBook::ForEach(const AddressEntryCallback& callback) const
+{
+    ADDRESS_BOOK_METRICS_SCOPE(mMetrics, AddressBookOperation::ForEach);
+    CCallbackTimer timedCallback(mMetrics, callback);
+
+    CAddressFrozenReader frozenReader(mpFrozenBook, mFrozenReaders);
+    std::optional<CMetricsLockGuard> lock;
+    if (const CAddressFrozenBook* pFrozenBook = BeginRead(frozenReader, lock))
+    {
+        pFrozenBook->ForEach(timedCallback.Get());
+        return;
+    }
+
+    // Every entry with a first name is in the first name trie
+    mFirstNameTrie.ForEach(timedCallback.Get());
+
+    // Remaining entries are kept in the side index
+    mNoFirstNameTrie.ForEach(timedCallback.Get());
+}
+
+//====================================================================
+//		ParallelForEach : Process each entry in address book on worker threads
+//====================================================================
+void CAddressBook::ParallelForEach(const AddressEntryCallback& callback,
+                                   AddressEntryTraversalType traversalType /* = AddressEntryTraversalType::Unordered */) const
+{
+    ADDRESS_BOOK_METRICS_SCOPE(mMetrics, AddressBookOperation::ForEach);
+    CCallbackTimer timedCallback(mMetrics, callback);
+
+    CAddressFrozenReader frozenReader(mpFrozenBook, mFrozenReaders);
+    std::optional<CMetricsLockGuard> lock;
+    const CAddressFrozenBook* pFrozenBook = BeginRead(frozenReader, lock);
+
+    CThreadPool& threadPool = GetThreadPool();
+
+    // Same split as ForEach, so each entry is visited exactly once
+    using Job = std::function<void(const AddressEntryCallback&)>;
+
+    std::vector<Job> jobs;
+    if (pFrozenBook != nullptr)
+    {
+        // Frozen entries are already in ForEach order, split into even runs
+        size_t entryCount = pFrozenBook->GetEntryCount();
+        size_t jobCount = std::max<size_t>(1, std::min<size_t>(entryCount / kAddressBookParallelRetrieveMin, CAddressNameAlphabet::kSize * threadPool.GetThreadCount()));
+
+        for (size_t i = 0; i < jobCount; i++)
+        {
+            size_t begin = entryCount * i / jobCount;
+            size_t end = entryCount * (i + 1) / jobCount;
+            jobs.push_back([pFrozenBook, begin, end](const AddressEntryCallback& jobCallback) { pFrozenBook->ForEach(begin, end, jobCallback); });
+        }
+    }
+    else
+    {
+        auto addTrieJobs = [&jobs](const auto& trie)
+            {
+                for (const auto& partition : trie.Partition())
+                {
+                    jobs.push_back([&trie, partition](const AddressEntryCallback& jobCallback) { trie.ForEach(partition, jobCallback); });
+                }
+            };
+
+        addTrieJobs(mFirstNameTrie);
+        addTrieJobs(mNoFirstNameTrie);
+    }
+
+    switch (traversalType)
+    {
+    case AddressEntryTraversalType::Unordered:
+    {
+        std::vector<std::future<void>> results;
+        results.reserve(jobs.size());
+
+        for (const Job& job : jobs)
+        {
+            results.push_back(threadPool.Submit([&timedCallback, job]()
+                {
+                    job(timedCallback.Get());
+                }));
+        }
+
+        // Workers must be done with the tries before the lock is released
+        WaitForAll(results);
+        for (auto& result : results)
+        {
+            result.get();
+        }
+
+        break;
+    }
+    case AddressEntryTraversalType::Ordered:
+    {
+        // Entries of a tiered book are decoded into a scratch entry per job, so buffer copies of them
+        struct EntryBuffer
+        {
+            std::vector<const AddressEntry*> mEntries;
+            std::deque<AddressEntry> mCopies;
+        };
+
+        bool copyEntries = (pFrozenBook != nullptr) && pFrozenBook->IsTiered();
+
+        std::vector<std::future<EntryBuffer>> results;
+        results.reserve(jobs.size());
+
+        for (const Job& job : jobs)
+        {
+            results.push_back(threadPool.Submit([job, copyEntries]()
+                {
+                    EntryBuffer buffer;
+                    job([&buffer, copyEntries](const AddressEntry& entry)
+                        {
+                            if (copyEntries)
+                            {
+                                buffer.mCopies.push_back(entry);
+                                buffer.mEntries.push_back(&buffer.mCopies.back());
+                                return;
+                            }
+
+                            buffer.mEntries.push_back(&entry);
+                        });
+
+                    return buffer;
+                }));
+        }
+
+        // Partitions are consumed in order while later ones are still being traversed
+        try
+        {
+            for (auto& result : results)
+            {
+                EntryBuffer buffer = result.get();
+                for (const AddressEntry* entry : buffer.mEntries)
+                {
+                    timedCallback.Get()(*entry);
+                }
+            }
+        }
+        catch (...)
+        {
+            WaitForAll(results);
+            throw;
+        }
+
+        break;
+    }
+    default:
+        DebugBreak();
+        break;
+    }
+}
+
+//====================================================================
+//		PinVersion : Read-only copy of the book at its current version
+//====================================================================
+std::shared_ptr<const CAddressBookVersion> CAddressBook::PinVersion() const
+{
+    std::vector<CAddressRecordPtr> records;
+    uint64_t version = 0;
+
+    {
+        CMetricsLockGuard lock(mMutex, mMetrics);
+        version = mGeneration;
+
+        if (std::shared_ptr<const CAddressBookVersion> pLatestVersion = mpLatestVersion.lock())
+        {
+            if (pLatestVersion->GetVersion() == version)
+            {
+                return pLatestVersion;
+            }
+        }
+
+        if (mpFrozenBookOwner)
+        {
+            // The frozen book never changes, so the version shares it instead of copying its entries
+            auto pVersion = std::make_shared<const CAddressBookVersion>(version, mpFrozenBookOwner);
+            mpLatestVersion = pVersion;
+            return pVersion;
+        }
+
+        // Entries never change once added, so shared records are safe to read without the lock
+        records.reserve(mRecordIndex.size());
+        for (const auto& record : mRecordIndex)
+        {
+            records.push_back(record.second);
+        }
+    }
+
+    // Writers commit newer versions while this one is packed
+    auto pVersion = std::make_shared<const CAddressBookVersion>(version, records);
+
+    // Records removed since are freed here if nothing else holds them
+    records.clear();
+
+    {
+        CMetricsLockGuard lock(mMutex, mMetrics);
+        std::shared_ptr<const CAddressBookVersion> pLatestVersion = mpLatestVersion.lock();
+        if (!pLatestVersion || pLatestVersion->GetVersion() < version)
+        {
+            mpLatestVersion = pVersion;
+        }
+    }
+
+    return pVersion;
+}
+
+//====================================================================
+//	    Reset : Clear address book
+//====================================================================
+void CAddressBook::Reset()
+{
+    ADDRESS_BOOK_METRICS_SCOPE(mMetrics, AddressBookOperation::Clear);
+
+    std::shared_ptr<const CAddressFrozenBook> pFrozenBook;
+    {
+        CMetricsLockGuard lock(mMutex, mMetrics);
+
+        // Clearing a frozen book leaves it empty and mutable
+        pFrozenBook = DetachFrozenBook();
+
+        ClearAndPublish();
+    }
+
+    // Readers that pinned the book may be waiting for the lock, so they are waited for outside it
+    if (pFrozenBook)
+    {
+        mFrozenReaders.Synchronise();
+    }
+}
+
+//====================================================================
+//	    SetSearchCacheBudget : Set search cache memory budget, zero disables the cache
+//====================================================================
+void CAddressBook::SetSearchCacheBudget(size_t budgetBytes)
+{
+    CMetricsLockGuard lock(mMutex, mMetrics);
+
+    mSearchCache.SetBudget(budgetBytes);
+    if (!mSearchCache.IsEnabled())
+    {
+        mSearchCache.Clear();
+    }
+}
+
+//====================================================================
+//	    GetSearchCacheStats : Get search cache counters
+//====================================================================
+AddressSearchCacheStats CAddressBook::GetSearchCacheStats() const
+{
+    CMetricsLockGuard lock(mMutex, mMetrics);
+    return mSearchCache.GetStats();
+}
+
+//====================================================================
+//	    GetMetrics : Snapshot of instrumentation counters and trie sizes
+//====================================================================
+AddressBookMetrics CAddressBook::GetMetrics() const
+{
+    AddressBookMetrics metrics;
+    mMetrics.Snapshot(metrics);
+
+    // Not taken through the instrumented lock, so snapshots do not show up in lock metrics
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (IsFrozen())
+    {
+        mpFrozenBook.load()->GetMetrics(metrics);
+        return metrics;
+    }
+
+    metrics.mFirstNameTrie = mFirstNameTrie.GetMetrics();
+    metrics.mLastNameTrie = mLastNameTrie.GetMetrics();
+    metrics.mNoFirstNameTrie = mNoFirstNameTrie.GetMetrics();
+    metrics.mNoLastNameTrie = mNoLastNameTrie.GetMetrics();
+
+    return metrics;
+}
+
+//====================================================================
+//	    GetMemoryUsage : Count live and dead trie nodes
+//====================================================================
+AddressBookMemoryUsage CAddressBook::GetMemoryUsage() const
+{
+    CMetricsLockGuard lock(mMutex, mMetrics);
+    if (IsFrozen())
+    {
+        return mpFrozenBook.load()->GetMemoryUsage();
+    }
+
+    AddressBookMemoryUsage usage;
+    mFirstNameTrie.GetMemoryUsage(usage);
+    mLastNameTrie.GetMemoryUsage(usage);
+    mNoFirstNameTrie.GetMemoryUsage(usage);
+    mNoLastNameTrie.GetMemoryUsage(usage);
+
+    return usage;
+}
+
+//====================================================================
+//	    Compact : Rebuild tries outside the lock and swap them in
+//====================================================================
+AddressBookMemoryUsage CAddressBook::Compact()
+{
+    CAddressBookTries compactedTries;
+
+    for (uint32_t attempt = 1; attempt <= kAddressBookCompactAttempts; attempt++)
+    {
+        std::array<std::vector<CAddressRecordPtr>, kAddressBookTrieCount> records;
+        std::array<std::vector<CAddressRecordHandle>, kAddressBookTrieCount> handles;
+
+        // Writers kept getting in first, rebuild while holding the lock
+        if (attempt == kAddressBookCompactAttempts)
+        {
+            CMetricsLockGuard lock(mMutex, mMetrics);
+            mGeneration++;
+
+            ForEachTrie([&](auto slot, auto& trie)
+                {
+                    auto& compactedTrie = std::get<slot>(compactedTries);
+
+                    trie.CollectRecords(records[slot]);
+                    RebuildTrie(compactedTrie, records[slot], handles[slot]);
+                    trie.Swap(compactedTrie);
+
+                    for (size_t j = 0; j < records[slot].size(); j++)
+                    {
+                        records[slot][j]->mHandles[slot] = handles[slot][j];
+                    }
+                });
+
+            break;
+        }
+
+        // Entries never change once added, so shared records are safe to read without the lock
+        uint64_t generation = 0;
+        {
+            CMetricsLockGuard lock(mMutex, mMetrics);
+            generation = mGeneration;
+
+            ForEachTrie([&records](auto slot, auto& trie) { trie.CollectRecords(records[slot]); });
+        }
+
+        ForEachTrie([&](auto slot, auto&)
+            {
+                RebuildTrie(std::get<slot>(compactedTries), records[slot], handles[slot]);
+            });
+
+        {
+            CMetricsLockGuard lock(mMutex, mMetrics);
+
+            // Only swap in if no write happened meanwhile
+            if (generation == mGeneration)
+            {
+                mGeneration++;
+                ForEachTrie([&](auto slot, auto& trie)
+                    {
+                        trie.Swap(std::get<slot>(compactedTries));
+
+                        // Handles now point into the compacted tries
+                        for (size_t j = 0; j < records[slot].size(); j++)
+                        {
+                            records[slot][j]->mHandles[slot] = handles[slot][j];
+                        }
+                    });
+
+                break;
+            }
+        }
+    }
+
+    // Previous tries are now held by the locals, and freed outside the lock
+    return GetMemoryUsage();
+}
+
+//====================================================================
+//	    SetSubstringIndexEnabled : Build or drop the substring index
+//====================================================================
+void CAddressBook::SetSubstringIndexEnabled(bool enabled)
+{
+    CAddressSubstringIndex substringIndex;
+
+    if (!enabled)
+    {
+        CMetricsLockGuard lock(mMutex, mMetrics);
+        mSubstringIndexEnabled = false;
+
+        // Freed outside the lock
+        mSubstringIndex.Swap(substringIndex);
+        return;
+    }
+
+    for (uint32_t attempt = 1; attempt <= kAddressBookCompactAttempts; attempt++)
+    {
+        std::vector<CAddressRecordPtr> records;
+        uint64_t generation = 0;
+
+        {
+            CMetricsLockGuard lock(mMutex, mMetrics);
+            if (mSubstringIndexEnabled)
+            {
+                return;
+            }
+
+            generation = mGeneration;
+            records.reserve(mRecordIndex.size());
+            for (const auto& record : mRecordIndex)
+            {
+                records.push_back(record.second);
+            }
+
+            // Writers kept getting in first, build while holding the lock
+            if (attempt == kAddressBookCompactAttempts)
+            {
+                std::sort(records.begin(), records.end(), [](const CAddressRecordPtr& lhs, const CAddressRecordPtr& rhs) { return lhs->mId < rhs->mId; });
+                for (const auto& record : records)
+                {
+                    mSubstringIndex.Insert(record);
+                }
+
+                mSubstringIndexEnabled = true;
+                return;
+            }
+        }
+
+        // Posting lists are kept in id order
+        std::sort(records.begin(), records.end(), [](const CAddressRecordPtr& lhs, const CAddressRecordPtr& rhs) { return lhs->mId < rhs->mId; });
+
+        substringIndex.Clear();
+        for (const auto& record : records)
+        {
+            substringIndex.Insert(record);
+        }
+
+        {
+            CMetricsLockGuard lock(mMutex, mMetrics);
+
+            // Only swap in if no write happened meanwhile
+            if (generation == mGeneration)
+            {
+                mSubstringIndex.Swap(substringIndex);
+                mSubstringIndexEnabled = true;
+                return;
+            }
+        }
+    }
+}
+
+//====================================================================
+//	    Freeze : Pack entries into read-only tries outside the lock and publish them
+//====================================================================
+AddressBookMemoryUsage CAddressBook::Freeze()
+{
+    for (uint32_t attempt = 1; attempt <= kAddressBookCompactAttempts; attempt++)
+    {
+        std::unique_ptr<CAddressFrozenBook> pFrozenBook;
+        std::vector<CAddressRecordPtr> records;
+        CAddressTierOptions tierOptions;
+        uint64_t generation = 0;
+
+        // Mutable state is moved into the locals, and freed outside the lock
+        CAddressBookTries tries;
+        CAddressRecordIndex recordIndex;
+        CAddressPhoneIndex phoneIndex;
+        CAddressSubstringIndex substringIndex;
+
+        // Publish the frozen book, lock must be held
+        auto publish = [&]()
+            {
+                mGeneration++;
+                PublishFrozenBook(std::move(pFrozenBook));
+
+                ForEachTrie([&tries](auto slot, auto& trie) { trie.Swap(std::get<slot>(tries)); });
+                mRecordIndex.swap(recordIndex);
+                mPhoneIndex.swap(phoneIndex);
+                mSubstringIndex.Swap(substringIndex);
+
+                // Frozen searches bypass the cache
+                mSearchCache.Clear();
+            };
+
+        {
+            CMetricsLockGuard lock(mMutex, mMetrics);
+            if (IsFrozen())
+            {
+                break;
+            }
+
+            generation = mGeneration;
+            tierOptions = mTierOptions;
+            records.reserve(mRecordIndex.size());
+            for (const auto& record : mRecordIndex)
+            {
+                records.push_back(record.second);
+            }
+
+            // Writers kept getting in first, build and publish while holding the lock
+            if (attempt == kAddressBookCompactAttempts)
+            {
+                pFrozenBook = std::make_unique<CAddressFrozenBook>(records, tierOptions);
+                publish();
+                break;
+            }
+        }
+
+        // Entries never change once added, so shared records are safe to read without the lock
+        pFrozenBook = std::make_unique<CAddressFrozenBook>(records, tierOptions);
+
+        {
+            CMetricsLockGuard lock(mMutex, mMetrics);
+
+            // Only publish if no write happened meanwhile
+            if (generation == mGeneration)
+            {
+                publish();
+                break;
+            }
+        }
+    }
+
+    return GetMemoryUsage();
+}
+
+//====================================================================
+//	    Thaw : Move entries of the frozen book back into mutable tries
+//====================================================================
+AddressBookMemoryUsage CAddressBook::Thaw()
+{
+    std::shared_ptr<const CAddressFrozenBook> pFrozenBook;
+    {
+        CMetricsLockGuard lock(mMutex, mMetrics);
+
+        // Readers that pinned the book keep reading it while its entries are added back
+        pFrozenBook = DetachFrozenBook();
+        if (pFrozenBook)
+        {
+            AddressEntries entries;
+            pFrozenBook->ForEachInAddedOrder([&entries](const AddressEntry& entry)
+                {
+                    entries.push_back(entry);
+                });
+
+            // The lookup filter already counts these entries, it is set aside while they are added back,
+            // lookups meanwhile take the lock and wait
+            CAddressLookupFilter* pLookupFilter = mpLookupFilter.exchange(nullptr);
+
+            // Entries were already validated and deduplicated when first added,
+            // a failed batch leaves nothing behind so the book stays frozen
+            try
+            {
+                InsertEntries(entries.cbegin(), entries.cend());
+            }
+            catch (...)
+            {
+                mpLookupFilter.store(pLookupFilter);
+                PublishFrozenBook(std::move(pFrozenBook));
+                throw;
+            }
+
+            mpLookupFilter.store(pLookupFilter);
+
+            // Rankings of the new tries are built on first use, after the scores are back
+            pFrozenBook->ForEachScored([this](const AddressEntry& entry, uint64_t score)
+                {
+                    auto it = mRecordIndex.find(&entry);
+                    if (it != mRecordIndex.end())
+                    {
+                        it->second->mScore.store(score, std::memory_order_relaxed);
+                    }
+                });
+        }
+    }
+
+    // Readers that pinned the book may be waiting for the lock, so they are waited for outside it
+    if (pFrozenBook)
+    {
+        mFrozenReaders.Synchronise();
+    }
+
+    return GetMemoryUsage();
+}
+
+//====================================================================
+//	    LoadFrozen : Replace every entry with those pulled from source, packed straight into a frozen book
+//====================================================================
+AddressEntryError CAddressBook::LoadFrozen(const AddressEntrySource& source)
+{
+    CAddressTierOptions tierOptions;
+    {
+        CMetricsLockGuard lock(mMutex, mMetrics);
+        tierOptions = mTierOptions;
+    }
+
+    // Entries the mutable book would reject stop the load, names must fit the tries
+    AddressEntryError result = AddressEntryError::kAddressEntrySuccess;
+    auto validSource = [&source, &result](AddressEntry& outEntry)
+        {
+            if (!source(outEntry))
+            {
+                return false;
+            }
+
+            if (!IsValidEntry(outEntry) || !IsAlphaOnly(outEntry.mFirstName) || !IsAlphaOnly(outEntry.mLastName))
+            {
+                result = AddressEntryError::kAddressEntryInvalid;
+                return false;
+            }
+
+            return true;
+        };
+
+    // Built without the lock, readers and writers carry on with the current book meanwhile
+    std::unique_ptr<CAddressFrozenBook> pFrozenBook;
+    try
+    {
+        AddressEntryError loadResult = AddressEntryError::kAddressEntrySuccess;
+        pFrozenBook = CAddressFrozenBook::Load(validSource, tierOptions, loadResult);
+        if (result == AddressEntryError::kAddressEntrySuccess)
+        {
+            result = loadResult;
+        }
+    }
+    catch (const std::ios_base::failure&)
+    {
+        return AddressEntryError::kAddressEntryIOFailure;
+    }
+
+    if (result != AddressEntryError::kAddressEntrySuccess)
+    {
+        return result;
+    }
+
+    std::shared_ptr<const CAddressFrozenBook> pPreviousBook;
+    {
+        CMetricsLockGuard lock(mMutex, mMetrics);
+        pPreviousBook = DetachFrozenBook();
+
+        // Publishes the clear and empties the lookup filter and search cache along with the mutable tries
+        ClearAndPublish();
+
+        if (CAddressLookupFilter* pLookupFilter = mpLookupFilter.load())
+        {
+            pFrozenBook->ForEach([pLookupFilter](const AddressEntry& entry) { pLookupFilter->Insert(entry); });
+        }
+
+        if (mChangeFeed.IsEnabled())
+        {
+            AddressChanges changes;
+            pFrozenBook->ForEachInAddedOrder([this, &changes](const AddressEntry& entry)
+                {
+                    changes.push_back({ 0, AddressChangeType::Add, entry });
+                    if (changes.size() >= kAddressBookLoadPublishCount)
+                    {
+                        mChangeFeed.Publish(changes);
+                        changes.clear();
+                    }
+                });
+
+            mChangeFeed.Publish(changes);
+        }
+
+        PublishFrozenBook(std::move(pFrozenBook));
+    }
+
+    // Readers that pinned the previous book may be waiting for the lock, so they are waited for outside it
+    if (pPreviousBook)
+    {
+        mFrozenReaders.Synchronise();
+    }
+
+    return AddressEntryError::kAddressEntrySuccess;
+}
+
+//====================================================================
+//	    SetTieredStorage : Spill entries of books frozen from now on to a payload file in directory
+//====================================================================
+AddressEntryError CAddressBook::SetTieredStorage(const std::string& directory, size_t cacheBytes)
+{
+    std::error_code error;
+    if (!directory.empty() && !std::filesystem::is_directory(directory, error))
+    {
+        return AddressEntryError::kAddressEntryIOFailure;
+    }
+
+    // A book already frozen keeps its entries where they are until thawed
+    CMetricsLockGuard lock(mMutex, mMetrics);
+    mTierOptions.mDirectory = directory;
+    mTierOptions.mCacheBytes = cacheBytes;
+
+    return AddressEntryError::kAddressEntrySuccess;
+}
+
+//====================================================================
+//	    GetTierStats : Page cache counters of the frozen book
+//====================================================================
+AddressBookTierStats CAddressBook::GetTierStats() const
+{
+    CAddressFrozenReader frozenReader(mpFrozenBook, mFrozenReaders);
+    if (const CAddressFrozenBook* pFrozenBook = frozenReader.Pin())
+    {
+        return pFrozenBook->GetTierStats();
+    }
+
+    return AddressBookTierStats();
+}
+
+//====================================================================
+//	    SetLookupFilter : Answer lookups of absent entries and names from a counting Bloom filter
+//====================================================================
+AddressEntryError CAddressBook::SetLookupFilter(size_t expectedEntries, double falsePositiveRate)
+{
+    if (expectedEntries != 0 && !(falsePositiveRate > 0.0 && falsePositiveRate < 1.0))
+    {
+        return AddressEntryError::kAddressEntryInvalid;
+    }
+
+    std::unique_ptr<CAddressLookupFilter> pLookupFilter;
+    if (expectedEntries != 0)
+    {
+        pLookupFilter = std::make_unique<CAddressLookupFilter>(expectedEntries, falsePositiveRate);
+    }
+
+    std::unique_ptr<CAddressLookupFilter> pPreviousFilter;
+    {
+        CMetricsLockGuard lock(mMutex, mMetrics);
+        if (pLookupFilter)
+        {
+            if (IsFrozen())
+            {
+                mpFrozenBook.load()->ForEach([&pLookupFilter](const AddressEntry& entry) { pLookupFilter->Insert(entry); });
+            }
+            else
+            {
+                for (const auto& record : mRecordIndex)
+                {
+                    pLookupFilter->Insert(record.second->mEntry);
+                }
+            }
+        }
+
+        pPreviousFilter.reset(mpLookupFilter.exchange(pLookupFilter.release()));
+    }
+
+    // Lookups that pinned the previous filter may be waiting for the lock, so they are waited for outside it
+    if (pPreviousFilter)
+    {
+        mLookupFilterReaders.Synchronise();
+    }
+
+    return AddressEntryError::kAddressEntrySuccess;
+}
+
+//====================================================================
+//	    GetLookupFilterStats : Lookup filter counters
+//====================================================================
+AddressLookupFilterStats CAddressBook::GetLookupFilterStats() const
+{
+    CAddressLookupFilterReader filterReader(mpLookupFilter, mLookupFilterReaders);
+    if (const CAddressLookupFilter* pLookupFilter = filterReader.Pin())
+    {
+        return pLookupFilter->GetStats();
+    }
+
+    return AddressLookupFilterStats();
+}
+
+//====================================================================
+//	    SetChangeFeedCapacity : Keep up to capacity latest changes for followers
+//====================================================================
+void CAddressBook::SetChangeFeedCapacity(size_t capacity)
+{
+    // Taken so no write publishes halfway through the resize
+    CMetricsLockGuard lock(mMutex, mMetrics);
+    mChangeFeed.SetCapacity(capacity);
+}
+
+//====================================================================
+//	    SetChangeLog : Append changes to a log file, an empty path closes it
+//====================================================================
+AddressEntryError CAddressBook::SetChangeLog(const std::string& path)
+{
+    CMetricsLockGuard lock(mMutex, mMetrics);
+    return mChangeFeed.SetLog(path);
+}
+
+//====================================================================
+//	    GetChangeLogStatus : kAddressEntryIOFailure once a write to the change log failed, without taking the book's lock
+//====================================================================
+AddressEntryError CAddressBook::GetChangeLogStatus() const
+{
+    return mChangeFeed.GetLogStatus();
+}
+
+//====================================================================
+//	    ReadChanges : Changes published after sequence, without taking the book's lock
+//====================================================================
+AddressEntryError CAddressBook::ReadChanges(uint64_t afterSequence,
+                                            size_t maxCount,
+                                            std::chrono::milliseconds timeout,
+                                            AddressChanges& outChanges) const
+{
+    return mChangeFeed.Read(afterSequence, maxCount, timeout, outChanges);
+}
+
+//====================================================================
+//	    RetrieveChangeSnapshot : Every entry in the order added, and the sequence of the last change they include
+//====================================================================
+AddressEntries CAddressBook::RetrieveChangeSnapshot(uint64_t& outSequence) const
+{
+    CMetricsLockGuard lock(mMutex, mMetrics);
+    outSequence = mChangeFeed.GetLastSequence();
+
+    // Same key entries then keep their relative order on the follower
+    AddressEntries result;
+    if (IsFrozen())
+    {
+        mpFrozenBook.load()->ForEachInAddedOrder([&result](const AddressEntry& entry) { result.push_back(entry); });
+        return result;
+    }
+
+    std::vector<const CAddressRecord*> records;
+    records.reserve(mRecordIndex.size());
+    for (const auto& record : mRecordIndex)
+    {
+        records.push_back(record.second.get());
+    }
+
+    std::sort(records.begin(), records.end(), [](const CAddressRecord* lhs, const CAddressRecord* rhs) { return lhs->mId < rhs->mId; });
+    for (const CAddressRecord* record : records)
+    {
+        result.push_back(record->mEntry);
+    }
+
+    return result;
+}
+
+//====================================================================
+//	    ApplyChanges : Apply a leader's changes in sequence order
+//====================================================================
+AddressEntryError CAddressBook::ApplyChanges(const AddressChanges& changes)
+{
+    CMetricsLockGuard lock(mMutex, mMetrics);
+    if (IsFrozen())
+    {
+        return AddressEntryError::kAddressEntryReadOnly;
+    }
+
+    for (const auto& change : changes)
+    {
+        // Redelivered changes were already applied
+        if (change.mSequence <= mAppliedSequence)
+        {
+            continue;
+        }
+
+        // Changes after a gap can't be applied, the follower must resynchronise from a snapshot
+        if (change.mSequence != mAppliedSequence + 1)
+        {
+            return AddressEntryError::kAddressEntryOutOfSequence;
+        }
+
+        AddressEntryError result = AddressEntryError::kAddressEntrySuccess;
+        switch (change.mType)
+        {
+        case AddressChangeType::Add:
+            result = InsertAndPublish(&change.mEntry, &change.mEntry + 1);
+            break;
+        case AddressChangeType::Remove:
+            result = RemoveAndPublish(change.mEntry, true);
+            break;
+        case AddressChangeType::Clear:
+            ClearAndPublish();
+            break;
+        default:
+            result = AddressEntryError::kAddressEntryInvalid;
+            break;
+        }
+
+        // Follower no longer matches the leader
+        if (result != AddressEntryError::kAddressEntrySuccess)
+        {
+            return result;
+        }
+
+        mAppliedSequence = change.mSequence;
+    }
+
+    return AddressEntryError::kAddressEntrySuccess;
+}
+
+//====================================================================
+//	    ApplyChangeSnapshot : Replace every entry with a leader's snapshot
+//====================================================================
+AddressEntryError CAddressBook::ApplyChangeSnapshot(const AddressEntries& entries, uint64_t sequence)
+{
+    CMetricsLockGuard lock(mMutex, mMetrics);
+    if (IsFrozen())
+    {
+        return AddressEntryError::kAddressEntryReadOnly;
+    }
+
+    ClearAndPublish();
+
+    AddressEntryError result = InsertAndPublish(entries.cbegin(), entries.cend());
+    if (result == AddressEntryError::kAddressEntrySuccess)
+    {
+        mAppliedSequence = sequence;
+    }
+
+    return result;
+}
+
+//====================================================================
+//	    GetAppliedSequence : Sequence of the last leader change applied
+//====================================================================
+uint64_t CAddressBook::GetAppliedSequence() const
+{
+    CMetricsLockGuard lock(mMutex, mMetrics);
+    return mAppliedSequence;
+}
+
+//====================================================================
+//	    BeginRead : Pin the frozen book, or lock the mutable book if it is not frozen
+//====================================================================
+const CAddressFrozenBook* CAddressBook::BeginRead(CAddressFrozenReader& frozenReader,
+                                                  std::optional<CMetricsLockGuard>& lock) const
+{
+    if (const CAddressFrozenBook* pFrozenBook = frozenReader.Pin())
+    {
+        return pFrozenBook;
+    }
+
+    lock.emplace(mMutex, mMetrics);
+
+    // Frozen while waiting for the lock
+    if (const CAddressFrozenBook* pFrozenBook = frozenReader.Pin())
+    {
+        lock.reset();
+        return pFrozenBook;
+    }
+
+    return nullptr;
+}
+
+//====================================================================
+//	    IsFrozen : Check if the book is frozen, lock must be held
+//====================================================================
+bool CAddressBook::IsFrozen() const
+{
+    return mpFrozenBook.load() != nullptr;
+}
+
+//====================================================================
+//	    PublishFrozenBook : Publish the frozen book for reads and pinned versions, lock must be held
+//====================================================================
+void CAddressBook::PublishFrozenBook(std::shared_ptr<const CAddressFrozenBook> pFrozenBook)
+{
+    mpFrozenBook.store(pFrozenBook.get());
+    mpFrozenBookOwner = std::move(pFrozenBook);
+}
+
+//====================================================================
+//	    DetachFrozenBook : Unpublish the frozen book, lock must be held
+//====================================================================
+std::shared_ptr<const CAddressFrozenBook> CAddressBook::DetachFrozenBook()
+{
+    CAddressFrozenReader::Detach(mpFrozenBook);
+    return std::move(mpFrozenBookOwner);
+}
+
+//====================================================================
+//	    ForEachTrie : Call function with the slot and the trie of every trie in record slot order
+//====================================================================
+template <typename Function>
+void CAddressBook::ForEachTrie(Function&& function)
+{
+    function(std::integral_constant<uint32_t, kFirstNameTrieSlot>(), mFirstNameTrie);
+    function(std::integral_constant<uint32_t, kLastNameTrieSlot>(), mLastNameTrie);
+    function(std::integral_constant<uint32_t, kNoFirstNameTrieSlot>(), mNoFirstNameTrie);
+    function(std::integral_constant<uint32_t, kNoLastNameTrieSlot>(), mNoLastNameTrie);
+}
+
+//====================================================================
+//	    RemoveRecord : Remove record from every trie holding it and from the record index
+//====================================================================
+void CAddressBook::RemoveRecord(const CAddressRecordPtr& pRecord)
+{
+    // Keep the record alive until every trie let go of it
+    CAddressRecordPtr pHeldRecord(pRecord);
+
+    ForEachTrie([&pHeldRecord](auto slot, auto& trie)
+        {
+            if (IsInTrie(pHeldRecord->mEntry, slot))
+            {
+                trie.Remove(pHeldRecord->mHandles[slot]);
+            }
+        });
+
+    if (mSubstringIndexEnabled)
+    {
+        mSubstringIndex.Remove(*pHeldRecord);
+    }
+
+    mPhoneIndex.erase(pHeldRecord->mPhoneHandle);
+    mRecordIndex.erase(&pHeldRecord->mEntry);
+
+    // Counted out once no trie holds it
+    if (CAddressLookupFilter* pLookupFilter = mpLookupFilter.load())
+    {
+        pLookupFilter->Remove(pHeldRecord->mEntry);
+    }
+}
+
+//====================================================================
+//	    InsertEntries : Add entries by preparing every record first and then committing them together,
+//                      lock must be held
+//====================================================================
+template <typename Iterator>
+AddressEntryError CAddressBook::InsertEntries(Iterator begin, Iterator end)
+{
+    for (Iterator it = begin; it != end; ++it)
+    {
+        if (!IsValidEntry(*it))
+        {
+            return AddressEntryError::kAddressEntryInvalid;
+        }
+    }
+
+    // Prepare every record, nothing is visible to readers yet
+    std::vector<CPreparedRecord> prepared;
+    prepared.reserve(std::distance(begin, end));
+
+    AddressEntryError result = AddressEntryError::kAddressEntrySuccess;
+    try
+    {
+        for (Iterator it = begin; it != end && result == AddressEntryError::kAddressEntrySuccess; ++it)
+        {
+            prepared.emplace_back();
+            result = PrepareRecord(*it, prepared.back());
+        }
+    }
+    catch (...)
+    {
+        AbortRecords(prepared);
+        throw;
+    }
+
+    if (result != AddressEntryError::kAddressEntrySuccess)
+    {
+        AbortRecords(prepared);
+        return result;
+    }
+
+    // Publish them together
+    mGeneration++;
+    for (auto& record : prepared)
+    {
+        CommitRecord(record);
+    }
+
+    try
+    {
+        for (Iterator it = begin; it != end; ++it)
+        {
+            mSearchCache.Invalidate(*it);
+        }
+    }
+    catch (...)
+    {
+        // Entries are already added, stale results must not outlive them
+        mSearchCache.Clear();
+    }
+
+    return AddressEntryError::kAddressEntrySuccess;
+}
+
+//====================================================================
+//	    InsertAndPublish : Add entries and publish them to the change feed
+//====================================================================
+template <typename Iterator>
+AddressEntryError CAddressBook::InsertAndPublish(Iterator begin, Iterator end)
+{
+    // Built before anything is added, publishing then cannot fail
+    AddressChanges changes;
+    if (mChangeFeed.IsEnabled())
+    {
+        for (Iterator it = begin; it != end; ++it)
+        {
+            changes.push_back({ 0, AddressChangeType::Add, *it });
+        }
+    }
+
+    AddressEntryError result = InsertEntries(begin, end);
+    if (result == AddressEntryError::kAddressEntrySuccess)
+    {
+        mChangeFeed.Publish(changes);
+    }
+
+    return result;
+}
+
+//====================================================================
+//	    RemoveAndPublish : Remove entry, or every entry of the same name, and publish the removals
+//====================================================================
+AddressEntryError CAddressBook::RemoveAndPublish(const AddressEntry& entry, bool removeMatchingOnly)
+{
+    // Records are located first, removing them by handle cannot fail
+    std::vector<CAddressRecordPtr> records;
+    if (removeMatchingOnly)
+    {
+        // Exact match is a single lookup
+        auto it = mRecordIndex.find(&entry);
+        if (it != mRecordIndex.end())
+        {
+            records.push_back(it->second);
+        }
+    }
+    else
+    {
+        // Every record filed under the same name, whatever its phone number
+        if (entry.mFirstName.empty())
+        {
+            mLastNameTrie.Find(entry, records);
+        }
+        else
+        {
+            mFirstNameTrie.Find(entry, records);
+        }
+
+        // Tries key on both names joined, so {"", "smithjohn"} and {"john", "smith"} share a node,
+        // the key already matches ignoring case and a first name of the same length pins the split
+        records.erase(std::remove_if(records.begin(), records.end(), [&entry](const CAddressRecordPtr& pRecord)
+            {
+                return pRecord->mEntry.mFirstName.size() != entry.mFirstName.size();
+            }), records.end());
+    }
+
+    if (records.empty())
+    {
+        return AddressEntryError::kAddressEntryNotFound;
+    }
+
+    // Every removed entry is published, followers then only need exact removes
+    AddressChanges changes;
+    if (mChangeFeed.IsEnabled())
+    {
+        for (const auto& pRecord : records)
+        {
+            changes.push_back({ 0, AddressChangeType::Remove, pRecord->mEntry });
+        }
+    }
+
+    mGeneration++;
+    for (const auto& pRecord : records)
+    {
+        RemoveRecord(pRecord);
+    }
+
+    mChangeFeed.Publish(changes);
+    mSearchCache.Invalidate(entry);
+
+    return AddressEntryError::kAddressEntrySuccess;
+}
+
+//====================================================================
+//	    ClearAndPublish : Drop every entry and publish the clear
+//====================================================================
+void CAddressBook::ClearAndPublish()
+{
+    AddressChanges changes;
+    if (mChangeFeed.IsEnabled())
+    {
+        changes.push_back({ 0, AddressChangeType::Clear, AddressEntry() });
+    }
+
+    mGeneration++;
+
+    mFirstNameTrie.Clear();
+    mLastNameTrie.Clear();
+    mNoFirstNameTrie.Clear();
+    mNoLastNameTrie.Clear();
+    mRecordIndex.clear();
+    mPhoneIndex.clear();
+    mSubstringIndex.Clear();
+
+    if (CAddressLookupFilter* pLookupFilter = mpLookupFilter.load())
+    {
+        pLookupFilter->Clear();
+    }
+
+    mSearchCache.Clear();
+    mChangeFeed.Publish(changes);
+}
+
+//====================================================================
+//	    PrepareRecord : Claim record index entry and allocate trie positions for entry
+//====================================================================
+AddressEntryError CAddressBook::PrepareRecord(const AddressEntry& entry, CPreparedRecord& outPrepared)
+{
+    // Shared by every trie, so the entry is stored once
+    outPrepared.mpRecord = std::make_shared<CAddressRecord>(entry, mNextRecordId++);
+
+    // A single lookup covers every trie
+    if (!mRecordIndex.emplace(&outPrepared.mpRecord->mEntry, outPrepared.mpRecord).second)
+    {
+        return AddressEntryError::kAddressEntryDuplicate;
+    }
+
+    outPrepared.mIndexed = true;
+
+    outPrepared.mpRecord->mPhoneHandle = mPhoneIndex.emplace(entry.mPhoneNumber, outPrepared.mpRecord.get());
+    outPrepared.mPhoneIndexed = true;
+
+    AddressEntryError result = AddressEntryError::kAddressEntrySuccess;
+    ForEachTrie([&](auto slot, auto& trie)
+        {
+            if (result == AddressEntryError::kAddressEntrySuccess && IsInTrie(entry, slot))
+            {
+                result = trie.PrepareInsert(outPrepared.mpRecord, outPrepared.mInsertions[slot]);
+            }
+        });
+
+    if (result != AddressEntryError::kAddressEntrySuccess)
+    {
+        return result;
+    }
+
+    if (mSubstringIndexEnabled)
+    {
+        // Marked first, so a partial insertion is still undone
+        outPrepared.mSubstringIndexed = true;
+        mSubstringIndex.Insert(outPrepared.mpRecord);
+    }
+
+    return AddressEntryError::kAddressEntrySuccess;
+}
+
+//====================================================================
+//	    CommitRecord : Publish prepared record in every trie
+//====================================================================
+void CAddressBook::CommitRecord(CPreparedRecord& prepared) noexcept
+{
+    ForEachTrie([&prepared](auto slot, auto& trie)
+        {
+            if (IsInTrie(prepared.mpRecord->mEntry, slot))
+            {
+                prepared.mpRecord->mHandles[slot] = trie.CommitInsert(prepared.mInsertions[slot]);
+            }
+        });
+
+    // Counted in once every trie holds it, lookups that see it go on to find it
+    if (CAddressLookupFilter* pLookupFilter = mpLookupFilter.load())
+    {
+        pLookupFilter->Insert(prepared.mpRecord->mEntry);
+    }
+}
+
+//====================================================================
+//	    AbortRecords : Release everything held by prepared records
+//====================================================================
+void CAddressBook::AbortRecords(std::vector<CPreparedRecord>& prepared) noexcept
+{
+    // Later records may sit on nodes allocated by earlier ones, so undo in reverse
+    for (auto it = prepared.rbegin(); it != prepared.rend(); ++it)
+    {
+        ForEachTrie([&it](auto slot, auto& trie) { trie.AbortInsert(it->mInsertions[slot]); });
+
+        if (it->mSubstringIndexed)
+        {
+            mSubstringIndex.Remove(*it->mpRecord);
+        }
+
+        if (it->mPhoneIndexed)
+        {
+            mPhoneIndex.erase(it->mpRecord->mPhoneHandle);
+        }
+
+        if (it->mIndexed)
+        {
+            mRecordIndex.erase(&it->mpRecord->mEntry);
+        }
+    }
+
+    prepared.clear();
+}
+
+//====================================================================
+//	    GetThreadPool : Get worker threads, starting them on first use
+//====================================================================
+CThreadPool& CAddressBook::GetThreadPool() const
+{
+    std::call_once(mThreadPoolFlag, [this]() { mpThreadPool.reset(new CThreadPool); });
+    return *mpThreadPool;
+}
+
+//====================================================================
+//	    ParallelAlphabeticOrder : Retrieve trie entries in alphabetical order,
+//                                traversing partitions on worker threads
+//====================================================================
+template <typename Trie>
+AddressEntries CAddressBook::ParallelAlphabeticOrder(const Trie& trie) const
+{
+    AddressEntries result;
+
+    // Not worth handing small tries to workers
+    if (trie.GetEntryCount() < kAddressBookParallelRetrieveMin)
+    {
+        trie.ForEach([&result](const AddressEntry& entry) { result.push_back(entry); });
+        return result;
+    }
+
+    // Each partition is copied into its own buffer
+    CThreadPool& threadPool = GetThreadPool();
+
+    std::vector<std::future<AddressEntries>> buffers;
+    for (const auto& partition : trie.Partition())
+    {
+        buffers.push_back(threadPool.Submit([&trie, partition]()
+            {
+                AddressEntries buffer;
+                trie.ForEach(partition, [&buffer](const AddressEntry& entry) { buffer.push_back(entry); });
+                return buffer;
+            }));
+    }
+
+    // Partitions are in alphabetical order, so buffers are concatenated as they are
+    try
+    {
+        for (auto& buffer : buffers)
+        {
+            result.splice(result.cend(), buffer.get());
+        }
+    }
+    catch (...)
+    {
+        WaitForAll(buffers);
+        throw;
+    }
+
+    return result;
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 //=======================================================
 #include "CAddressBookManager.h"
 #include "CAddressBook.h"
+#include "CThreadPool.h"
 
 //=======================================================
 //		CAddressBookManager
@@ -29,3 +30,21 @@ CAddressBook* CAddressBookManager::GetAddressBook()
 {
 	return mpAddressBook.get();
 }
+
+//=======================================================
+//		GetExecutor : Get executor for asynchronous requests
+//=======================================================
+CThreadPool* CAddressBookManager::GetExecutor()
+{
+	std::call_once(mExecutorFlag, [this]() { mpExecutor.reset(new CThreadPool); });
+	return mpExecutor.get();
+}
+
+//=======================================================
+//		GetStreamExecutor : Get executor for result streams and asynchronous iterations
+//=======================================================
+CThreadPool* CAddressBookManager::GetStreamExecutor()
+{
+	std::call_once(mStreamExecutorFlag, [this]() { mpStreamExecutor.reset(new CThreadPool); });
+	return mpStreamExecutor.get();
+}
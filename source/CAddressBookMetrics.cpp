@@ -0,0 +1,101 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressBookMetrics.h"
+
+//=======================================================
+//		CLatencyHistogram
+//=======================================================
+CLatencyHistogram::CLatencyHistogram() :
+    mCount(0),
+    mTotalNanoseconds(0),
+    mMaxNanoseconds(0)
+{
+    for (auto& bucket : mBuckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+//=======================================================
+//		Record : Record a latency sample
+//=======================================================
+void CLatencyHistogram::Record(uint64_t nanoseconds)
+{
+    // Bucket i holds [2^i, 2^(i+1)) nanoseconds
+    uint32_t bucket = 0;
+    for (uint64_t value = nanoseconds >> 1; value != 0 && bucket < kAddressBookLatencyBuckets - 1; value >>= 1)
+    {
+        bucket++;
+    }
+
+    mBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    mTotalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+    uint64_t currentMax = mMaxNanoseconds.load(std::memory_order_relaxed);
+    while (nanoseconds > currentMax &&
+           !mMaxNanoseconds.compare_exchange_weak(currentMax, nanoseconds, std::memory_order_relaxed))
+    {
+    }
+}
+
+//=======================================================
+//		RecordSince : Record time elapsed since start
+//=======================================================
+void CLatencyHistogram::RecordSince(const MetricsClock::time_point& start)
+{
+    Record(std::chrono::duration_cast<std::chrono::nanoseconds>(MetricsClock::now() - start).count());
+}
+
+//=======================================================
+//		Snapshot : Copy current counts
+//=======================================================
+AddressBookLatencyHistogram CLatencyHistogram::Snapshot() const
+{
+    AddressBookLatencyHistogram histogram;
+    for (uint32_t i = 0; i < kAddressBookLatencyBuckets; i++)
+    {
+        histogram.mBuckets[i] = mBuckets[i].load(std::memory_order_relaxed);
+    }
+
+    histogram.mCount = mCount.load(std::memory_order_relaxed);
+    histogram.mTotalNanoseconds = mTotalNanoseconds.load(std::memory_order_relaxed);
+    histogram.mMaxNanoseconds = mMaxNanoseconds.load(std::memory_order_relaxed);
+
+    return histogram;
+}
+
+//=======================================================
+//		GetOperation : Operation latency
+//=======================================================
+CLatencyHistogram& CAddressBookMetrics::GetOperation(AddressBookOperation operation)
+{
+    return mOperations[static_cast<uint32_t>(operation)];
+}
+
+//=======================================================
+//		AddEntries : Count entries returned or visited by an operation
+//=======================================================
+void CAddressBookMetrics::AddEntries(AddressBookOperation operation, uint64_t count)
+{
+    mOperationEntries[static_cast<uint32_t>(operation)].fetch_add(count, std::memory_order_relaxed);
+}
+
+//=======================================================
+//		Snapshot : Copy operation and lock counters
+//=======================================================
+void CAddressBookMetrics::Snapshot(AddressBookMetrics& outMetrics) const
+{
+    outMetrics.mEnabled = ADDRESS_BOOK_METRICS != 0;
+
+    for (uint32_t i = 0; i < kAddressBookOperationCount; i++)
+    {
+        outMetrics.mOperations[i].mLatency = mOperations[i].Snapshot();
+        outMetrics.mOperations[i].mEntries = mOperationEntries[i].load(std::memory_order_relaxed);
+    }
+
+    outMetrics.mLockWait = mLockWait.Snapshot();
+    outMetrics.mLockHold = mLockHold.Snapshot();
+    outMetrics.mForEachCallback = mForEachCallback.Snapshot();
+}
\ No newline at end of file
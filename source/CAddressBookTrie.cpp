@@ -11,164 +11,194 @@ void LowerCaseString(std::string& str)
     for (char& c : str) { c = tolower(c); }
 }
 
+//=======================================================
+//		EstimateEntryBytes : Approximate heap bytes held for an entry in a trie node
+//=======================================================
+static size_t EstimateEntryBytes(const AddressEntry& entry)
+{
+    // List node, shared record and its trie handles around the entry
+    constexpr size_t kEntryOverheadBytes = (4 + kAddressBookTrieCount) * sizeof(void*) + 2 * sizeof(long);
+
+    // Strings up to this capacity are stored inline by common implementations
+    constexpr size_t kInlineStringCapacity = 15;
+
+    size_t bytes = kEntryOverheadBytes + sizeof(AddressEntry);
+    for (const std::string* str : { &entry.mFirstName, &entry.mLastName, &entry.mPhoneNumber })
+    {
+        if (str->capacity() > kInlineStringCapacity)
+        {
+            bytes += str->capacity() + 1;
+        }
+    }
+
+    return bytes;
+}
+
 //=======================================================
 //		CAddressTrie
 //=======================================================
-CAddressTrie::CAddressTrie() :
-    mRootNode(new CAddressTrieNode)
+template <typename Alphabet, typename KeyPolicy>
+CAddressTrie<Alphabet, KeyPolicy>::CAddressTrie() :
+    mRootNode(new TrieNode),
+    mEntryCount(0),
+    mNodeCount(1),
+    mEntryBytes(0)
 {
 
 }
 
 //=======================================================
-//		Insert : Insert entry to trie
+//		Insert : Insert record to trie
+//=======================================================
+template <typename Alphabet, typename KeyPolicy>
+AddressEntryError CAddressTrie<Alphabet, KeyPolicy>::Insert(const CAddressRecordPtr& pRecord, CAddressRecordHandle& outHandle)
+{
+    TrieInsertion insertion;
+
+    AddressEntryError result = PrepareInsert(pRecord, insertion);
+    if (result == AddressEntryError::kAddressEntrySuccess)
+    {
+        outHandle = CommitInsert(insertion);
+    }
+
+    return result;
+}
+
+//=======================================================
+//		PrepareInsert : Allocate everything the insertion needs
 //=======================================================
-AddressEntryError CAddressTrie::Insert(const AddressEntry& addressEntry)
+template <typename Alphabet, typename KeyPolicy>
+AddressEntryError CAddressTrie<Alphabet, KeyPolicy>::PrepareInsert(const CAddressRecordPtr& pRecord, TrieInsertion& outInsertion)
 {
     // Get key
-    std::string key(GetTrieKey(addressEntry));
+    std::string key(KeyPolicy::Get(pRecord->mEntry));
 
-    // Ensure key is not empty
-    if (key.empty())
+    // Ensure key is not empty and every character has a child slot,
+    // the key is only kept once it is valid so aborting a rejected insertion prunes nothing
+    if (key.empty() || !IsValidKey(key))
     {
         return AddressEntryError::kAddressEntryInvalid;
     }
 
+    outInsertion.mKey = std::move(key);
+
+    // List node is allocated first, so a failure below leaves at most empty nodes to prune
+    outInsertion.mPending.push_back(pRecord);
+
     // Traverse trie 
-    CAddressTrieNode* currentNode = mRootNode.get();
-    for (const char& c : key)
+    TrieNode* currentNode = mRootNode.get();
+    for (const char& c : outInsertion.mKey)
     {
-        // Determine index (ascii 'a' is 97)
-        int index = c - 97;
+        uint32_t index = Alphabet::Index(c);
 
-        // Allocate nodes until we reach our desired point in the trie
+        // Allocate nodes until we reach our desired point in the trie, empty nodes are not visible to readers
         if (currentNode->mCharacters[index].get() == nullptr)
         {
-            currentNode->mCharacters[index].reset(new CAddressTrieNode);
+            currentNode->mCharacters[index].reset(new TrieNode);
+            currentNode->mChildCount++;
+            mNodeCount++;
         }
 
         currentNode = currentNode->mCharacters[index].get();
     }
 
-    // Check for duplicate
-    for (const auto& entry : currentNode->mEntries)
+    outInsertion.mpNode = currentNode;
+    return AddressEntryError::kAddressEntrySuccess;
+}
+
+//=======================================================
+//		CommitInsert : Publish a prepared insertion
+//=======================================================
+template <typename Alphabet, typename KeyPolicy>
+CAddressRecordHandle CAddressTrie<Alphabet, KeyPolicy>::CommitInsert(TrieInsertion& insertion) noexcept
+{
+    CAddressRecordList& entries = insertion.mpNode->mEntries;
+    CAddressRecordHandle handle = insertion.mPending.begin();
+
+    InvalidateRanking((*handle)->mEntry);
+
+    entries.splice(entries.cend(), insertion.mPending);
+    mEntryCount++;
+    mEntryBytes += EstimateEntryBytes((*handle)->mEntry);
+
+    insertion.mpNode = nullptr;
+    return handle;
+}
+
+//=======================================================
+//		AbortInsert : Drop a prepared insertion
+//=======================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::AbortInsert(TrieInsertion& insertion) noexcept
+{
+    insertion.mPending.clear();
+    insertion.mpNode = nullptr;
+
+    if (!insertion.mKey.empty())
     {
-        if (*entry.get() == addressEntry)
-        {
-            return AddressEntryError::kAddressEntryDuplicate;
-        }
+        PruneBranch(insertion.mKey);
     }
-
-    // Add entry to node
-    currentNode->mEntries.emplace_back(new AddressEntry(addressEntry));
-    return AddressEntryError::kAddressEntrySuccess;
 }
 
 //====================================================================
-//		Remove : Remove entry from trie
+//		Remove : Remove record from trie
 //====================================================================
-AddressEntryError CAddressTrie::Remove(const AddressEntry& addressEntry,
-                                       bool matching /* = true */)
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::Remove(CAddressRecordHandle handle)
 {
     // Get key
-    std::string key(GetTrieKey(addressEntry));
+    std::string key(KeyPolicy::Get((*handle)->mEntry));
 
-    // Ensure key is not empty
-    if (key.empty())
+    // Traverse to key, the node exists as long as the record is in the trie
+    TrieNode* currentNode = mRootNode.get();
+    currentNode->mTopValid = false;
+    for (const char& c : key)
     {
-        return AddressEntryError::kAddressEntryInvalid;
+        currentNode = currentNode->mCharacters[Alphabet::Index(c)].get();
+        currentNode->mTopValid = false;
     }
 
-    // Traverse trie
-    CAddressTrieNode* currentNode = mRootNode.get();
-    for (const char& c : key)
-    {
-        // Determine index (ascii 'a' is 97)
-        int index = c - 97;
+    mEntryBytes -= EstimateEntryBytes((*handle)->mEntry);
+    mEntryCount--;
+    currentNode->mEntries.erase(handle);
 
-        // If no node is present means we don't have the entry
-        CAddressTrieNode* nextNode = currentNode->mCharacters[index].get();
-        if (nextNode == nullptr)
-        {
-            return AddressEntryError::kAddressEntryNotFound;
-        }
+    PruneBranch(key);
+}
 
-        currentNode = nextNode;
+//====================================================================
+//		Find : Records stored under the same key as the entry
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::Find(const AddressEntry& addressEntry, std::vector<CAddressRecordPtr>& outRecords) const
+{
+    std::string key(KeyPolicy::Get(addressEntry));
+    if (key.empty())
+    {
+        return;
     }
 
-    if (!currentNode->mEntries.empty())
+    const TrieNode* node = FindNode(key);
+    if (node != nullptr)
     {
-        if (matching)
-        {
-            // Look for matching entry(ies)
-            bool removed = false;
-            for (auto it = currentNode->mEntries.begin(); it != currentNode->mEntries.end();)
-            {
-                if (*it->get() == addressEntry)
-                {
-                    currentNode->mEntries.erase(it);
-
-                    // Indicate we've removed an entry
-                    if (!removed)
-                    {
-                        removed = true;
-                    }
-
-                    continue;
-                }
-                it++;
-            }
-            return removed ? AddressEntryError::kAddressEntrySuccess : AddressEntryError::kAddressEntryNotFound;
-        }
-        else
-        {
-            // Clear all entries
-            currentNode->mEntries.clear();
-            return AddressEntryError::kAddressEntrySuccess;
-        }
+        outRecords.insert(outRecords.end(), node->mEntries.begin(), node->mEntries.end());
     }
-
-    return AddressEntryError::kAddressEntryNotFound;
 }
 
 //====================================================================
 //		Search : Search for entry in trie
 //====================================================================
-CAddressTrie::AddressSearchResult CAddressTrie::Search(const std::string& searchKey,
+template <typename Alphabet, typename KeyPolicy>
+typename CAddressTrie<Alphabet, KeyPolicy>::AddressSearchResult CAddressTrie<Alphabet, KeyPolicy>::Search(const std::string& searchKey,
     const EntryPredicate& predicate /* = [](const AddressEntry&) {return true; } */) const
 {
-    // Lower case key
-    std::string key(searchKey);
-    LowerCaseString(key);
-
     // Initialise result
     AddressSearchResult result;
 
-    // Traverse to key
-    CAddressTrieNode* currentNode = mRootNode.get();
-    for (const char& c : key)
-    {
-        // Determine index (ascii 'a' is 97)
-        int index = c - 97;
-
-        // If no node is present means we don't have the entry
-        CAddressTrieNode* nextNode = currentNode->mCharacters[index].get();
-        if (nextNode == nullptr)
-        {
-            return result;
-        }
-
-        currentNode = nextNode;
-    }
-
-    // Add current entry(ies) that passes predicate
-    for (const auto& entry : currentNode->mEntries)
+    // Traverse to key, the alphabet folds case where it ignores it
+    const TrieNode* currentNode = FindNode(searchKey);
+    if (currentNode == nullptr)
     {
-        if (predicate(*entry.get()))
-        {
-            result.second.emplace_back(*entry.get());
-            result.first.emplace(entry.get());
-        }
+        return result;
     }
 
     // Populate with entries prefixed by specified key
@@ -181,7 +211,8 @@ CAddressTrie::AddressSearchResult CAddressTrie::Search(const std::string& search
 //		AlphabeticOrder : Retrieve entries in alphabetical order 
 //                                      with optional predicate to filter returning entries
 //====================================================================
-CAddressTrie::AddressSearchResult CAddressTrie::AlphabeticOrder(const EntryPredicate& predicate /* = [](const AddressEntry&) {return true; } */) const
+template <typename Alphabet, typename KeyPolicy>
+typename CAddressTrie<Alphabet, KeyPolicy>::AddressSearchResult CAddressTrie<Alphabet, KeyPolicy>::AlphabeticOrder(const EntryPredicate& predicate /* = [](const AddressEntry&) {return true; } */) const
 {
     // Traverse and return
     AddressSearchResult result;
@@ -193,41 +224,221 @@ CAddressTrie::AddressSearchResult CAddressTrie::AlphabeticOrder(const EntryPredi
 //====================================================================
 //		ForEach : Pass in a function to iterate through each entry in trie
 //====================================================================
-void CAddressTrie::ForEach(const AddressEntryCallback& callback) const
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::ForEach(const AddressEntryCallback& callback) const
 {
     PreOrderTraverseForEach(mRootNode.get(), callback);
 }
 
+//====================================================================
+//		Partition : Split trie into disjoint partitions, listed in alphabetical order
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+std::vector<CAddressTriePartition<Alphabet>> CAddressTrie<Alphabet, KeyPolicy>::Partition(uint32_t depth /* = kAddressTriePartitionDepth */) const
+{
+    std::vector<TriePartition> partitions;
+    PreOrderPartition(mRootNode.get(), depth, partitions);
+
+    return partitions;
+}
+
+//====================================================================
+//		ForEach : Pass in a function to iterate through each entry in a partition of the trie
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::ForEach(const TriePartition& partition,
+                                                const AddressEntryCallback& callback) const
+{
+    if (partition.mSubtree)
+    {
+        PreOrderTraverseForEach(partition.mpNode, callback);
+        return;
+    }
+
+    for (const auto& entry : partition.mpNode->mEntries)
+    {
+        callback(entry->mEntry);
+    }
+}
+
 //====================================================================
 //		Clear : Clear trie
 //====================================================================
-void CAddressTrie::Clear()
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::Clear()
+{
+    mRootNode.reset(new TrieNode);
+    mEntryCount = 0;
+    mNodeCount = 1;
+    mEntryBytes = 0;
+}
+
+//====================================================================
+//		Swap : Exchange contents with another trie of the same key order
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::Swap(CAddressTrie& other)
+{
+    std::swap(mRootNode, other.mRootNode);
+    std::swap(mEntryCount, other.mEntryCount);
+    std::swap(mNodeCount, other.mNodeCount);
+    std::swap(mEntryBytes, other.mEntryBytes);
+}
+
+//====================================================================
+//		CollectRecords : Records in alphabetical order
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::CollectRecords(std::vector<CAddressRecordPtr>& outRecords) const
+{
+    outRecords.reserve(outRecords.size() + mEntryCount);
+    PreOrderCollect(mRootNode.get(), outRecords);
+}
+
+//====================================================================
+//		CollectRecords : Records whose key starts with the lower case key
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::CollectRecords(const std::string& key, CAddressRecordStream& outRecords) const
+{
+    const TrieNode* node = FindNode(key);
+    if (node != nullptr)
+    {
+        PreOrderCollect(node, outRecords);
+    }
+}
+
+//====================================================================
+//		CountRecords : Number of records whose key starts with the lower case key, up to limit
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+size_t CAddressTrie<Alphabet, KeyPolicy>::CountRecords(const std::string& key, size_t limit) const
+{
+    size_t count = 0;
+    const TrieNode* node = FindNode(key);
+    if (node != nullptr)
+    {
+        PreOrderCount(node, limit, count);
+    }
+
+    return std::min(count, limit);
+}
+
+//====================================================================
+//		CollectTopRecords : Highest ranked records whose key starts with key
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::CollectTopRecords(const std::string& key, size_t count, std::vector<const CAddressRecord*>& outRecords) const
+{
+    const TrieNode* node = FindNode(key);
+    if (node == nullptr || count == 0)
+    {
+        return;
+    }
+
+    // Short rankings are cached by the node, the walk to it is all they cost once fresh
+    if (count <= kAddressBookRankedTopCount)
+    {
+        RankSubtree(node);
+        count = std::min(count, node->mTopRecords.size());
+        outRecords.insert(outRecords.end(), node->mTopRecords.cbegin(), node->mTopRecords.cbegin() + count);
+        return;
+    }
+
+    CAddressRecordStream records;
+    PreOrderCollect(node, records);
+
+    count = std::min(count, records.size());
+    std::partial_sort(records.begin(), records.begin() + count, records.end(), CAddressRecordRank());
+    outRecords.insert(outRecords.end(), records.cbegin(), records.cbegin() + count);
+}
+
+//====================================================================
+//		InvalidateRanking : Mark rankings along the entry's key stale
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::InvalidateRanking(const AddressEntry& addressEntry) noexcept
+{
+    // Nodes are allocated up to the key before a record is committed, the walk stops early otherwise
+    const TrieNode* currentNode = mRootNode.get();
+    for (const char& c : KeyPolicy::Get(addressEntry))
+    {
+        currentNode->mTopValid = false;
+
+        uint32_t index = Alphabet::Index(c);
+        currentNode = (index != kAddressTrieInvalidIndex) ? currentNode->mCharacters[index].get() : nullptr;
+        if (currentNode == nullptr)
+        {
+            return;
+        }
+    }
+
+    currentNode->mTopValid = false;
+}
+
+//====================================================================
+//		GetMemoryUsage : Count live and dead nodes
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::GetMemoryUsage(AddressBookMemoryUsage& outUsage) const
 {
-    mRootNode.reset(new CAddressTrieNode);
+    // Root is always needed
+    if (!CountNodes(mRootNode.get(), outUsage))
+    {
+        outUsage.mDeadNodes--;
+        outUsage.mLiveNodes++;
+    }
+
+    outUsage.mEntries += mEntryCount;
+    outUsage.mBytes += GetMetrics().mBytes;
+}
+
+//====================================================================
+//		GetEntryCount : Number of entries held by trie
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+size_t CAddressTrie<Alphabet, KeyPolicy>::GetEntryCount() const
+{
+    return mEntryCount;
+}
+
+//====================================================================
+//		GetMetrics : Node, entry and approximate memory counts
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+AddressTrieMetrics CAddressTrie<Alphabet, KeyPolicy>::GetMetrics() const
+{
+    AddressTrieMetrics metrics;
+    metrics.mNodeCount = mNodeCount;
+    metrics.mEntryCount = mEntryCount;
+    metrics.mBytes = mNodeCount * sizeof(TrieNode) + mEntryBytes;
+
+    return metrics;
 }
 
 //====================================================================
 //		PreOrderTraverse : Traverse trie in preorder DFS
 //====================================================================
-void CAddressTrie::PreOrderTraverse(CAddressTrieNode* currentNode,
-                                    AddressEntries& outAddresses,
-                                    AddressDuplicateLookup& duplicatesHash,
-                                    const EntryPredicate& predicate) const
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::PreOrderTraverse(const TrieNode* currentNode,
+                                                         AddressEntries& outAddresses,
+                                                         AddressDuplicateLookup& duplicatesHash,
+                                                         const EntryPredicate& predicate) const
 {
     // Add entries that passes predicate and populate duplicate lookup
     for (const auto& entry : currentNode->mEntries)
     {
-        if (predicate(*entry.get()))
+        if (predicate(entry->mEntry))
         {
-            outAddresses.emplace_back(*entry.get());
-            duplicatesHash.emplace(entry.get());
+            outAddresses.emplace_back(entry->mEntry);
+            duplicatesHash.emplace(&entry->mEntry);
         }
     }
 
     // Go through all nodes
-    for (int i = 0; i < kAddressTrieCharactersMax; i++)
+    for (uint32_t i = 0; i < Alphabet::kSize; i++)
     {
-        CAddressTrieNode* nextNode = currentNode->mCharacters[i].get();
+        TrieNode* nextNode = currentNode->mCharacters[i].get();
         if (nextNode != nullptr)
         {
             PreOrderTraverse(nextNode, outAddresses, duplicatesHash, predicate);
@@ -238,22 +449,282 @@ void CAddressTrie::PreOrderTraverse(CAddressTrieNode* currentNode,
 //====================================================================
 //		PreOrderTraverse : Process each entry in preorder DFS
 //====================================================================
-void CAddressTrie::PreOrderTraverseForEach(CAddressTrieNode* currentNode,
-                                           const AddressEntryCallback& callback) const
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::PreOrderTraverseForEach(const TrieNode* currentNode,
+                                                                const AddressEntryCallback& callback) const
 {
     // Process entries in current node
     for (const auto& entry : currentNode->mEntries)
     {
-        callback(*entry.get());
+        callback(entry->mEntry);
     }
 
     // Go through all nodes
-    for (int i = 0; i < kAddressTrieCharactersMax; i++)
+    for (uint32_t i = 0; i < Alphabet::kSize; i++)
     {
-        CAddressTrieNode* nextNode = currentNode->mCharacters[i].get();
+        TrieNode* nextNode = currentNode->mCharacters[i].get();
         if (nextNode != nullptr)
         {
             PreOrderTraverseForEach(nextNode, callback);
         }
     }
-}
\ No newline at end of file
+}
+
+//====================================================================
+//		PreOrderPartition : Split trie in preorder DFS down to given depth
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::PreOrderPartition(const TrieNode* currentNode,
+                                                          uint32_t depth,
+                                                          std::vector<TriePartition>& outPartitions) const
+{
+    // Remaining subtree becomes a single partition
+    if (depth == 0)
+    {
+        outPartitions.push_back({ currentNode, true });
+        return;
+    }
+
+    // Entries of the current node come before its children
+    if (!currentNode->mEntries.empty())
+    {
+        outPartitions.push_back({ currentNode, false });
+    }
+
+    // Go through all nodes
+    for (uint32_t i = 0; i < Alphabet::kSize; i++)
+    {
+        const TrieNode* nextNode = currentNode->mCharacters[i].get();
+        if (nextNode != nullptr)
+        {
+            PreOrderPartition(nextNode, depth - 1, outPartitions);
+        }
+    }
+}
+
+//====================================================================
+//		PreOrderCollect : Gather records in preorder DFS
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::PreOrderCollect(const TrieNode* currentNode,
+                                                        std::vector<CAddressRecordPtr>& outRecords) const
+{
+    outRecords.insert(outRecords.end(), currentNode->mEntries.begin(), currentNode->mEntries.end());
+
+    // Go through all nodes
+    for (uint32_t i = 0; i < Alphabet::kSize; i++)
+    {
+        const TrieNode* nextNode = currentNode->mCharacters[i].get();
+        if (nextNode != nullptr)
+        {
+            PreOrderCollect(nextNode, outRecords);
+        }
+    }
+}
+
+//====================================================================
+//		PreOrderCollect : Gather records in preorder DFS, without sharing them
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::PreOrderCollect(const TrieNode* currentNode,
+                                                        CAddressRecordStream& outRecords) const
+{
+    for (const auto& record : currentNode->mEntries)
+    {
+        outRecords.push_back(record.get());
+    }
+
+    // Go through all nodes
+    for (uint32_t i = 0; i < Alphabet::kSize; i++)
+    {
+        const TrieNode* nextNode = currentNode->mCharacters[i].get();
+        if (nextNode != nullptr)
+        {
+            PreOrderCollect(nextNode, outRecords);
+        }
+    }
+}
+
+//====================================================================
+//		PreOrderCount : Count records in preorder DFS, stopping once limit is reached
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::PreOrderCount(const TrieNode* currentNode,
+                                                      size_t limit,
+                                                      size_t& outCount) const
+{
+    outCount += currentNode->mEntries.size();
+
+    // Go through nodes until enough records are seen
+    for (uint32_t i = 0; i < Alphabet::kSize && outCount < limit; i++)
+    {
+        const TrieNode* nextNode = currentNode->mCharacters[i].get();
+        if (nextNode != nullptr)
+        {
+            PreOrderCount(nextNode, limit, outCount);
+        }
+    }
+}
+
+//====================================================================
+//		CountNodes : Count live and dead nodes of a subtree,
+//                   returns whether the subtree holds any entry
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+bool CAddressTrie<Alphabet, KeyPolicy>::CountNodes(const TrieNode* currentNode,
+                                                   AddressBookMemoryUsage& outUsage) const
+{
+    bool live = !currentNode->mEntries.empty();
+
+    // Go through all nodes
+    for (uint32_t i = 0; i < Alphabet::kSize; i++)
+    {
+        const TrieNode* nextNode = currentNode->mCharacters[i].get();
+        if (nextNode != nullptr && CountNodes(nextNode, outUsage))
+        {
+            live = true;
+        }
+    }
+
+    if (live)
+    {
+        outUsage.mLiveNodes++;
+    }
+    else
+    {
+        outUsage.mDeadNodes++;
+    }
+
+    return live;
+}
+
+//====================================================================
+//		RankSubtree : Rebuild stale rankings of node and below,
+//                    a fresh node only has fresh nodes below it
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::RankSubtree(const TrieNode* currentNode) const
+{
+    if (currentNode->mTopValid)
+    {
+        return;
+    }
+
+    // Every record ranked in the subtree is among its own records or the top records of a child
+    std::vector<const CAddressRecord*> candidates;
+    for (const auto& record : currentNode->mEntries)
+    {
+        candidates.push_back(record.get());
+    }
+
+    // Go through all nodes
+    for (uint32_t i = 0; i < Alphabet::kSize; i++)
+    {
+        const TrieNode* nextNode = currentNode->mCharacters[i].get();
+        if (nextNode != nullptr)
+        {
+            RankSubtree(nextNode);
+            candidates.insert(candidates.end(), nextNode->mTopRecords.cbegin(), nextNode->mTopRecords.cend());
+        }
+    }
+
+    size_t count = std::min(kAddressBookRankedTopCount, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), CAddressRecordRank());
+
+    currentNode->mTopRecords.assign(candidates.cbegin(), candidates.cbegin() + count);
+    currentNode->mTopValid = true;
+}
+
+//====================================================================
+//		IsValidKey : Check if the alphabet has a slot for every character of key
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+bool CAddressTrie<Alphabet, KeyPolicy>::IsValidKey(const std::string& key)
+{
+    return std::all_of(key.cbegin(), key.cend(), [](const char& c) { return Alphabet::Index(c) != kAddressTrieInvalidIndex; });
+}
+
+//====================================================================
+//		FindNode : Node at the end of key, or null
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+const CAddressTrieNode<Alphabet>* CAddressTrie<Alphabet, KeyPolicy>::FindNode(const std::string& key) const
+{
+    const TrieNode* currentNode = mRootNode.get();
+    for (const char& c : key)
+    {
+        // Characters without a child slot can't be in the trie
+        uint32_t index = Alphabet::Index(c);
+        if (index == kAddressTrieInvalidIndex)
+        {
+            return nullptr;
+        }
+
+        // If no node is present means we don't have the entry
+        currentNode = currentNode->mCharacters[index].get();
+        if (currentNode == nullptr)
+        {
+            return nullptr;
+        }
+    }
+
+    return currentNode;
+}
+
+//====================================================================
+//		PruneBranch : Free the branch at the end of key if nothing is left below it
+//====================================================================
+template <typename Alphabet, typename KeyPolicy>
+void CAddressTrie<Alphabet, KeyPolicy>::PruneBranch(const std::string& key) noexcept
+{
+    // Traverse trie, remembering where the branch only kept alive by this key starts
+    TrieNode* currentNode = mRootNode.get();
+    TrieNode* pruneParent = currentNode;
+    uint32_t pruneIndex = 0;
+    size_t pruneDepth = 0;
+
+    for (size_t depth = 0; depth < key.size(); depth++)
+    {
+        // Characters without a child slot can't be in the trie
+        uint32_t index = Alphabet::Index(key[depth]);
+        if (index == kAddressTrieInvalidIndex)
+        {
+            return;
+        }
+
+        // Branch may already be gone
+        TrieNode* nextNode = currentNode->mCharacters[index].get();
+        if (nextNode == nullptr)
+        {
+            return;
+        }
+
+        // Nodes holding entries or other branches must stay
+        if (depth == 0 || !currentNode->mEntries.empty() || currentNode->mChildCount > 1)
+        {
+            pruneParent = currentNode;
+            pruneIndex = index;
+            pruneDepth = depth;
+        }
+
+        currentNode = nextNode;
+    }
+
+    if (currentNode->mEntries.empty() && currentNode->mChildCount == 0)
+    {
+        pruneParent->mCharacters[pruneIndex].reset();
+        pruneParent->mChildCount--;
+        mNodeCount -= key.size() - pruneDepth;
+    }
+}
+
+//=======================================================
+//		Instantiations
+//=======================================================
+template class CAddressTrie<CAddressLetterAlphabet, CAddressFirstNameKey>;
+template class CAddressTrie<CAddressLetterAlphabet, CAddressLastNameKey>;
+template class CAddressTrie<CAddressFoldedAlphabet, CAddressFirstNameKey>;
+template class CAddressTrie<CAddressFoldedAlphabet, CAddressLastNameKey>;
+template class CAddressTrie<CAddressByteAlphabet, CAddressFirstNameKey>;
+template class CAddressTrie<CAddressByteAlphabet, CAddressLastNameKey>;
+template class CAddressTrie<CAddressDigitAlphabet, CAddressPhoneNumberKey>;
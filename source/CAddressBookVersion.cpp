@@ -0,0 +1,37 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressBookVersion.h"
+
+//=======================================================
+//		CAddressBookVersion
+//=======================================================
+CAddressBookVersion::CAddressBookVersion(uint64_t version, const std::vector<CAddressRecordPtr>& records) :
+    mVersion(version),
+    mpBook(std::make_shared<const CAddressFrozenBook>(records))
+{
+
+}
+
+CAddressBookVersion::CAddressBookVersion(uint64_t version, std::shared_ptr<const CAddressFrozenBook> pBook) :
+    mVersion(version),
+    mpBook(std::move(pBook))
+{
+
+}
+
+//=======================================================
+//		GetVersion : Book generation the copy was taken at
+//=======================================================
+uint64_t CAddressBookVersion::GetVersion() const
+{
+    return mVersion;
+}
+
+//=======================================================
+//		GetBook : Packed entries of the version
+//=======================================================
+const CAddressFrozenBook& CAddressBookVersion::GetBook() const
+{
+    return *mpBook;
+}
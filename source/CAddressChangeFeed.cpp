@@ -0,0 +1,250 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressChangeFeed.h"
+
+//=======================================================
+//		AppendLittleEndian : Append the low *bytes* bytes of value, least significant first
+//=======================================================
+static void AppendLittleEndian(uint64_t value, size_t bytes, std::string& outBuffer)
+{
+    for (size_t i = 0; i < bytes; i++)
+    {
+        outBuffer.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+//=======================================================
+//		ReadLittleEndian : Read *bytes* bytes, least significant first
+//=======================================================
+static uint64_t ReadLittleEndian(const char* data, size_t bytes)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++)
+    {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << (8 * i);
+    }
+
+    return value;
+}
+
+//=======================================================
+//		CAddressChangeFeed
+//=======================================================
+CAddressChangeFeed::CAddressChangeFeed() :
+    mFirstSequence(1),
+    mLastSequence(0),
+    mLogStatus(AddressEntryError::kAddressEntrySuccess)
+{
+
+}
+
+//=======================================================
+//		SetCapacity : Keep up to capacity latest changes, zero disables the ring
+//=======================================================
+void CAddressChangeFeed::SetCapacity(size_t capacity)
+{
+    std::vector<AddressChange> ring(capacity);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRing.swap(ring);
+
+    // Changes published before are dropped, readers behind this point must resynchronise
+    mFirstSequence = mLastSequence + 1;
+}
+
+//=======================================================
+//		SetLog : Append changes to the file at path, an empty path closes the log
+//=======================================================
+AddressEntryError CAddressChangeFeed::SetLog(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mLog.is_open())
+    {
+        mLog.close();
+    }
+
+    mLogStatus = AddressEntryError::kAddressEntrySuccess;
+    if (path.empty())
+    {
+        return AddressEntryError::kAddressEntrySuccess;
+    }
+
+    mLog.clear();
+    mLog.open(path, std::ios::binary | std::ios::app);
+
+    return mLog.is_open() ? AddressEntryError::kAddressEntrySuccess : AddressEntryError::kAddressEntryIOFailure;
+}
+
+//=======================================================
+//		GetLogStatus : kAddressEntryIOFailure once a write to the log failed and closed it
+//=======================================================
+AddressEntryError CAddressChangeFeed::GetLogStatus() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mLogStatus;
+}
+
+//=======================================================
+//		IsEnabled : Check if changes are kept anywhere
+//=======================================================
+bool CAddressChangeFeed::IsEnabled() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return !mRing.empty() || mLog.is_open();
+}
+
+//=======================================================
+//		Publish : Number changes and publish them in order
+//=======================================================
+void CAddressChangeFeed::Publish(AddressChanges& changes) noexcept
+{
+    if (changes.empty())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto& change : changes)
+        {
+            change.mSequence = ++mLastSequence;
+        }
+
+        if (mLog.is_open())
+        {
+            try
+            {
+                mLogBuffer.clear();
+                for (const auto& change : changes)
+                {
+                    Encode(change, mLogBuffer);
+                }
+
+                // Flushed per batch, so followers tailing the file see every commit
+                mLog.write(mLogBuffer.data(), mLogBuffer.size());
+                mLog.flush();
+            }
+            catch (...)
+            {
+            }
+
+            // Changes missing from the log would desynchronise its followers, so it is closed
+            // rather than left with a gap, and the failure is kept for the owner to notice
+            if (!mLog.good())
+            {
+                mLog.close();
+                mLogStatus = AddressEntryError::kAddressEntryIOFailure;
+            }
+        }
+
+        // Moving into preallocated slots does not allocate
+        if (!mRing.empty())
+        {
+            for (auto& change : changes)
+            {
+                mRing[change.mSequence % mRing.size()] = std::move(change);
+            }
+
+            if (mLastSequence - mFirstSequence >= mRing.size())
+            {
+                mFirstSequence = mLastSequence - mRing.size() + 1;
+            }
+        }
+    }
+
+    mPublished.notify_all();
+}
+
+//=======================================================
+//		Read : Changes after sequence, waiting up to timeout for the first one
+//=======================================================
+AddressEntryError CAddressChangeFeed::Read(uint64_t afterSequence,
+                                           size_t maxCount,
+                                           std::chrono::milliseconds timeout,
+                                           AddressChanges& outChanges) const
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (afterSequence + 1 < mFirstSequence)
+    {
+        return AddressEntryError::kAddressEntryOutOfSequence;
+    }
+
+    mPublished.wait_for(lock, timeout, [this, afterSequence]() { return mLastSequence > afterSequence; });
+
+    // Ring may have been resized or overrun while waiting
+    if (afterSequence + 1 < mFirstSequence || (mRing.empty() && mLastSequence > afterSequence))
+    {
+        return AddressEntryError::kAddressEntryOutOfSequence;
+    }
+
+    for (uint64_t sequence = afterSequence + 1; sequence <= mLastSequence && maxCount > 0; sequence++, maxCount--)
+    {
+        outChanges.push_back(mRing[sequence % mRing.size()]);
+    }
+
+    return AddressEntryError::kAddressEntrySuccess;
+}
+
+//=======================================================
+//		GetLastSequence : Sequence of the latest published change
+//=======================================================
+uint64_t CAddressChangeFeed::GetLastSequence() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mLastSequence;
+}
+
+//=======================================================
+//		Encode : Append the log record of change to buffer
+//		sequence (8), type (1), three field lengths (4 each) then the field bytes, little endian
+//=======================================================
+void CAddressChangeFeed::Encode(const AddressChange& change, std::string& outBuffer)
+{
+    const AddressEntry& entry = change.mEntry;
+
+    AppendLittleEndian(change.mSequence, sizeof(uint64_t), outBuffer);
+    AppendLittleEndian(static_cast<uint8_t>(change.mType), sizeof(uint8_t), outBuffer);
+    for (const std::string* field : { &entry.mFirstName, &entry.mLastName, &entry.mPhoneNumber })
+    {
+        AppendLittleEndian(field->size(), sizeof(uint32_t), outBuffer);
+    }
+
+    outBuffer.append(entry.mFirstName).append(entry.mLastName).append(entry.mPhoneNumber);
+}
+
+//=======================================================
+//		Decode : Decode the log record at the start of data
+//=======================================================
+size_t CAddressChangeFeed::Decode(const char* data, size_t size, AddressChange& outChange)
+{
+    if (size < kAddressChangeHeaderBytes)
+    {
+        return 0;
+    }
+
+    size_t lengths[3];
+    size_t recordBytes = kAddressChangeHeaderBytes;
+    for (size_t i = 0; i < 3; i++)
+    {
+        lengths[i] = ReadLittleEndian(data + sizeof(uint64_t) + sizeof(uint8_t) + i * sizeof(uint32_t), sizeof(uint32_t));
+        recordBytes += lengths[i];
+    }
+
+    if (size < recordBytes)
+    {
+        return 0;
+    }
+
+    outChange.mSequence = ReadLittleEndian(data, sizeof(uint64_t));
+    outChange.mType = static_cast<AddressChangeType>(ReadLittleEndian(data + sizeof(uint64_t), sizeof(uint8_t)));
+
+    const char* field = data + kAddressChangeHeaderBytes;
+    outChange.mEntry.mFirstName.assign(field, lengths[0]);
+    field += lengths[0];
+    outChange.mEntry.mLastName.assign(field, lengths[1]);
+    field += lengths[1];
+    outChange.mEntry.mPhoneNumber.assign(field, lengths[2]);
+
+    return recordBytes;
+}
@@ -0,0 +1,427 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressEntryStore.h"
+
+//=======================================================
+//		Constants
+//=======================================================
+// Appended records are written out once this many bytes are buffered
+constexpr size_t kAddressEntryWriteBufferBytes = 1 << 20;
+
+//=======================================================
+//		AppendLittleEndian : Append the low *bytes* bytes of value, least significant first
+//=======================================================
+static void AppendLittleEndian(uint64_t value, size_t bytes, std::string& outBuffer)
+{
+    for (size_t i = 0; i < bytes; i++)
+    {
+        outBuffer.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+//=======================================================
+//		ReadLittleEndian : Read *bytes* bytes, least significant first
+//=======================================================
+static uint64_t ReadLittleEndian(const char* data, size_t bytes)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; i++)
+    {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << (8 * i);
+    }
+
+    return value;
+}
+
+//=======================================================
+//		FieldBytes : Bytes of the fields following a payload record header
+//=======================================================
+static size_t FieldBytes(const char* header)
+{
+    size_t bytes = 0;
+    for (size_t i = 0; i < 3; i++)
+    {
+        bytes += ReadLittleEndian(header + i * sizeof(uint32_t), sizeof(uint32_t));
+    }
+
+    return bytes;
+}
+
+//=======================================================
+//		CAddressEntryStore
+//=======================================================
+CAddressEntryStore::CAddressEntryStore(const CAddressTierOptions& options) :
+    mPayloadBytes(0),
+    mCacheBudgetBytes(0),
+    mShardPageCapacity(0),
+    mHits(0),
+    mMisses(0),
+    mEvictions(0),
+    mScannedEntries(0),
+    mCachedBytes(0)
+{
+    if (options.mDirectory.empty())
+    {
+        return;
+    }
+
+    // Every store gets its own file, a book being frozen never writes over the payload of one still being read
+    static std::atomic<uint64_t> nextFileId(0);
+    uint64_t timestamp = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+
+    mPath = options.mDirectory + "/addressbook-" + std::to_string(timestamp) + "-" + std::to_string(nextFileId++) + ".payload";
+    mWriter.open(mPath, std::ios::binary | std::ios::trunc);
+    if (!mWriter.is_open())
+    {
+        mPath.clear();
+        throw std::ios_base::failure("Cannot create payload file in " + options.mDirectory);
+    }
+
+    // Each shard keeps at least one page so a record spanning two pages can always be read
+    mCacheBudgetBytes = options.mCacheBytes;
+    mShardPageCapacity = std::max<size_t>(1, options.mCacheBytes / kAddressEntryPageBytes / kAddressEntryCacheShards);
+}
+
+//=======================================================
+//		~CAddressEntryStore
+//=======================================================
+CAddressEntryStore::~CAddressEntryStore()
+{
+    if (mPath.empty())
+    {
+        return;
+    }
+
+    mWriter.close();
+    for (auto& shard : mShards)
+    {
+        shard.mFile.close();
+    }
+
+    std::remove(mPath.c_str());
+}
+
+//=======================================================
+//		Reserve
+//=======================================================
+void CAddressEntryStore::Reserve(size_t count)
+{
+    if (IsTiered())
+    {
+        mOffsets.reserve(count);
+    }
+    else
+    {
+        mEntries.reserve(count);
+    }
+}
+
+//=======================================================
+//		Append : Append entry at the next index
+//		tiered records are the three field lengths (4 each) then the field bytes, little endian
+//=======================================================
+void CAddressEntryStore::Append(const AddressEntry& entry)
+{
+    if (!IsTiered())
+    {
+        mEntries.push_back(entry);
+        return;
+    }
+
+    mOffsets.push_back(mPayloadBytes);
+
+    size_t bufferSize = mWriteBuffer.size();
+    for (const std::string* field : { &entry.mFirstName, &entry.mLastName, &entry.mPhoneNumber })
+    {
+        AppendLittleEndian(field->size(), sizeof(uint32_t), mWriteBuffer);
+    }
+
+    mWriteBuffer.append(entry.mFirstName).append(entry.mLastName).append(entry.mPhoneNumber);
+    mPayloadBytes += mWriteBuffer.size() - bufferSize;
+
+    if (mWriteBuffer.size() >= kAddressEntryWriteBufferBytes)
+    {
+        mWriter.write(mWriteBuffer.data(), mWriteBuffer.size());
+        mWriteBuffer.clear();
+    }
+}
+
+//=======================================================
+//		Seal : Finish appending
+//=======================================================
+void CAddressEntryStore::Seal()
+{
+    if (!IsTiered())
+    {
+        mEntries.shrink_to_fit();
+        return;
+    }
+
+    mWriter.write(mWriteBuffer.data(), mWriteBuffer.size());
+    mWriter.flush();
+
+    bool written = mWriter.good();
+    mWriter.close();
+    mWriteBuffer.clear();
+    mWriteBuffer.shrink_to_fit();
+    mOffsets.shrink_to_fit();
+
+    if (!written)
+    {
+        throw std::ios_base::failure("Cannot write payload file " + mPath);
+    }
+
+    for (auto& shard : mShards)
+    {
+        shard.mFile.open(mPath, std::ios::binary);
+        if (!shard.mFile.is_open())
+        {
+            throw std::ios_base::failure("Cannot open payload file " + mPath);
+        }
+    }
+}
+
+//=======================================================
+//		GetCount
+//=======================================================
+size_t CAddressEntryStore::GetCount() const
+{
+    return IsTiered() ? mOffsets.size() : mEntries.size();
+}
+
+//=======================================================
+//		IsTiered
+//=======================================================
+bool CAddressEntryStore::IsTiered() const
+{
+    return !mPath.empty();
+}
+
+//=======================================================
+//		Read : Copy of the entry at index
+//=======================================================
+void CAddressEntryStore::Read(uint32_t index, AddressEntry& outEntry) const
+{
+    if (!IsTiered())
+    {
+        outEntry = mEntries[index];
+        return;
+    }
+
+    uint64_t offset = mOffsets[index];
+    uint64_t pageNumber = offset / kAddressEntryPageBytes;
+    size_t pageOffset = static_cast<size_t>(offset % kAddressEntryPageBytes);
+
+    // Most records fit in one page and are decoded straight from it
+    {
+        CCacheShard& shard = mShards[pageNumber % kAddressEntryCacheShards];
+        std::lock_guard<std::mutex> lock(shard.mMutex);
+
+        const std::string& page = FetchPage(shard, pageNumber);
+        if (pageOffset + kAddressEntryRecordHeaderBytes <= page.size())
+        {
+            const char* header = page.data() + pageOffset;
+            if (pageOffset + kAddressEntryRecordHeaderBytes + FieldBytes(header) <= page.size())
+            {
+                DecodeEntry(header, header + kAddressEntryRecordHeaderBytes, outEntry);
+                return;
+            }
+        }
+    }
+
+    char header[kAddressEntryRecordHeaderBytes];
+    ReadBytes(offset, sizeof(header), header);
+
+    std::string fields(FieldBytes(header), '\0');
+    ReadBytes(offset + sizeof(header), fields.size(), &fields[0]);
+
+    DecodeEntry(header, fields.data(), outEntry);
+}
+
+//=======================================================
+//		Read : Copy of the entry at index
+//=======================================================
+AddressEntry CAddressEntryStore::Read(uint32_t index) const
+{
+    AddressEntry entry;
+    Read(index, entry);
+    return entry;
+}
+
+//=======================================================
+//		Scan : Pass entries [begin, end) in index order to callback
+//=======================================================
+void CAddressEntryStore::Scan(uint32_t begin, uint32_t end, const std::function<void(uint32_t, const AddressEntry&)>& callback) const
+{
+    if (!IsTiered())
+    {
+        for (uint32_t i = begin; i < end; i++)
+        {
+            callback(i, mEntries[i]);
+        }
+
+        return;
+    }
+
+    if (begin >= end)
+    {
+        return;
+    }
+
+    // Records are laid out in index order, so a range is one contiguous run of the file
+    std::ifstream file(mPath, std::ios::binary);
+    file.seekg(static_cast<std::streamoff>(mOffsets[begin]));
+
+    AddressEntry entry;
+    std::string fields;
+    for (uint32_t i = begin; i < end; i++)
+    {
+        char header[kAddressEntryRecordHeaderBytes];
+        file.read(header, sizeof(header));
+
+        fields.resize(FieldBytes(header));
+        file.read(&fields[0], fields.size());
+        if (!file.good())
+        {
+            throw std::ios_base::failure("Cannot read payload file " + mPath);
+        }
+
+        DecodeEntry(header, fields.data(), entry);
+        mScannedEntries.fetch_add(1, std::memory_order_relaxed);
+        callback(i, entry);
+    }
+}
+
+//=======================================================
+//		GetStats : Page cache counters
+//=======================================================
+AddressBookTierStats CAddressEntryStore::GetStats() const
+{
+    AddressBookTierStats stats;
+    stats.mEntryCount = GetCount();
+    if (!IsTiered())
+    {
+        return stats;
+    }
+
+    stats.mTiered = true;
+    stats.mHits = mHits.load(std::memory_order_relaxed);
+    stats.mMisses = mMisses.load(std::memory_order_relaxed);
+    stats.mEvictions = mEvictions.load(std::memory_order_relaxed);
+    stats.mScannedEntries = mScannedEntries.load(std::memory_order_relaxed);
+    stats.mPayloadBytes = mPayloadBytes;
+    stats.mCachedBytes = mCachedBytes.load(std::memory_order_relaxed);
+    stats.mBudgetBytes = mCacheBudgetBytes;
+    return stats;
+}
+
+//=======================================================
+//		GetMemoryBytes : Approximate heap bytes held in memory
+//=======================================================
+size_t CAddressEntryStore::GetMemoryBytes() const
+{
+    if (IsTiered())
+    {
+        return mOffsets.capacity() * sizeof(uint64_t) + mCachedBytes.load(std::memory_order_relaxed);
+    }
+
+    size_t bytes = mEntries.capacity() * sizeof(AddressEntry);
+
+    // Strings up to this capacity are stored inline by common implementations
+    constexpr size_t kInlineStringCapacity = 15;
+
+    for (const auto& entry : mEntries)
+    {
+        for (const std::string* str : { &entry.mFirstName, &entry.mLastName, &entry.mPhoneNumber })
+        {
+            if (str->capacity() > kInlineStringCapacity)
+            {
+                bytes += str->capacity() + 1;
+            }
+        }
+    }
+
+    return bytes;
+}
+
+//=======================================================
+//		ReadBytes : Copy bytes of the payload file through the page cache
+//=======================================================
+void CAddressEntryStore::ReadBytes(uint64_t offset, size_t size, char* outBytes) const
+{
+    while (size > 0)
+    {
+        uint64_t pageNumber = offset / kAddressEntryPageBytes;
+        size_t pageOffset = static_cast<size_t>(offset % kAddressEntryPageBytes);
+        size_t count = std::min(size, kAddressEntryPageBytes - pageOffset);
+
+        CCacheShard& shard = mShards[pageNumber % kAddressEntryCacheShards];
+        std::lock_guard<std::mutex> lock(shard.mMutex);
+
+        const std::string& page = FetchPage(shard, pageNumber);
+        if (page.size() < pageOffset + count)
+        {
+            throw std::ios_base::failure("Cannot read payload file " + mPath);
+        }
+
+        std::copy_n(page.data() + pageOffset, count, outBytes);
+
+        offset += count;
+        outBytes += count;
+        size -= count;
+    }
+}
+
+//=======================================================
+//		FetchPage : Page of the payload file, cached or read in, shard lock must be held
+//=======================================================
+const std::string& CAddressEntryStore::FetchPage(CCacheShard& shard, uint64_t pageNumber) const
+{
+    auto it = shard.mPageIndex.find(pageNumber);
+    if (it != shard.mPageIndex.end())
+    {
+        mHits.fetch_add(1, std::memory_order_relaxed);
+        shard.mPages.splice(shard.mPages.begin(), shard.mPages, it->second);
+        return shard.mPages.front().mData;
+    }
+
+    mMisses.fetch_add(1, std::memory_order_relaxed);
+
+    CPage page{ pageNumber, std::string(kAddressEntryPageBytes, '\0') };
+    shard.mFile.clear();
+    shard.mFile.seekg(static_cast<std::streamoff>(pageNumber * kAddressEntryPageBytes));
+    shard.mFile.read(&page.mData[0], kAddressEntryPageBytes);
+
+    // The last page is short
+    page.mData.resize(static_cast<size_t>(shard.mFile.gcount()));
+    page.mData.shrink_to_fit();
+
+    if (shard.mPages.size() >= mShardPageCapacity)
+    {
+        mCachedBytes.fetch_sub(shard.mPages.back().mData.size(), std::memory_order_relaxed);
+        mEvictions.fetch_add(1, std::memory_order_relaxed);
+        shard.mPageIndex.erase(shard.mPages.back().mNumber);
+        shard.mPages.pop_back();
+    }
+
+    mCachedBytes.fetch_add(page.mData.size(), std::memory_order_relaxed);
+    shard.mPages.push_front(std::move(page));
+    shard.mPageIndex.emplace(pageNumber, shard.mPages.begin());
+
+    return shard.mPages.front().mData;
+}
+
+//=======================================================
+//		DecodeEntry : Decode the payload record of entry
+//=======================================================
+void CAddressEntryStore::DecodeEntry(const char* header, const char* fields, AddressEntry& outEntry)
+{
+    std::string* outFields[] = { &outEntry.mFirstName, &outEntry.mLastName, &outEntry.mPhoneNumber };
+    for (size_t i = 0; i < 3; i++)
+    {
+        size_t length = ReadLittleEndian(header + i * sizeof(uint32_t), sizeof(uint32_t));
+        outFields[i]->assign(fields, length);
+        fields += length;
+    }
+}
@@ -0,0 +1,147 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressEntryStreamState.h"
+
+//=======================================================
+//		CAddressEntryStreamState
+//=======================================================
+CAddressEntryStreamState::CAddressEntryStreamState(size_t chunkSize) :
+    mChunkSize(std::max<size_t>(1, chunkSize)),
+    mClosed(false),
+    mCancelled(false)
+{
+
+}
+
+//=======================================================
+//		Write : Hand over entries to be read in chunks, never waits on the consumer
+//=======================================================
+bool CAddressEntryStreamState::Write(AddressEntries&& entries)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (mCancelled)
+    {
+        return false;
+    }
+
+    // The entries are built already, so holding them here costs nothing more and frees the producer's thread
+    mEntries.splice(mEntries.cend(), entries);
+    if (!mEntries.empty())
+    {
+        NotifyReady(lock);
+    }
+
+    return true;
+}
+
+//=======================================================
+//		Close : Mark end of stream
+//=======================================================
+void CAddressEntryStreamState::Close()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mClosed = true;
+    NotifyReady(lock);
+}
+
+//=======================================================
+//		Fail : End stream with an error to be rethrown to the consumer
+//=======================================================
+void CAddressEntryStreamState::Fail(std::exception_ptr error)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mError = error;
+    mClosed = true;
+    NotifyReady(lock);
+}
+
+//=======================================================
+//		Read : Cut next chunk off the entries, optionally waiting for one
+//=======================================================
+AddressEntryStreamStatus CAddressEntryStreamState::Read(AddressEntries& outChunk, bool wait)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (wait)
+    {
+        mCondition.wait(lock, [this]() { return mCancelled || mClosed || !mEntries.empty(); });
+    }
+
+    if (mCancelled)
+    {
+        return AddressEntryStreamStatus::kStreamCancelled;
+    }
+
+    if (!mEntries.empty())
+    {
+        auto chunkEnd = mEntries.begin();
+        std::advance(chunkEnd, std::min(mChunkSize, mEntries.size()));
+
+        outChunk.clear();
+        outChunk.splice(outChunk.cend(), mEntries, mEntries.begin(), chunkEnd);
+        return AddressEntryStreamStatus::kStreamChunk;
+    }
+
+    if (mClosed)
+    {
+        if (mError)
+        {
+            std::rethrow_exception(mError);
+        }
+
+        return AddressEntryStreamStatus::kStreamEnded;
+    }
+
+    return AddressEntryStreamStatus::kStreamPending;
+}
+
+//=======================================================
+//		SetReadyCallback : Notify on new chunks or end of stream
+//=======================================================
+void CAddressEntryStreamState::SetReadyCallback(const std::function<void()>& callback)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mReadyCallback = callback;
+
+    // Catch up on anything produced before the callback was set
+    if (!mEntries.empty() || mClosed)
+    {
+        NotifyReady(lock);
+    }
+}
+
+//=======================================================
+//		Cancel : Stop producing and drop pending entries
+//=======================================================
+void CAddressEntryStreamState::Cancel()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCancelled = true;
+    mEntries.clear();
+    mCondition.notify_all();
+}
+
+//=======================================================
+//		IsCancelled
+//=======================================================
+bool CAddressEntryStreamState::IsCancelled() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mCancelled;
+}
+
+//=======================================================
+//		NotifyReady : Wake waiters and invoke ready callback outside the lock
+//=======================================================
+void CAddressEntryStreamState::NotifyReady(std::unique_lock<std::mutex>& lock)
+{
+    mCondition.notify_all();
+
+    std::function<void()> readyCallback(mReadyCallback);
+    lock.unlock();
+
+    if (readyCallback)
+    {
+        readyCallback();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,724 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressFrozenBook.h"
+#include "CAddressBookTrie.h"
+
+// System
+#include <cctype>
+
+//=======================================================
+//		FoldCase : Lower case copy of a string
+//=======================================================
+static std::string FoldCase(const std::string& str)
+{
+    std::string folded(str);
+    LowerCaseString(folded);
+    return folded;
+}
+
+//=======================================================
+//		MatchesTerm : Check if entry's field starts with the term's prefix
+//=======================================================
+static bool MatchesTerm(const AddressEntry& entry, const AddressQueryTerm& term)
+{
+    switch (term.mField)
+    {
+    case AddressEntryField::FirstName:
+    case AddressEntryField::LastName:
+    {
+        const std::string& name = (term.mField == AddressEntryField::FirstName) ? entry.mFirstName : entry.mLastName;
+        return name.size() >= term.mPrefix.size() &&
+               std::equal(term.mPrefix.cbegin(), term.mPrefix.cend(), name.cbegin(), [](const char& lhs, const char& rhs)
+                   {
+                       return isalpha(lhs) && tolower(lhs) == tolower(rhs);
+                   });
+    }
+    case AddressEntryField::PhoneNumber:
+    {
+        return entry.mPhoneNumber.compare(0, term.mPrefix.size(), term.mPrefix) == 0 &&
+               std::all_of(term.mPrefix.cbegin(), term.mPrefix.cend(), [](const char& c) { return isdigit(c); });
+    }
+    default:
+        return false;
+    }
+}
+
+//=======================================================
+//		ContainsCaseInsensitive : Check if str contains the lower case key, ignoring case
+//=======================================================
+static bool ContainsCaseInsensitive(const std::string& str, const std::string& key)
+{
+    return std::search(str.cbegin(), str.cend(), key.cbegin(), key.cend(), [](const char& lhs, const char& rhs)
+        {
+            return tolower(lhs) == rhs;
+        }) != str.cend();
+}
+
+//=======================================================
+//		CAddressFrozenBook
+//=======================================================
+CAddressFrozenBook::CAddressFrozenBook(const std::vector<CAddressRecordPtr>& records,
+                                       const CAddressTierOptions& tierOptions /* = CAddressTierOptions() */) :
+    mEntries(tierOptions),
+    mFirstNameCount(0)
+{
+    using SortKey = std::pair<std::string, const CAddressRecord*>;
+    auto isBefore = [](const SortKey& lhs, const SortKey& rhs)
+    {
+        // Same key entries keep the order they were added in, like in the mutable tries
+        return lhs.first != rhs.first ? lhs.first < rhs.first : lhs.second->mId < rhs.second->mId;
+    };
+
+    // Lay entries out in ForEach order
+    std::vector<SortKey> firstNameKeys;
+    std::vector<SortKey> noFirstNameKeys;
+    for (const auto& record : records)
+    {
+        const AddressEntry& entry = record->mEntry;
+        if (!entry.mFirstName.empty())
+        {
+            firstNameKeys.emplace_back(FoldCase(entry.mFirstName + entry.mLastName), record.get());
+        }
+        else
+        {
+            noFirstNameKeys.emplace_back(FoldCase(entry.mLastName), record.get());
+        }
+    }
+
+    std::sort(firstNameKeys.begin(), firstNameKeys.end(), isBefore);
+    std::sort(noFirstNameKeys.begin(), noFirstNameKeys.end(), isBefore);
+
+    mEntries.Reserve(records.size());
+    mFirstNameCount = static_cast<uint32_t>(firstNameKeys.size());
+
+    std::vector<std::pair<std::string, uint32_t>> trieKeys;
+    trieKeys.reserve(firstNameKeys.size());
+    for (auto& key : firstNameKeys)
+    {
+        uint32_t index = static_cast<uint32_t>(mEntries.GetCount());
+        mEntries.Append(key.second->mEntry);
+
+        if (key.second->mEntry.mLastName.empty())
+        {
+            mNoLastNameEntries.push_back(index);
+        }
+
+        trieKeys.emplace_back(std::move(key.first), index);
+    }
+
+    mFirstNameTrie.Build(trieKeys);
+
+    // Last name trie holds every entry with a last name
+    std::vector<SortKey> lastNameKeys;
+    for (uint32_t i = 0; i < mFirstNameCount; i++)
+    {
+        const AddressEntry& entry = firstNameKeys[i].second->mEntry;
+        if (!entry.mLastName.empty())
+        {
+            lastNameKeys.emplace_back(FoldCase(entry.mLastName + entry.mFirstName), firstNameKeys[i].second);
+        }
+    }
+
+    for (auto& key : noFirstNameKeys)
+    {
+        mEntries.Append(key.second->mEntry);
+        lastNameKeys.push_back(std::move(key));
+    }
+
+    mEntries.Seal();
+
+    std::sort(lastNameKeys.begin(), lastNameKeys.end(), isBefore);
+
+    // Records map back to entry indexes through their position in ForEach order
+    std::unordered_map<const CAddressRecord*, uint32_t> indexes;
+    indexes.reserve(records.size());
+    for (uint32_t i = 0; i < mFirstNameCount; i++)
+    {
+        indexes.emplace(firstNameKeys[i].second, i);
+    }
+
+    for (uint32_t i = mFirstNameCount; i < mEntries.GetCount(); i++)
+    {
+        indexes.emplace(noFirstNameKeys[i - mFirstNameCount].second, i);
+    }
+
+    trieKeys.clear();
+    trieKeys.reserve(lastNameKeys.size());
+    for (auto& key : lastNameKeys)
+    {
+        trieKeys.emplace_back(std::move(key.first), indexes[key.second]);
+    }
+
+    mLastNameTrie.Build(trieKeys);
+    mNoLastNameEntries.shrink_to_fit();
+
+    // Thawing adds entries back in this order, so same key entries keep their relative order
+    std::vector<std::pair<uint64_t, uint32_t>> addedOrder;
+    addedOrder.reserve(indexes.size());
+    for (const auto& index : indexes)
+    {
+        addedOrder.emplace_back(index.first->mId, index.second);
+    }
+
+    std::sort(addedOrder.begin(), addedOrder.end());
+
+    mAddedOrder.reserve(addedOrder.size());
+    for (const auto& index : addedOrder)
+    {
+        mAddedOrder.push_back(index.second);
+    }
+
+    // Ranked like the mutable tries, by descending score then in the order added
+    mScores.resize(mEntries.GetCount());
+    for (const auto& index : indexes)
+    {
+        mScores[index.second] = index.first->mScore.load(std::memory_order_relaxed);
+    }
+
+    std::vector<uint32_t> rankedOrder(mAddedOrder);
+    std::stable_sort(rankedOrder.begin(), rankedOrder.end(), [this](uint32_t lhs, uint32_t rhs) { return mScores[lhs] > mScores[rhs]; });
+
+    mRanks.resize(mEntries.GetCount());
+    for (uint32_t rank = 0; rank < rankedOrder.size(); rank++)
+    {
+        mRanks[rankedOrder[rank]] = rank;
+    }
+
+    mFirstNameTrie.BuildRanking(mRanks);
+    mLastNameTrie.BuildRanking(mRanks);
+}
+
+//=======================================================
+//		CAddressFrozenBook : Empty book, filled in by Load
+//=======================================================
+CAddressFrozenBook::CAddressFrozenBook(const CAddressTierOptions& tierOptions) :
+    mEntries(tierOptions),
+    mFirstNameCount(0)
+{
+
+}
+
+//=======================================================
+//		Load : Pack entries pulled from source, in the order added, without records in between
+//=======================================================
+std::unique_ptr<CAddressFrozenBook> CAddressFrozenBook::Load(const AddressEntrySource& source,
+                                                             const CAddressTierOptions& tierOptions,
+                                                             AddressEntryError& outResult)
+{
+    // Keys carry the position the entry was added at, which orders same key entries like the mutable tries
+    using SortKey = std::pair<std::string, uint32_t>;
+
+    // Entries are laid out in ForEach order, which the source rarely comes in, so they are staged in added order
+    // and kept where the book keeps its own, a tiered load only holds the keys below in memory
+    CAddressEntryStore staging(tierOptions);
+    std::vector<SortKey> firstNameKeys;
+    std::vector<SortKey> noFirstNameKeys;
+    std::vector<SortKey> lastNameKeys;
+    std::vector<bool> hasLastName;
+
+    AddressEntry entry;
+    while (source(entry))
+    {
+        uint32_t index = static_cast<uint32_t>(staging.GetCount());
+        if (!entry.mFirstName.empty())
+        {
+            firstNameKeys.emplace_back(FoldCase(entry.mFirstName + entry.mLastName), index);
+        }
+        else
+        {
+            noFirstNameKeys.emplace_back(FoldCase(entry.mLastName), index);
+        }
+
+        // Last name trie holds every entry with a last name
+        if (!entry.mLastName.empty())
+        {
+            lastNameKeys.emplace_back(FoldCase(entry.mLastName + entry.mFirstName), index);
+        }
+
+        hasLastName.push_back(!entry.mLastName.empty());
+        staging.Append(entry);
+        entry = AddressEntry();
+    }
+
+    staging.Seal();
+
+    std::sort(firstNameKeys.begin(), firstNameKeys.end());
+    std::sort(noFirstNameKeys.begin(), noFirstNameKeys.end());
+    std::sort(lastNameKeys.begin(), lastNameKeys.end());
+
+    // Repeated entries share their folded key, so only runs of the same key are read back and compared
+    for (const auto* pKeys : { &firstNameKeys, &noFirstNameKeys })
+    {
+        for (size_t begin = 0, end = 0; begin < pKeys->size(); begin = end)
+        {
+            for (end = begin + 1; end < pKeys->size() && (*pKeys)[end].first == (*pKeys)[begin].first; end++);
+            if (end - begin == 1)
+            {
+                continue;
+            }
+
+            std::vector<AddressEntry> run;
+            for (size_t i = begin; i < end; i++)
+            {
+                run.push_back(staging.Read((*pKeys)[i].second));
+            }
+
+            auto fields = [](const AddressEntry& entry) { return std::tie(entry.mFirstName, entry.mLastName, entry.mPhoneNumber); };
+            std::sort(run.begin(), run.end(), [&fields](const AddressEntry& lhs, const AddressEntry& rhs) { return fields(lhs) < fields(rhs); });
+            if (std::adjacent_find(run.cbegin(), run.cend()) != run.cend())
+            {
+                outResult = AddressEntryError::kAddressEntryDuplicate;
+                return nullptr;
+            }
+        }
+    }
+
+    std::unique_ptr<CAddressFrozenBook> pBook(new CAddressFrozenBook(tierOptions));
+    pBook->mEntries.Reserve(staging.GetCount());
+    pBook->mFirstNameCount = static_cast<uint32_t>(firstNameKeys.size());
+
+    // Added position to entry index, which is also the added order
+    std::vector<uint32_t> indexes(staging.GetCount());
+    std::vector<std::pair<std::string, uint32_t>> trieKeys;
+    trieKeys.reserve(firstNameKeys.size());
+    for (auto& key : firstNameKeys)
+    {
+        uint32_t index = static_cast<uint32_t>(pBook->mEntries.GetCount());
+        pBook->mEntries.Append(staging.Read(key.second));
+        indexes[key.second] = index;
+
+        if (!hasLastName[key.second])
+        {
+            pBook->mNoLastNameEntries.push_back(index);
+        }
+
+        trieKeys.emplace_back(std::move(key.first), index);
+    }
+
+    std::vector<SortKey>().swap(firstNameKeys);
+    pBook->mFirstNameTrie.Build(trieKeys);
+
+    for (const auto& key : noFirstNameKeys)
+    {
+        indexes[key.second] = static_cast<uint32_t>(pBook->mEntries.GetCount());
+        pBook->mEntries.Append(staging.Read(key.second));
+    }
+
+    std::vector<SortKey>().swap(noFirstNameKeys);
+    pBook->mEntries.Seal();
+
+    trieKeys.clear();
+    trieKeys.reserve(lastNameKeys.size());
+    for (auto& key : lastNameKeys)
+    {
+        trieKeys.emplace_back(std::move(key.first), indexes[key.second]);
+    }
+
+    std::vector<SortKey>().swap(lastNameKeys);
+    pBook->mLastNameTrie.Build(trieKeys);
+    pBook->mNoLastNameEntries.shrink_to_fit();
+
+    // Loaded entries are unscored, so they rank in the order added
+    pBook->mAddedOrder.swap(indexes);
+    pBook->mScores.assign(pBook->mEntries.GetCount(), 0);
+    pBook->mRanks.resize(pBook->mEntries.GetCount());
+    for (uint32_t rank = 0; rank < pBook->mAddedOrder.size(); rank++)
+    {
+        pBook->mRanks[pBook->mAddedOrder[rank]] = rank;
+    }
+
+    pBook->mFirstNameTrie.BuildRanking(pBook->mRanks);
+    pBook->mLastNameTrie.BuildRanking(pBook->mRanks);
+
+    outResult = AddressEntryError::kAddressEntrySuccess;
+    return pBook;
+}
+
+//=======================================================
+//		RetrieveEntries : Retrieve address in desired order
+//=======================================================
+AddressEntries CAddressFrozenBook::RetrieveEntries(AddressEntryOrderType orderType) const
+{
+    AddressEntries result;
+    ForEach(orderType, [&result](const AddressEntry& entry) { result.push_back(entry); });
+    return result;
+}
+
+//=======================================================
+//		Search : Search address in desired search type
+//=======================================================
+AddressEntries CAddressFrozenBook::Search(const std::string& searchKey, AddressEntrySearchType searchType) const
+{
+    std::string key(FoldCase(searchKey));
+
+    AddressEntries result;
+    switch (searchType)
+    {
+    case AddressEntrySearchType::FirstNameSearch:
+    {
+        CopyEntries(mFirstNameTrie.Search(key), result);
+        break;
+    }
+    case AddressEntrySearchType::LastNameSearch:
+    {
+        CopyEntries(mLastNameTrie.Search(key), result);
+        break;
+    }
+    case AddressEntrySearchType::FirstAndLastNameSearch:
+    {
+        CAddressFrozenRange firstNameRange = mFirstNameTrie.Search(key);
+        CopyEntries(firstNameRange, result);
+
+        // Ensure there are no duplicates in output result
+        std::unordered_set<uint32_t> duplicateLookup(firstNameRange.begin(), firstNameRange.end());
+        for (uint32_t index : mLastNameTrie.Search(key))
+        {
+            if (duplicateLookup.find(index) == duplicateLookup.end())
+            {
+                result.push_back(mEntries.Read(index));
+            }
+        }
+
+        break;
+    }
+    case AddressEntrySearchType::SubstringSearch:
+    {
+        ForEachInFirstNameOrder([&key, &result](uint32_t, const AddressEntry& entry)
+            {
+                if (ContainsCaseInsensitive(entry.mFirstName, key) || ContainsCaseInsensitive(entry.mLastName, key))
+                {
+                    result.push_back(entry);
+                }
+            });
+
+        break;
+    }
+    default:
+        break;
+    }
+
+    return result;
+}
+
+//=======================================================
+//		SearchRanked : Highest scored entries in desired search type
+//=======================================================
+AddressEntries CAddressFrozenBook::SearchRanked(const std::string& searchKey, size_t count, AddressEntrySearchType searchType) const
+{
+    std::string key(FoldCase(searchKey));
+    auto isRankedBefore = [this](uint32_t lhs, uint32_t rhs) { return mRanks[lhs] < mRanks[rhs]; };
+
+    std::vector<uint32_t> indexes;
+    switch (searchType)
+    {
+    case AddressEntrySearchType::FirstNameSearch:
+    {
+        mFirstNameTrie.SearchRanked(key, count, mRanks, indexes);
+        break;
+    }
+    case AddressEntrySearchType::LastNameSearch:
+    {
+        mLastNameTrie.SearchRanked(key, count, mRanks, indexes);
+        break;
+    }
+    case AddressEntrySearchType::FirstAndLastNameSearch:
+    {
+        // Every entry of the combined top is in the top of at least one trie
+        mFirstNameTrie.SearchRanked(key, count, mRanks, indexes);
+        mLastNameTrie.SearchRanked(key, count, mRanks, indexes);
+
+        std::sort(indexes.begin(), indexes.end(), isRankedBefore);
+        indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+        break;
+    }
+    case AddressEntrySearchType::SubstringSearch:
+    {
+        ForEachInFirstNameOrder([&key, &indexes](uint32_t index, const AddressEntry& entry)
+            {
+                if (ContainsCaseInsensitive(entry.mFirstName, key) || ContainsCaseInsensitive(entry.mLastName, key))
+                {
+                    indexes.push_back(index);
+                }
+            });
+
+        size_t ranked = std::min(count, indexes.size());
+        std::partial_sort(indexes.begin(), indexes.begin() + ranked, indexes.end(), isRankedBefore);
+        break;
+    }
+    default:
+        break;
+    }
+
+    AddressEntries result;
+    for (size_t i = 0; i < indexes.size() && i < count; i++)
+    {
+        result.push_back(mEntries.Read(indexes[i]));
+    }
+
+    return result;
+}
+
+//=======================================================
+//		Query : Entries matching a compound query, in first name order
+//=======================================================
+AddressEntries CAddressFrozenBook::Query(const AddressQuery& query) const
+{
+    AddressEntries result;
+    if (query.mTerms.empty())
+    {
+        return result;
+    }
+
+    bool matchAll = query.mOperator == AddressQueryOperator::And;
+    ForEachInFirstNameOrder([&query, &result, matchAll](uint32_t, const AddressEntry& entry)
+        {
+            auto matches = [&entry](const AddressQueryTerm& term) { return MatchesTerm(entry, term); };
+
+            if (matchAll ? std::all_of(query.mTerms.cbegin(), query.mTerms.cend(), matches)
+                         : std::any_of(query.mTerms.cbegin(), query.mTerms.cend(), matches))
+            {
+                result.push_back(entry);
+            }
+        });
+
+    return result;
+}
+
+//=======================================================
+//		ForEach : Pass in a function to iterate through each entry
+//=======================================================
+void CAddressFrozenBook::ForEach(const AddressEntryCallback& callback) const
+{
+    ForEach(0, mEntries.GetCount(), callback);
+}
+
+//=======================================================
+//		ForEach : Pass in a function to iterate through entries [begin, end) of ForEach order
+//=======================================================
+void CAddressFrozenBook::ForEach(size_t begin, size_t end, const AddressEntryCallback& callback) const
+{
+    mEntries.Scan(static_cast<uint32_t>(begin), static_cast<uint32_t>(end), [&callback](uint32_t, const AddressEntry& entry)
+        {
+            callback(entry);
+        });
+}
+
+//=======================================================
+//		ForEach : Pass in a function to iterate through entries in desired order
+//=======================================================
+void CAddressFrozenBook::ForEach(AddressEntryOrderType orderType, const AddressEntryCallback& callback) const
+{
+    switch (orderType)
+    {
+    case AddressEntryOrderType::FirstNameOrder:
+    {
+        ForEachInFirstNameOrder([&callback](uint32_t, const AddressEntry& entry) { callback(entry); });
+        break;
+    }
+    case AddressEntryOrderType::LastNameOrder:
+    {
+        // Entries without a last name come first
+        AddressEntry entry;
+        for (uint32_t index : mNoLastNameEntries)
+        {
+            mEntries.Read(index, entry);
+            callback(entry);
+        }
+
+        for (uint32_t index : mLastNameTrie.All())
+        {
+            mEntries.Read(index, entry);
+            callback(entry);
+        }
+
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+//=======================================================
+//		ForEachInAddedOrder : Pass in a function to iterate through entries in the order they were added
+//=======================================================
+void CAddressFrozenBook::ForEachInAddedOrder(const AddressEntryCallback& callback) const
+{
+    if (!mEntries.IsTiered())
+    {
+        for (uint32_t index : mAddedOrder)
+        {
+            callback(mEntries.Read(index));
+        }
+
+        return;
+    }
+
+    // Added order jumps all over the payload file, one sequential sweep is cheaper than a page read per entry
+    std::vector<AddressEntry> entries(mEntries.GetCount());
+    mEntries.Scan(0, static_cast<uint32_t>(entries.size()), [&entries](uint32_t index, const AddressEntry& entry)
+        {
+            entries[index] = entry;
+        });
+
+    for (uint32_t index : mAddedOrder)
+    {
+        callback(entries[index]);
+    }
+}
+
+//=======================================================
+//		ForEachScored : Pass in a function called with every entry scored above zero and its score
+//=======================================================
+void CAddressFrozenBook::ForEachScored(const std::function<void(const AddressEntry&, uint64_t)>& callback) const
+{
+    for (uint32_t i = 0; i < mScores.size(); i++)
+    {
+        if (mScores[i] != 0)
+        {
+            callback(mEntries.Read(i), mScores[i]);
+        }
+    }
+}
+
+//=======================================================
+//		GetEntryCount
+//=======================================================
+size_t CAddressFrozenBook::GetEntryCount() const
+{
+    return mEntries.GetCount();
+}
+
+//=======================================================
+//		IsTiered : Check if entries live in a payload file
+//=======================================================
+bool CAddressFrozenBook::IsTiered() const
+{
+    return mEntries.IsTiered();
+}
+
+//=======================================================
+//		GetTierStats : Page cache counters of a tiered book
+//=======================================================
+AddressBookTierStats CAddressFrozenBook::GetTierStats() const
+{
+    return mEntries.GetStats();
+}
+
+//=======================================================
+//		GetMetrics : Trie sizes
+//=======================================================
+void CAddressFrozenBook::GetMetrics(AddressBookMetrics& outMetrics) const
+{
+    outMetrics.mFirstNameTrie = mFirstNameTrie.GetMetrics();
+    outMetrics.mLastNameTrie = mLastNameTrie.GetMetrics();
+
+    // Side indexes are plain runs of entries
+    outMetrics.mNoFirstNameTrie = AddressTrieMetrics();
+    outMetrics.mNoFirstNameTrie.mEntryCount = mEntries.GetCount() - mFirstNameCount;
+
+    outMetrics.mNoLastNameTrie = AddressTrieMetrics();
+    outMetrics.mNoLastNameTrie.mEntryCount = mNoLastNameEntries.size();
+    outMetrics.mNoLastNameTrie.mBytes = mNoLastNameEntries.capacity() * sizeof(uint32_t);
+}
+
+//=======================================================
+//		GetMemoryUsage : Node and entry memory
+//=======================================================
+AddressBookMemoryUsage CAddressFrozenBook::GetMemoryUsage() const
+{
+    AddressTrieMetrics firstNameMetrics = mFirstNameTrie.GetMetrics();
+    AddressTrieMetrics lastNameMetrics = mLastNameTrie.GetMetrics();
+
+    AddressBookMemoryUsage usage;
+    usage.mLiveNodes = firstNameMetrics.mNodeCount + lastNameMetrics.mNodeCount;
+    usage.mEntries = firstNameMetrics.mEntryCount + lastNameMetrics.mEntryCount +
+                     (mEntries.GetCount() - mFirstNameCount) + mNoLastNameEntries.size();
+    usage.mBytes = firstNameMetrics.mBytes + lastNameMetrics.mBytes +
+                   (mNoLastNameEntries.capacity() + mAddedOrder.capacity() + mRanks.capacity()) * sizeof(uint32_t) +
+                   mScores.capacity() * sizeof(uint64_t) +
+                   mEntries.GetMemoryBytes();
+
+    return usage;
+}
+
+//=======================================================
+//		ForEachInFirstNameOrder : Pass entries and their indexes in first name order to callback
+//=======================================================
+void CAddressFrozenBook::ForEachInFirstNameOrder(const std::function<void(uint32_t, const AddressEntry&)>& callback) const
+{
+    // Entries without a first name come first
+    mEntries.Scan(mFirstNameCount, static_cast<uint32_t>(mEntries.GetCount()), callback);
+    mEntries.Scan(0, mFirstNameCount, callback);
+}
+
+//=======================================================
+//		CopyEntries : Append entries of a range
+//=======================================================
+void CAddressFrozenBook::CopyEntries(const CAddressFrozenRange& range, AddressEntries& outEntries) const
+{
+    for (uint32_t index : range)
+    {
+        outEntries.push_back(mEntries.Read(index));
+    }
+}
+
+//=======================================================
+//		CAddressFrozenReader
+//=======================================================
+CAddressFrozenReader::CAddressFrozenReader(const std::atomic<const CAddressFrozenBook*>& pBook, CAddressReaderEpoch& readers) :
+    mpBookSlot(pBook),
+    mReaders(readers),
+    mpBook(nullptr),
+    mEpoch(0)
+{
+
+}
+
+//=======================================================
+//		~CAddressFrozenReader
+//=======================================================
+CAddressFrozenReader::~CAddressFrozenReader()
+{
+    if (mpBook != nullptr)
+    {
+        mReaders.Exit(mEpoch);
+    }
+}
+
+//=======================================================
+//		Pin : Pin the book if there is one
+//=======================================================
+const CAddressFrozenBook* CAddressFrozenReader::Pin()
+{
+    if (mpBook != nullptr)
+    {
+        return mpBook;
+    }
+
+    // Announce the read before looking, so a detaching writer either waits for us or we see null
+    mEpoch = mReaders.Enter();
+    mpBook = mpBookSlot.load();
+    if (mpBook == nullptr)
+    {
+        mReaders.Exit(mEpoch);
+    }
+
+    return mpBook;
+}
+
+//=======================================================
+//		Get
+//=======================================================
+const CAddressFrozenBook* CAddressFrozenReader::Get() const
+{
+    return mpBook;
+}
+
+//=======================================================
+//		Detach : Unpublish the book, readers that pinned it may still be reading
+//=======================================================
+const CAddressFrozenBook* CAddressFrozenReader::Detach(std::atomic<const CAddressFrozenBook*>& pBook)
+{
+    return pBook.exchange(nullptr);
+}
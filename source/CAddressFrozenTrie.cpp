@@ -0,0 +1,223 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressFrozenTrie.h"
+
+//=======================================================
+//		CAddressFrozenTrie
+//=======================================================
+CAddressFrozenTrie::CAddressFrozenTrie() :
+    mNodes(1, CAddressFrozenTrieNode{ 0, 0, 0, 0, 0, 0 })
+{
+
+}
+
+//=======================================================
+//		Build : Build from lower case keys sorted alphabetically
+//=======================================================
+void CAddressFrozenTrie::Build(const std::vector<std::pair<std::string, uint32_t>>& sortedKeys)
+{
+    mNodes.assign(1, CAddressFrozenTrieNode{ 0, 0, 0, 0, 0, 0 });
+    mEntries.clear();
+    mEntries.reserve(sortedKeys.size());
+
+    BuildNode(0, sortedKeys, 0, sortedKeys.size(), 0);
+
+    mNodes.shrink_to_fit();
+}
+
+//=======================================================
+//		Search : Entry indexes whose key starts with the lower case key
+//=======================================================
+CAddressFrozenRange CAddressFrozenTrie::Search(const std::string& key) const
+{
+    const CAddressFrozenTrieNode* node = FindNode(key);
+    if (node == nullptr)
+    {
+        return CAddressFrozenRange();
+    }
+
+    return { mEntries.data() + node->mEntryBegin, mEntries.data() + node->mSubtreeEnd };
+}
+
+//=======================================================
+//		All : Every entry index in alphabetical order
+//=======================================================
+CAddressFrozenRange CAddressFrozenTrie::All() const
+{
+    return { mEntries.data(), mEntries.data() + mEntries.size() };
+}
+
+//=======================================================
+//		BuildRanking : Keep the top entries of large subtrees
+//=======================================================
+void CAddressFrozenTrie::BuildRanking(const std::vector<uint32_t>& ranks)
+{
+    auto isRankedBefore = [&ranks](uint32_t lhs, uint32_t rhs) { return ranks[lhs] < ranks[rhs]; };
+
+    mTopOffsets.assign(mNodes.size(), kAddressFrozenNoRanking);
+    mTopEntries.clear();
+
+    // Children are stored after their parent, so walking backwards ranks them first
+    std::vector<uint32_t> candidates;
+    for (size_t nodeIndex = mNodes.size(); nodeIndex-- > 0;)
+    {
+        const CAddressFrozenTrieNode& node = mNodes[nodeIndex];
+        if (node.mSubtreeEnd - node.mEntryBegin <= kAddressFrozenRankScanMax)
+        {
+            continue;
+        }
+
+        candidates.assign(mEntries.cbegin() + node.mEntryBegin, mEntries.cbegin() + node.mEntryEnd);
+        for (uint32_t i = 0; i < node.mChildCount; i++)
+        {
+            uint32_t childIndex = node.mChildBegin + i;
+            const CAddressFrozenTrieNode& child = mNodes[childIndex];
+
+            if (mTopOffsets[childIndex] != kAddressFrozenNoRanking)
+            {
+                auto top = mTopEntries.cbegin() + mTopOffsets[childIndex];
+                candidates.insert(candidates.end(), top, top + kAddressBookRankedTopCount);
+            }
+            else
+            {
+                candidates.insert(candidates.end(), mEntries.cbegin() + child.mEntryBegin, mEntries.cbegin() + child.mSubtreeEnd);
+            }
+        }
+
+        std::partial_sort(candidates.begin(), candidates.begin() + kAddressBookRankedTopCount, candidates.end(), isRankedBefore);
+
+        mTopOffsets[nodeIndex] = static_cast<uint32_t>(mTopEntries.size());
+        mTopEntries.insert(mTopEntries.end(), candidates.cbegin(), candidates.cbegin() + kAddressBookRankedTopCount);
+    }
+
+    mTopEntries.shrink_to_fit();
+}
+
+//=======================================================
+//		SearchRanked : Highest ranked entry indexes whose key starts with the lower case key
+//=======================================================
+void CAddressFrozenTrie::SearchRanked(const std::string& key,
+                                      size_t count,
+                                      const std::vector<uint32_t>& ranks,
+                                      std::vector<uint32_t>& outEntries) const
+{
+    const CAddressFrozenTrieNode* node = FindNode(key);
+    if (node == nullptr || count == 0)
+    {
+        return;
+    }
+
+    uint32_t topOffset = mTopOffsets.empty() ? kAddressFrozenNoRanking : mTopOffsets[node - mNodes.data()];
+    if (count <= kAddressBookRankedTopCount && topOffset != kAddressFrozenNoRanking)
+    {
+        outEntries.insert(outEntries.end(), mTopEntries.cbegin() + topOffset, mTopEntries.cbegin() + topOffset + count);
+        return;
+    }
+
+    // Small subtree, or more entries than are kept
+    std::vector<uint32_t> candidates(mEntries.cbegin() + node->mEntryBegin, mEntries.cbegin() + node->mSubtreeEnd);
+
+    count = std::min(count, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                      [&ranks](uint32_t lhs, uint32_t rhs) { return ranks[lhs] < ranks[rhs]; });
+    outEntries.insert(outEntries.end(), candidates.cbegin(), candidates.cbegin() + count);
+}
+
+//=======================================================
+//		GetMetrics : Node, entry and memory counts
+//=======================================================
+AddressTrieMetrics CAddressFrozenTrie::GetMetrics() const
+{
+    AddressTrieMetrics metrics;
+    metrics.mNodeCount = mNodes.size();
+    metrics.mEntryCount = mEntries.size();
+    metrics.mBytes = mNodes.capacity() * sizeof(CAddressFrozenTrieNode) +
+                     (mEntries.capacity() + mTopOffsets.capacity() + mTopEntries.capacity()) * sizeof(uint32_t);
+
+    return metrics;
+}
+
+//=======================================================
+//		FindNode : Node at the end of the lower case key, or null
+//=======================================================
+const CAddressFrozenTrieNode* CAddressFrozenTrie::FindNode(const std::string& key) const
+{
+    const CAddressFrozenTrieNode* currentNode = &mNodes.front();
+    for (const char& c : key)
+    {
+        // Children are few and sorted, a linear scan beats a binary search
+        const CAddressFrozenTrieNode* nextNode = nullptr;
+        for (uint32_t i = 0; i < currentNode->mChildCount; i++)
+        {
+            const CAddressFrozenTrieNode& child = mNodes[currentNode->mChildBegin + i];
+            if (child.mLabel == c)
+            {
+                nextNode = &child;
+                break;
+            }
+        }
+
+        if (nextNode == nullptr)
+        {
+            return nullptr;
+        }
+
+        currentNode = nextNode;
+    }
+
+    return currentNode;
+}
+
+//=======================================================
+//		BuildNode : Fill node with keys sharing their first *depth* characters
+//=======================================================
+void CAddressFrozenTrie::BuildNode(uint32_t nodeIndex,
+                                   const std::vector<std::pair<std::string, uint32_t>>& sortedKeys,
+                                   size_t begin,
+                                   size_t end,
+                                   size_t depth)
+{
+    // Keys ending here sort before longer ones
+    mNodes[nodeIndex].mEntryBegin = static_cast<uint32_t>(mEntries.size());
+    while (begin < end && sortedKeys[begin].first.size() == depth)
+    {
+        mEntries.push_back(sortedKeys[begin].second);
+        begin++;
+    }
+
+    mNodes[nodeIndex].mEntryEnd = static_cast<uint32_t>(mEntries.size());
+
+    // Group remaining keys by their next character
+    std::vector<std::pair<size_t, size_t>> groups;
+    for (size_t groupBegin = begin; groupBegin < end;)
+    {
+        char label = sortedKeys[groupBegin].first[depth];
+
+        size_t groupEnd = groupBegin + 1;
+        while (groupEnd < end && sortedKeys[groupEnd].first[depth] == label)
+        {
+            groupEnd++;
+        }
+
+        groups.emplace_back(groupBegin, groupEnd);
+        groupBegin = groupEnd;
+    }
+
+    // Children are allocated together, then filled depth first so subtree entries stay contiguous
+    uint32_t childBegin = static_cast<uint32_t>(mNodes.size());
+    mNodes[nodeIndex].mChildBegin = childBegin;
+    mNodes[nodeIndex].mChildCount = static_cast<uint8_t>(groups.size());
+
+    for (const auto& group : groups)
+    {
+        mNodes.push_back(CAddressFrozenTrieNode{ 0, 0, 0, 0, 0, sortedKeys[group.first].first[depth] });
+    }
+
+    for (size_t i = 0; i < groups.size(); i++)
+    {
+        BuildNode(childBegin + static_cast<uint32_t>(i), sortedKeys, groups[i].first, groups[i].second, depth + 1);
+    }
+
+    mNodes[nodeIndex].mSubtreeEnd = static_cast<uint32_t>(mEntries.size());
+}
@@ -0,0 +1,327 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressLookupFilter.h"
+
+// System
+#include <cctype>
+#include <cmath>
+
+//=======================================================
+//		Constants
+//=======================================================
+constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+//=======================================================
+//		MixHash : Spread FNV-1a bits over the whole word
+//=======================================================
+static uint64_t MixHash(uint64_t hash)
+{
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebull;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+//=======================================================
+//		CAddressLookupFilter
+//=======================================================
+CAddressLookupFilter::CAddressLookupFilter(size_t expectedEntries, double falsePositiveRate) :
+    mWordCount(0),
+    mCounterCount(0),
+    mHashCount(0),
+    mFalsePositiveRate(falsePositiveRate),
+    mLookups(0),
+    mRejected(0),
+    mFalsePositives(0)
+{
+    // Optimal Bloom filter size and hash count for the keys at the rate
+    const double ln2 = std::log(2.0);
+    double keyCount = static_cast<double>(std::max<size_t>(1, expectedEntries) * kAddressFilterKeysPerEntry);
+    double counterCount = std::ceil(-keyCount * std::log(falsePositiveRate) / (ln2 * ln2));
+
+    mWordCount = std::max<size_t>(1, static_cast<size_t>(std::ceil(counterCount / kAddressFilterCountersPerWord)));
+    mCounterCount = mWordCount * kAddressFilterCountersPerWord;
+    mHashCount = std::max<uint32_t>(1, static_cast<uint32_t>(std::lround(mCounterCount / keyCount * ln2)));
+
+    mWords.reset(new std::atomic<uint64_t>[mWordCount]);
+    Clear();
+}
+
+//=======================================================
+//		Insert : Count entry and its name prefixes in
+//=======================================================
+void CAddressLookupFilter::Insert(const AddressEntry& entry) noexcept
+{
+    ForEachKey(entry, [this](uint64_t hash) { Update(hash, 1); });
+}
+
+//=======================================================
+//		Remove : Count entry and its name prefixes out
+//=======================================================
+void CAddressLookupFilter::Remove(const AddressEntry& entry) noexcept
+{
+    ForEachKey(entry, [this](uint64_t hash) { Update(hash, -1); });
+}
+
+//=======================================================
+//		Clear : Drop every key
+//=======================================================
+void CAddressLookupFilter::Clear()
+{
+    for (size_t i = 0; i < mWordCount; i++)
+    {
+        mWords[i].store(0, std::memory_order_release);
+    }
+}
+
+//=======================================================
+//		MayContain : False if entry is certainly not in the book
+//=======================================================
+bool CAddressLookupFilter::MayContain(const AddressEntry& entry) const
+{
+    mLookups.fetch_add(1, std::memory_order_relaxed);
+    if (!Test(HashEntry(entry)))
+    {
+        mRejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    return true;
+}
+
+//=======================================================
+//		MayMatch : False if no entry can match searchKey in prefix search type
+//=======================================================
+bool CAddressLookupFilter::MayMatch(const std::string& searchKey, AddressEntrySearchType searchType) const
+{
+    if (!IsFiltered(searchKey, searchType))
+    {
+        return true;
+    }
+
+    size_t length = std::min(searchKey.size(), kAddressFilterPrefixMax);
+    bool mayMatch = false;
+    switch (searchType)
+    {
+    case AddressEntrySearchType::FirstNameSearch:
+    {
+        mayMatch = Test(HashPrefix(KeyDomain::FirstNamePrefix, searchKey, std::string(), length));
+        break;
+    }
+    case AddressEntrySearchType::LastNameSearch:
+    {
+        mayMatch = Test(HashPrefix(KeyDomain::LastNamePrefix, searchKey, std::string(), length));
+        break;
+    }
+    case AddressEntrySearchType::FirstAndLastNameSearch:
+    {
+        mayMatch = Test(HashPrefix(KeyDomain::FirstNamePrefix, searchKey, std::string(), length)) ||
+                   Test(HashPrefix(KeyDomain::LastNamePrefix, searchKey, std::string(), length));
+        break;
+    }
+    default:
+        return true;
+    }
+
+    mLookups.fetch_add(1, std::memory_order_relaxed);
+    if (!mayMatch)
+    {
+        mRejected.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return mayMatch;
+}
+
+//=======================================================
+//		IsFiltered : Check if MayMatch can reject searchKey in search type
+//=======================================================
+bool CAddressLookupFilter::IsFiltered(const std::string& searchKey, AddressEntrySearchType searchType)
+{
+    return searchKey.size() >= kAddressFilterPrefixMin && searchType != AddressEntrySearchType::SubstringSearch;
+}
+
+//=======================================================
+//		CountFalsePositive : Count a lookup that was let through but found nothing
+//=======================================================
+void CAddressLookupFilter::CountFalsePositive() const
+{
+    mFalsePositives.fetch_add(1, std::memory_order_relaxed);
+}
+
+//=======================================================
+//		GetStats
+//=======================================================
+AddressLookupFilterStats CAddressLookupFilter::GetStats() const
+{
+    AddressLookupFilterStats stats;
+    stats.mEnabled = true;
+    stats.mLookups = mLookups.load(std::memory_order_relaxed);
+    stats.mRejected = mRejected.load(std::memory_order_relaxed);
+    stats.mFalsePositives = mFalsePositives.load(std::memory_order_relaxed);
+    stats.mFalsePositiveRate = mFalsePositiveRate;
+    stats.mHashCount = mHashCount;
+    stats.mBytes = mWordCount * sizeof(uint64_t);
+    return stats;
+}
+
+//=======================================================
+//		ForEachKey : Apply function to the hash of every key of entry
+//		the entry itself, and the prefixes of the keys it is filed under in the first and last name tries
+//=======================================================
+template <typename Function>
+void CAddressLookupFilter::ForEachKey(const AddressEntry& entry, Function&& function)
+{
+    function(HashEntry(entry));
+
+    // Only entries with the name the trie is sorted by are in it
+    size_t keySize = entry.mFirstName.size() + entry.mLastName.size();
+    for (size_t length = kAddressFilterPrefixMin; length <= std::min(keySize, kAddressFilterPrefixMax); length++)
+    {
+        if (!entry.mFirstName.empty())
+        {
+            function(HashPrefix(KeyDomain::FirstNamePrefix, entry.mFirstName, entry.mLastName, length));
+        }
+
+        if (!entry.mLastName.empty())
+        {
+            function(HashPrefix(KeyDomain::LastNamePrefix, entry.mLastName, entry.mFirstName, length));
+        }
+    }
+}
+
+//=======================================================
+//		HashEntry : Hash of the exact entry
+//=======================================================
+uint64_t CAddressLookupFilter::HashEntry(const AddressEntry& entry)
+{
+    uint64_t hash = kFnvOffsetBasis;
+    hash = (hash ^ static_cast<uint8_t>(KeyDomain::Entry)) * kFnvPrime;
+    for (const std::string* field : { &entry.mFirstName, &entry.mLastName, &entry.mPhoneNumber })
+    {
+        for (unsigned char c : *field)
+        {
+            hash = (hash ^ c) * kFnvPrime;
+        }
+
+        // Field separator, so "ab"+"c" and "a"+"bc" differ
+        hash = (hash ^ 0xff) * kFnvPrime;
+    }
+
+    return MixHash(hash);
+}
+
+//=======================================================
+//		HashPrefix : Hash of the first *length* characters of name followed by rest, case folded
+//=======================================================
+uint64_t CAddressLookupFilter::HashPrefix(KeyDomain domain, const std::string& name, const std::string& rest, size_t length)
+{
+    uint64_t hash = kFnvOffsetBasis;
+    hash = (hash ^ static_cast<uint8_t>(domain)) * kFnvPrime;
+    for (size_t i = 0; i < length; i++)
+    {
+        unsigned char c = (i < name.size()) ? name[i] : rest[i - name.size()];
+        hash = (hash ^ static_cast<uint8_t>(tolower(c))) * kFnvPrime;
+    }
+
+    return MixHash(hash);
+}
+
+//=======================================================
+//		Update : Add delta to the counters of hash
+//		writers are serialised by the book's lock, so a plain store is enough
+//=======================================================
+void CAddressLookupFilter::Update(uint64_t hash, int delta)
+{
+    uint64_t step = MixHash(hash) | 1;
+    for (uint32_t i = 0; i < mHashCount; i++)
+    {
+        size_t counter = static_cast<size_t>((hash + i * step) % mCounterCount);
+        std::atomic<uint64_t>& word = mWords[counter / kAddressFilterCountersPerWord];
+        uint32_t shift = static_cast<uint32_t>(counter % kAddressFilterCountersPerWord) * kAddressFilterCounterBits;
+
+        uint64_t value = word.load(std::memory_order_relaxed);
+        uint32_t count = static_cast<uint32_t>(value >> shift) & kAddressFilterCounterMax;
+        if (count == kAddressFilterCounterMax || (delta < 0 && count == 0))
+        {
+            continue;
+        }
+
+        value = (delta > 0) ? value + (uint64_t(1) << shift) : value - (uint64_t(1) << shift);
+        word.store(value, std::memory_order_release);
+    }
+}
+
+//=======================================================
+//		Test : Check if every counter of hash is set
+//=======================================================
+bool CAddressLookupFilter::Test(uint64_t hash) const
+{
+    uint64_t step = MixHash(hash) | 1;
+    for (uint32_t i = 0; i < mHashCount; i++)
+    {
+        size_t counter = static_cast<size_t>((hash + i * step) % mCounterCount);
+        uint64_t value = mWords[counter / kAddressFilterCountersPerWord].load(std::memory_order_acquire);
+        uint32_t shift = static_cast<uint32_t>(counter % kAddressFilterCountersPerWord) * kAddressFilterCounterBits;
+
+        if (((value >> shift) & kAddressFilterCounterMax) == 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//=======================================================
+//		CAddressLookupFilterReader
+//=======================================================
+CAddressLookupFilterReader::CAddressLookupFilterReader(const std::atomic<CAddressLookupFilter*>& pFilter, CAddressReaderEpoch& readers) :
+    mpFilterSlot(pFilter),
+    mReaders(readers),
+    mpFilter(nullptr),
+    mEpoch(0)
+{
+
+}
+
+//=======================================================
+//		~CAddressLookupFilterReader
+//=======================================================
+CAddressLookupFilterReader::~CAddressLookupFilterReader()
+{
+    if (mpFilter != nullptr)
+    {
+        mReaders.Exit(mEpoch);
+    }
+}
+
+//=======================================================
+//		Pin : Pin the filter if there is one
+//=======================================================
+const CAddressLookupFilter* CAddressLookupFilterReader::Pin()
+{
+    if (mpFilter != nullptr)
+    {
+        return mpFilter;
+    }
+
+    // Lookups are only ever sped up by the filter, missing one being set meanwhile is harmless
+    if (mpFilterSlot.load(std::memory_order_relaxed) == nullptr)
+    {
+        return nullptr;
+    }
+
+    // Announce the read before looking, so a writer swapping the filter either waits for us or we see the new one
+    mEpoch = mReaders.Enter();
+    mpFilter = mpFilterSlot.load();
+    if (mpFilter == nullptr)
+    {
+        mReaders.Exit(mEpoch);
+    }
+
+    return mpFilter;
+}
@@ -0,0 +1,57 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressReaderEpoch.h"
+
+//=======================================================
+//		CAddressReaderEpoch
+//=======================================================
+CAddressReaderEpoch::CAddressReaderEpoch() :
+    mEpoch(0),
+    mReaders{ { 0, 0 } }
+{
+
+}
+
+//=======================================================
+//		Enter : Count a reader in
+//=======================================================
+uint32_t CAddressReaderEpoch::Enter()
+{
+    while (true)
+    {
+        uint32_t epoch = mEpoch.load() & 1;
+        mReaders[epoch].fetch_add(1);
+
+        // Counted against the epoch still current, a synchronising writer moving on after this waits for us
+        if ((mEpoch.load() & 1) == epoch)
+        {
+            return epoch;
+        }
+
+        mReaders[epoch].fetch_sub(1);
+    }
+}
+
+//=======================================================
+//		Exit : Count a reader out
+//=======================================================
+void CAddressReaderEpoch::Exit(uint32_t epoch)
+{
+    mReaders[epoch].fetch_sub(1);
+}
+
+//=======================================================
+//		Synchronise : Wait for every reader that entered before the call
+//=======================================================
+void CAddressReaderEpoch::Synchronise()
+{
+    std::lock_guard<std::mutex> lock(mSynchroniseMutex);
+
+    // Readers entering from now on are counted against the next epoch
+    uint32_t epoch = mEpoch.fetch_add(1) & 1;
+    while (mReaders[epoch].load() != 0)
+    {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,34 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressRecordStream.h"
+
+// System
+#include <iterator>
+
+//=======================================================
+//		IsBefore : Record id order
+//=======================================================
+static bool IsBefore(const CAddressRecord* lhs, const CAddressRecord* rhs)
+{
+    return lhs->mId < rhs->mId;
+}
+
+//=======================================================
+//		SortRecordStream : Sort records into a stream
+//=======================================================
+void SortRecordStream(CAddressRecordStream& stream)
+{
+    std::sort(stream.begin(), stream.end(), IsBefore);
+}
+
+//=======================================================
+//		UniteRecordStreams : Records in either stream
+//=======================================================
+void UniteRecordStreams(const CAddressRecordStream& lhs,
+                        const CAddressRecordStream& rhs,
+                        CAddressRecordStream& outStream)
+{
+    outStream.reserve(outStream.size() + lhs.size() + rhs.size());
+    std::set_union(lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend(), std::back_inserter(outStream), IsBefore);
+}
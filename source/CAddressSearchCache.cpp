@@ -0,0 +1,229 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressSearchCache.h"
+#include "CAddressBookTrie.h"
+
+//=======================================================
+//		EstimateBytes : Approximate memory held by a cached result
+//=======================================================
+static size_t EstimateBytes(const std::string& lookupKey, const AddressEntries& entries)
+{
+    // List node links on top of each entry
+    constexpr size_t kListNodeBytes = 2 * sizeof(void*);
+
+    size_t bytes = 2 * lookupKey.size() + sizeof(AddressEntries) + 4 * sizeof(void*);
+    for (const auto& entry : entries)
+    {
+        bytes += kListNodeBytes + sizeof(AddressEntry) +
+                 entry.mFirstName.capacity() + entry.mLastName.capacity() + entry.mPhoneNumber.capacity();
+    }
+
+    return bytes;
+}
+
+//=======================================================
+//		CAddressSearchCache
+//=======================================================
+CAddressSearchCache::CAddressSearchCache() :
+    mBudgetBytes(0),
+    mBytes(0)
+{
+
+}
+
+//=======================================================
+//		SetBudget : Set memory budget in bytes, zero disables the cache
+//=======================================================
+void CAddressSearchCache::SetBudget(size_t budgetBytes)
+{
+    mBudgetBytes = budgetBytes;
+    EvictToBudget();
+}
+
+//=======================================================
+//		IsEnabled
+//=======================================================
+bool CAddressSearchCache::IsEnabled() const
+{
+    return mBudgetBytes != 0;
+}
+
+//=======================================================
+//		Find : Look up result for a lower case search key
+//=======================================================
+CAddressSearchCache::SearchResult CAddressSearchCache::Find(AddressEntrySearchType searchType, const std::string& searchKey)
+{
+    auto it = mLookup.find(LookupKey(searchType, searchKey));
+    if (it == mLookup.end())
+    {
+        mStats.mMisses++;
+        return nullptr;
+    }
+
+    // Move to front of LRU
+    mItems.splice(mItems.begin(), mItems, it->second);
+
+    mStats.mHits++;
+    return it->second->mResult;
+}
+
+//=======================================================
+//		Insert : Cache result for a lower case search key
+//=======================================================
+void CAddressSearchCache::Insert(AddressEntrySearchType searchType, const std::string& searchKey, const SearchResult& result)
+{
+    std::string lookupKey(LookupKey(searchType, searchKey));
+    size_t bytes = EstimateBytes(lookupKey, *result);
+
+    // Results larger than the whole budget are not worth keeping
+    if (bytes > mBudgetBytes)
+    {
+        return;
+    }
+
+    auto it = mLookup.find(lookupKey);
+    if (it != mLookup.end())
+    {
+        Erase(it->second);
+    }
+
+    mItems.push_front({ lookupKey, result, bytes });
+    mLookup.emplace(std::move(lookupKey), mItems.begin());
+    mBytes += bytes;
+
+    EvictToBudget();
+}
+
+//=======================================================
+//		Invalidate : Drop results for every search key that prefixes the entry's trie keys
+//					 or is contained in its names
+//=======================================================
+void CAddressSearchCache::Invalidate(const AddressEntry& entry)
+{
+    if (mItems.empty())
+    {
+        return;
+    }
+
+    std::string firstNameKey(entry.mFirstName + entry.mLastName);
+    LowerCaseString(firstNameKey);
+
+    std::string lastNameKey(entry.mLastName + entry.mFirstName);
+    LowerCaseString(lastNameKey);
+
+    // Mirrors which tries hold the entry
+    if (!entry.mFirstName.empty())
+    {
+        InvalidatePrefixes(AddressEntrySearchType::FirstNameSearch, firstNameKey);
+        InvalidatePrefixes(AddressEntrySearchType::FirstAndLastNameSearch, firstNameKey);
+    }
+
+    if (!entry.mLastName.empty())
+    {
+        InvalidatePrefixes(AddressEntrySearchType::LastNameSearch, lastNameKey);
+        InvalidatePrefixes(AddressEntrySearchType::FirstAndLastNameSearch, lastNameKey);
+    }
+
+    for (const std::string* name : { &entry.mFirstName, &entry.mLastName })
+    {
+        std::string key(*name);
+        LowerCaseString(key);
+        InvalidateSubstrings(AddressEntrySearchType::SubstringSearch, key);
+    }
+}
+
+//=======================================================
+//		Clear : Drop all results
+//=======================================================
+void CAddressSearchCache::Clear()
+{
+    mStats.mInvalidations += mItems.size();
+
+    mItems.clear();
+    mLookup.clear();
+    mBytes = 0;
+}
+
+//=======================================================
+//		GetStats : Get counters
+//=======================================================
+AddressSearchCacheStats CAddressSearchCache::GetStats() const
+{
+    AddressSearchCacheStats stats(mStats);
+    stats.mResultCount = mItems.size();
+    stats.mBytes = mBytes;
+    stats.mBudgetBytes = mBudgetBytes;
+
+    return stats;
+}
+
+//=======================================================
+//		LookupKey : Search type followed by search key
+//=======================================================
+std::string CAddressSearchCache::LookupKey(AddressEntrySearchType searchType, const std::string& searchKey)
+{
+    std::string lookupKey(1, static_cast<char>('0' + static_cast<uint32_t>(searchType)));
+    lookupKey += searchKey;
+
+    return lookupKey;
+}
+
+//=======================================================
+//		InvalidatePrefixes : Erase results of a search type for every prefix of key
+//=======================================================
+void CAddressSearchCache::InvalidatePrefixes(AddressEntrySearchType searchType, const std::string& key)
+{
+    // Empty search key matches everything, so it is included
+    std::string lookupKey(LookupKey(searchType, std::string()));
+    for (size_t length = 0; ; length++)
+    {
+        auto it = mLookup.find(lookupKey);
+        if (it != mLookup.end())
+        {
+            Erase(it->second);
+            mStats.mInvalidations++;
+        }
+
+        if (length == key.size())
+        {
+            break;
+        }
+
+        lookupKey.push_back(key[length]);
+    }
+}
+
+//=======================================================
+//		InvalidateSubstrings : Erase results of a search type for every substring of key
+//=======================================================
+void CAddressSearchCache::InvalidateSubstrings(AddressEntrySearchType searchType, const std::string& key)
+{
+    // Every substring is a prefix of some suffix
+    for (size_t start = 0; start <= key.size(); start++)
+    {
+        InvalidatePrefixes(searchType, key.substr(start));
+    }
+}
+
+//=======================================================
+//		Erase : Remove cached result
+//=======================================================
+void CAddressSearchCache::Erase(CacheList::iterator it)
+{
+    mBytes -= it->mBytes;
+    mLookup.erase(it->mLookupKey);
+    mItems.erase(it);
+}
+
+//=======================================================
+//		EvictToBudget : Evict least recently used results until within budget
+//=======================================================
+void CAddressSearchCache::EvictToBudget()
+{
+    while (mBytes > mBudgetBytes && !mItems.empty())
+    {
+        Erase(std::prev(mItems.end()));
+        mStats.mEvictions++;
+    }
+}
\ No newline at end of file
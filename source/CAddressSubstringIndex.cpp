@@ -0,0 +1,247 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "CAddressSubstringIndex.h"
+#include "CAddressBookTrie.h"
+
+// System
+#include <cctype>
+
+//=======================================================
+//		ContainsCaseInsensitive : Check if str contains the lower case key, ignoring case
+//=======================================================
+static bool ContainsCaseInsensitive(const std::string& str, const std::string& key)
+{
+    return std::search(str.cbegin(), str.cend(), key.cbegin(), key.cend(), [](const char& lhs, const char& rhs)
+        {
+            return tolower(lhs) == rhs;
+        }) != str.cend();
+}
+
+//=======================================================
+//		CAddressSubstringIndex
+//=======================================================
+CAddressSubstringIndex::CAddressSubstringIndex() :
+    mPostingIds(0),
+    mDeadPostingIds(0)
+{
+
+}
+
+//=======================================================
+//		Insert : Index record
+//=======================================================
+void CAddressSubstringIndex::Insert(const CAddressRecordPtr& pRecord)
+{
+    std::vector<Gram> grams;
+    CollectGrams(*pRecord, grams);
+
+    mRecords.emplace(pRecord->mId, IndexedRecord{ pRecord.get(), grams.size() });
+
+    // Ids only grow, so appending keeps posting lists sorted
+    for (const Gram& gram : grams)
+    {
+        mPostings[gram].push_back(pRecord->mId);
+    }
+
+    mPostingIds += grams.size();
+}
+
+//=======================================================
+//		Remove : Stop matching record
+//=======================================================
+void CAddressSubstringIndex::Remove(const CAddressRecord& record) noexcept
+{
+    auto it = mRecords.find(record.mId);
+    if (it == mRecords.end())
+    {
+        return;
+    }
+
+    // Posting lists still hold the id until enough of them are stale
+    mDeadPostingIds += it->second.mGramCount;
+    mRecords.erase(it);
+
+    if (mDeadPostingIds * 2 > mPostingIds)
+    {
+        CompactPostings();
+    }
+}
+
+//=======================================================
+//		Search : Records whose first or last name contains the lower case key
+//=======================================================
+void CAddressSubstringIndex::Search(const std::string& key, std::vector<const CAddressRecord*>& outRecords) const
+{
+    // Every record contains the empty key
+    if (key.empty())
+    {
+        for (const auto& record : mRecords)
+        {
+            outRecords.push_back(record.second.mpRecord);
+        }
+
+        return;
+    }
+
+    // Every gram of the key must be present
+    std::vector<Gram> grams;
+    CollectKeyGrams(key, grams);
+
+    std::vector<const Posting*> postings;
+    for (const Gram& gram : grams)
+    {
+        auto it = mPostings.find(gram);
+        if (it == mPostings.end())
+        {
+            return;
+        }
+
+        postings.push_back(&it->second);
+    }
+
+    // Candidates come from the shortest list, looked up in the others
+    std::sort(postings.begin(), postings.end(), [](const Posting* lhs, const Posting* rhs) { return lhs->size() < rhs->size(); });
+
+    std::vector<Posting::const_iterator> cursors;
+    for (const Posting* posting : postings)
+    {
+        cursors.push_back(posting->cbegin());
+    }
+
+    for (const uint64_t& id : *postings.front())
+    {
+        bool candidate = true;
+        for (size_t i = 1; i < postings.size() && candidate; i++)
+        {
+            // Candidates are ascending, so each cursor only moves forward
+            cursors[i] = std::lower_bound(cursors[i], postings[i]->cend(), id);
+            candidate = cursors[i] != postings[i]->cend() && *cursors[i] == id;
+        }
+
+        if (!candidate)
+        {
+            continue;
+        }
+
+        // Skip removed records, grams of a longer key may also come from different names or positions
+        auto it = mRecords.find(id);
+        if (it != mRecords.end() && (grams.size() == 1 || Contains(*it->second.mpRecord, key)))
+        {
+            outRecords.push_back(it->second.mpRecord);
+        }
+    }
+}
+
+//=======================================================
+//		Clear : Drop all records
+//=======================================================
+void CAddressSubstringIndex::Clear()
+{
+    mPostings.clear();
+    mRecords.clear();
+    mPostingIds = 0;
+    mDeadPostingIds = 0;
+}
+
+//=======================================================
+//		GetRecordCount : Number of indexed records
+//=======================================================
+size_t CAddressSubstringIndex::GetRecordCount() const
+{
+    return mRecords.size();
+}
+
+//=======================================================
+//		Swap : Exchange contents
+//=======================================================
+void CAddressSubstringIndex::Swap(CAddressSubstringIndex& other)
+{
+    mPostings.swap(other.mPostings);
+    mRecords.swap(other.mRecords);
+    std::swap(mPostingIds, other.mPostingIds);
+    std::swap(mDeadPostingIds, other.mDeadPostingIds);
+}
+
+//=======================================================
+//		CollectGrams : Distinct grams of the record's first and last names
+//=======================================================
+void CAddressSubstringIndex::CollectGrams(const CAddressRecord& record, std::vector<Gram>& outGrams)
+{
+    for (const std::string* name : { &record.mEntry.mFirstName, &record.mEntry.mLastName })
+    {
+        std::string lowerName(*name);
+        LowerCaseString(lowerName);
+
+        // Shorter grams give short keys a posting list of their own instead of a scan
+        for (size_t length = 1; length <= kAddressSubstringGramLength; length++)
+        {
+            CollectGrams(lowerName, length, outGrams);
+        }
+    }
+
+    std::sort(outGrams.begin(), outGrams.end());
+    outGrams.erase(std::unique(outGrams.begin(), outGrams.end()), outGrams.end());
+}
+
+//=======================================================
+//		CollectGrams : Grams of *length* characters of a lower case string
+//		names are letters only, so no character is zero and grams of different lengths never collide
+//=======================================================
+void CAddressSubstringIndex::CollectGrams(const std::string& str, size_t length, std::vector<Gram>& outGrams)
+{
+    for (size_t i = 0; i + length <= str.size(); i++)
+    {
+        Gram gram = 0;
+        for (size_t j = 0; j < length; j++)
+        {
+            gram = (gram << 8) | static_cast<unsigned char>(str[i + j]);
+        }
+
+        outGrams.push_back(gram);
+    }
+}
+
+//=======================================================
+//		CollectKeyGrams : Grams a lower case key is searched by
+//=======================================================
+void CAddressSubstringIndex::CollectKeyGrams(const std::string& key, std::vector<Gram>& outGrams)
+{
+    CollectGrams(key, std::min(key.size(), kAddressSubstringGramLength), outGrams);
+}
+
+//=======================================================
+//		Contains : Check if first or last name contains the lower case key
+//=======================================================
+bool CAddressSubstringIndex::Contains(const CAddressRecord& record, const std::string& key)
+{
+    return ContainsCaseInsensitive(record.mEntry.mFirstName, key) || ContainsCaseInsensitive(record.mEntry.mLastName, key);
+}
+
+//=======================================================
+//		CompactPostings : Drop ids of removed records from every posting list
+//=======================================================
+void CAddressSubstringIndex::CompactPostings() noexcept
+{
+    mPostingIds = 0;
+    for (auto it = mPostings.begin(); it != mPostings.end();)
+    {
+        Posting& posting = it->second;
+        posting.erase(std::remove_if(posting.begin(), posting.end(), [this](const uint64_t& id)
+            {
+                return mRecords.find(id) == mRecords.end();
+            }), posting.end());
+
+        if (posting.empty())
+        {
+            it = mPostings.erase(it);
+            continue;
+        }
+
+        posting.shrink_to_fit();
+        mPostingIds += posting.size();
+        it++;
+    }
+
+    mDeadPostingIds = 0;
+}
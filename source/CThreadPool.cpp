@@ -0,0 +1,74 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "CThreadPool.h"
+
+//=======================================================
+//		CThreadPool
+//=======================================================
+CThreadPool::CThreadPool(uint32_t threadCount /* = 0 */) :
+    mStopping(false)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    mWorkers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        mWorkers.emplace_back(&CThreadPool::WorkerLoop, this);
+    }
+}
+
+//=======================================================
+//		~CThreadPool
+//=======================================================
+CThreadPool::~CThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+
+    mCondition.notify_all();
+    for (auto& worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+//=======================================================
+//		GetThreadCount : Number of worker threads
+//=======================================================
+uint32_t CThreadPool::GetThreadCount() const
+{
+    return static_cast<uint32_t>(mWorkers.size());
+}
+
+//=======================================================
+//		WorkerLoop : Run queued tasks until stopped
+//=======================================================
+void CThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+
+            // Drain remaining tasks before stopping
+            if (mTasks.empty())
+            {
+                return;
+            }
+
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
+        }
+
+        task();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,723 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookInterface.h"
+#include "ServerProtocol.h"
+
+// System
+#include <csignal>
+#include <cerrno>
+#include <cstdio>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+//=======================================================
+//		Constants
+//=======================================================
+constexpr uint32_t kDefaultWorkerCount = 4;
+constexpr int kMaxEvents = 256;
+constexpr size_t kReadChunkBytes = 64 * 1024;
+
+// Reading from a connection pauses while more than this many bytes of its requests and responses are queued,
+// and resumes once less than half of it is, a partial frame never pauses it since only reading completes it
+constexpr size_t kMaxQueuedBytes = 16 * 1024 * 1024;
+
+// Reads of a connection stop after this many bytes so the others get their turn, the rest is read on the next wakeup
+constexpr size_t kMaxReadBurstBytes = 16 * 1024 * 1024;
+
+//=======================================================
+//		CServerConnection : One client, its socket and buffers
+//		input and write state belong to the event loop, the rest is shared with workers under mMutex
+//=======================================================
+struct CServerConnection
+{
+	explicit CServerConnection(int socketHandle) :
+		mSocket(socketHandle)
+	{
+
+	}
+
+	int mSocket;
+
+	// Bytes received that do not yet form a whole frame
+	std::string mInput;
+
+	// Response bytes being written, from mWriteOffset on
+	std::string mWriting;
+	size_t mWriteOffset = 0;
+
+	bool mReadPaused = false;
+	bool mPeerClosed = false;
+
+	std::mutex mMutex;
+
+	// Whole request frames not yet executed, and responses not yet handed to the event loop
+	std::string mRequests;
+	std::string mResponses;
+
+	// A worker is executing this connection's requests, at most one at a time keeps them in order
+	bool mScheduled = false;
+};
+
+using ServerConnectionPtr = std::shared_ptr<CServerConnection>;
+
+//=======================================================
+//		CWorkerPool : Fixed set of threads draining a job queue
+//=======================================================
+class CWorkerPool
+{
+public:
+	void Start(uint32_t workerCount)
+	{
+		for (uint32_t i = 0; i < workerCount; i++)
+		{
+			mWorkers.emplace_back([this]() { Work(); });
+		}
+	}
+
+	void Submit(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mJobs.push_back(std::move(job));
+		}
+
+		mJobAvailable.notify_one();
+	}
+
+	// Finish queued jobs and join the workers
+	void Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStopping = true;
+		}
+
+		mJobAvailable.notify_all();
+		for (auto& worker : mWorkers)
+		{
+			worker.join();
+		}
+
+		mWorkers.clear();
+	}
+
+private:
+	void Work()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mJobAvailable.wait(lock, [this]() { return mStopping || !mJobs.empty(); });
+				if (mJobs.empty())
+				{
+					return;
+				}
+
+				job = std::move(mJobs.front());
+				mJobs.pop_front();
+			}
+
+			job();
+		}
+	}
+
+private:
+	std::mutex mMutex;
+	std::condition_variable mJobAvailable;
+	std::deque<std::function<void()>> mJobs;
+	std::vector<std::thread> mWorkers;
+	bool mStopping = false;
+};
+
+//=======================================================
+//		CAddressBookServer : Serves the address book to socket clients
+//		one thread multiplexes every connection with epoll, workers execute the requests
+//=======================================================
+class CAddressBookServer
+{
+public:
+	~CAddressBookServer()
+	{
+		for (int handle : { mListenSocket, mWakeEvent, mEpoll })
+		{
+			if (handle >= 0)
+			{
+				close(handle);
+			}
+		}
+	}
+
+	// Listen on address, false with errno set on failure
+	bool Start(const CServerAddress& address, uint32_t workerCount)
+	{
+		mAddress = address;
+
+		mEpoll = epoll_create1(EPOLL_CLOEXEC);
+		mWakeEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		mListenSocket = socket(address.mUnix ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (mEpoll < 0 || mWakeEvent < 0 || mListenSocket < 0)
+		{
+			return false;
+		}
+
+		if (address.mUnix)
+		{
+			// A socket file left by a previous run would fail the bind
+			unlink(address.mPath.c_str());
+		}
+		else
+		{
+			int enabled = 1;
+			setsockopt(mListenSocket, SOL_SOCKET, SO_REUSEADDR, &enabled, sizeof(enabled));
+		}
+
+		sockaddr_storage socketAddress;
+		socklen_t socketAddressLength = address.ToSockaddr(socketAddress);
+		if (bind(mListenSocket, reinterpret_cast<sockaddr*>(&socketAddress), socketAddressLength) != 0 ||
+			listen(mListenSocket, SOMAXCONN) != 0)
+		{
+			return false;
+		}
+
+		// Events carry the handle, connections are looked up by it
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.fd = mListenSocket;
+		if (epoll_ctl(mEpoll, EPOLL_CTL_ADD, mListenSocket, &event) != 0)
+		{
+			return false;
+		}
+
+		event.data.fd = mWakeEvent;
+		if (epoll_ctl(mEpoll, EPOLL_CTL_ADD, mWakeEvent, &event) != 0)
+		{
+			return false;
+		}
+
+		mWorkers.Start(workerCount);
+		return true;
+	}
+
+	// Serve until Stop, then finish executing queued requests
+	void Run()
+	{
+		epoll_event events[kMaxEvents];
+		while (!mStopping.load())
+		{
+			int count = epoll_wait(mEpoll, events, kMaxEvents, -1);
+			if (count < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+
+				std::perror("epoll_wait");
+				break;
+			}
+
+			for (int i = 0; i < count; i++)
+			{
+				int handle = events[i].data.fd;
+				if (handle == mListenSocket)
+				{
+					Accept();
+				}
+				else if (handle == mWakeEvent)
+				{
+					FlushReady();
+				}
+				else
+				{
+					auto it = mConnections.find(handle);
+					if (it == mConnections.end())
+					{
+						continue;
+					}
+
+					// Keep the connection alive while its handlers may close it
+					ServerConnectionPtr connection = it->second;
+					if (events[i].events & EPOLLIN)
+					{
+						Read(connection);
+					}
+
+					// Hang up means nothing more can be sent either, pending responses are dropped
+					if (events[i].events & (EPOLLHUP | EPOLLERR))
+					{
+						Close(connection);
+					}
+					else if ((events[i].events & EPOLLOUT) && connection->mSocket >= 0)
+					{
+						Write(connection);
+					}
+				}
+			}
+		}
+
+		mWorkers.Stop();
+		while (!mConnections.empty())
+		{
+			Close(mConnections.begin()->second);
+		}
+
+		if (mAddress.mUnix)
+		{
+			unlink(mAddress.mPath.c_str());
+		}
+	}
+
+	// Make Run return, async-signal-safe
+	void Stop()
+	{
+		mStopping.store(true);
+		Wake();
+	}
+
+private:
+	void Wake()
+	{
+		uint64_t one = 1;
+		ssize_t written = write(mWakeEvent, &one, sizeof(one));
+		(void)written;
+	}
+
+	void Accept()
+	{
+		while (true)
+		{
+			int handle = accept4(mListenSocket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+			if (handle < 0)
+			{
+				if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+				{
+					std::perror("accept4");
+				}
+
+				return;
+			}
+
+			SetNoDelay(handle, mAddress);
+
+			epoll_event event = {};
+			event.events = EPOLLIN;
+			event.data.fd = handle;
+			if (epoll_ctl(mEpoll, EPOLL_CTL_ADD, handle, &event) != 0)
+			{
+				close(handle);
+				continue;
+			}
+
+			mConnections.emplace(handle, std::make_shared<CServerConnection>(handle));
+		}
+	}
+
+	// Drain the socket, queue whole frames for the workers
+	void Read(const ServerConnectionPtr& connection)
+	{
+		if (connection->mReadPaused)
+		{
+			return;
+		}
+
+		char chunk[kReadChunkBytes];
+		size_t readBytes = 0;
+		while (true)
+		{
+			ssize_t received = recv(connection->mSocket, chunk, sizeof(chunk), 0);
+			if (received > 0)
+			{
+				connection->mInput.append(chunk, static_cast<size_t>(received));
+				readBytes += static_cast<size_t>(received);
+				if (readBytes >= kMaxReadBurstBytes)
+				{
+					break;
+				}
+
+				continue;
+			}
+
+			if (received == 0)
+			{
+				// Requests already received are still answered
+				connection->mPeerClosed = true;
+			}
+			else if (errno == EINTR)
+			{
+				continue;
+			}
+			else if (errno != EAGAIN && errno != EWOULDBLOCK)
+			{
+				Close(connection);
+				return;
+			}
+
+			break;
+		}
+
+		QueueRequests(connection);
+	}
+
+	// Hand the whole frames of the input to a worker, pause reading if too much is queued
+	void QueueRequests(const ServerConnectionPtr& connection)
+	{
+		size_t frameBytes = 0;
+		uint32_t length = 0;
+		while (PeekFrameLength(connection->mInput.data() + frameBytes, connection->mInput.size() - frameBytes, length))
+		{
+			if (length > kServerMaxFrameBytes)
+			{
+				Close(connection);
+				return;
+			}
+
+			if (connection->mInput.size() - frameBytes < kServerFrameLengthBytes + length)
+			{
+				break;
+			}
+
+			frameBytes += kServerFrameLengthBytes + length;
+		}
+
+		size_t queuedBytes = 0;
+		bool schedule = false;
+		{
+			std::lock_guard<std::mutex> lock(connection->mMutex);
+			if (frameBytes > 0)
+			{
+				connection->mRequests.append(connection->mInput, 0, frameBytes);
+				schedule = !connection->mScheduled;
+				connection->mScheduled = true;
+			}
+
+			queuedBytes = connection->mRequests.size() + connection->mResponses.size();
+		}
+
+		connection->mInput.erase(0, frameBytes);
+
+		if (schedule)
+		{
+			mWorkers.Submit([this, connection]() { Execute(connection); });
+		}
+
+		queuedBytes += connection->mWriting.size() - connection->mWriteOffset;
+		// What is left of the input is less than a frame, at most kServerMaxFrameBytes
+		connection->mReadPaused = queuedBytes >= kMaxQueuedBytes;
+
+		if (!CloseIfDone(connection))
+		{
+			UpdateEvents(connection);
+		}
+	}
+
+	// Worker job, executes the connection's queued requests in order until none are left
+	void Execute(const ServerConnectionPtr& connection)
+	{
+		std::string requests;
+		std::string responses;
+		while (true)
+		{
+			{
+				std::lock_guard<std::mutex> lock(connection->mMutex);
+				connection->mResponses.append(responses);
+
+				requests.clear();
+				requests.swap(connection->mRequests);
+				if (requests.empty())
+				{
+					connection->mScheduled = false;
+				}
+			}
+
+			if (!responses.empty())
+			{
+				NotifyReady(connection);
+				responses.clear();
+			}
+
+			if (requests.empty())
+			{
+				return;
+			}
+
+			size_t offset = 0;
+			uint32_t length = 0;
+			while (PeekFrameLength(requests.data() + offset, requests.size() - offset, length))
+			{
+				offset += kServerFrameLengthBytes;
+				ExecuteRequest(requests.data() + offset, length, responses);
+				offset += length;
+			}
+		}
+	}
+
+	// Execute one request frame and append its response frame
+	static void ExecuteRequest(const char* data, size_t size, std::string& outResponses)
+	{
+		CFrameReader reader(data, size);
+
+		uint64_t id = 0;
+		uint8_t opcode = 0;
+		reader.GetU64(id);
+
+		AddressEntryError error = AddressEntryError::kAddressEntryInvalid;
+		AddressEntries entries;
+		if (reader.GetU8(opcode))
+		{
+			AddressEntry entry;
+			std::string key;
+			uint8_t option = 0;
+
+			switch (static_cast<ServerOpcode>(opcode))
+			{
+			case ServerOpcode::Add:
+				if (reader.GetEntry(entry) && reader.AtEnd())
+				{
+					error = AddressBookInterface::AddEntry(entry);
+				}
+				break;
+
+			case ServerOpcode::Remove:
+				if (reader.GetEntry(entry) && reader.GetU8(option) && reader.AtEnd())
+				{
+					error = AddressBookInterface::RemoveEntry(entry, option != 0);
+				}
+				break;
+
+			case ServerOpcode::Search:
+				if (reader.GetU8(option) && reader.GetString(key) && reader.AtEnd() &&
+					option <= static_cast<uint8_t>(AddressEntrySearchType::SubstringSearch))
+				{
+					entries = AddressBookInterface::Search(key, static_cast<AddressEntrySearchType>(option));
+					error = AddressEntryError::kAddressEntrySuccess;
+				}
+				break;
+
+			case ServerOpcode::Retrieve:
+				if (reader.GetU8(option) && reader.AtEnd() &&
+					option <= static_cast<uint8_t>(AddressEntryOrderType::LastNameOrder))
+				{
+					entries = AddressBookInterface::RetrieveEntries(static_cast<AddressEntryOrderType>(option));
+					error = AddressEntryError::kAddressEntrySuccess;
+				}
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		CFrameWriter writer(outResponses);
+		writer.PutU64(id);
+		writer.PutU32(static_cast<uint32_t>(error));
+		writer.PutU32(static_cast<uint32_t>(entries.size()));
+		for (const auto& entry : entries)
+		{
+			writer.PutEntry(entry);
+		}
+
+		writer.Finish();
+	}
+
+	// Called by workers, queue the connection for the event loop to flush
+	void NotifyReady(const ServerConnectionPtr& connection)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mReadyMutex);
+			mReady.push_back(connection);
+		}
+
+		Wake();
+	}
+
+	void FlushReady()
+	{
+		uint64_t count = 0;
+		ssize_t received = read(mWakeEvent, &count, sizeof(count));
+		(void)received;
+
+		std::vector<ServerConnectionPtr> ready;
+		{
+			std::lock_guard<std::mutex> lock(mReadyMutex);
+			ready.swap(mReady);
+		}
+
+		for (const auto& connection : ready)
+		{
+			if (connection->mSocket >= 0)
+			{
+				Write(connection);
+			}
+		}
+	}
+
+	// Write queued responses until the socket would block
+	void Write(const ServerConnectionPtr& connection)
+	{
+		if (connection->mWriteOffset == connection->mWriting.size())
+		{
+			connection->mWriting.clear();
+			connection->mWriteOffset = 0;
+		}
+
+		size_t queuedBytes = 0;
+		{
+			std::lock_guard<std::mutex> lock(connection->mMutex);
+			connection->mWriting.append(connection->mResponses);
+			connection->mResponses.clear();
+			queuedBytes = connection->mRequests.size();
+		}
+
+		while (connection->mWriteOffset < connection->mWriting.size())
+		{
+			ssize_t sent = send(connection->mSocket,
+								connection->mWriting.data() + connection->mWriteOffset,
+								connection->mWriting.size() - connection->mWriteOffset,
+								MSG_NOSIGNAL);
+			if (sent < 0)
+			{
+				if (errno == EINTR)
+				{
+					continue;
+				}
+
+				if (errno == EAGAIN || errno == EWOULDBLOCK)
+				{
+					break;
+				}
+
+				Close(connection);
+				return;
+			}
+
+			connection->mWriteOffset += static_cast<size_t>(sent);
+		}
+
+		queuedBytes += connection->mWriting.size() - connection->mWriteOffset;
+		if (connection->mReadPaused && queuedBytes < kMaxQueuedBytes / 2)
+		{
+			// Frames held back while paused are queued before reading more
+			connection->mReadPaused = false;
+			QueueRequests(connection);
+			return;
+		}
+
+		if (!CloseIfDone(connection))
+		{
+			UpdateEvents(connection);
+		}
+	}
+
+	// Close once the peer stopped sending and every request it sent was answered
+	bool CloseIfDone(const ServerConnectionPtr& connection)
+	{
+		if (!connection->mPeerClosed || connection->mWriteOffset < connection->mWriting.size())
+		{
+			return false;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(connection->mMutex);
+			if (connection->mScheduled || !connection->mResponses.empty())
+			{
+				return false;
+			}
+		}
+
+		Close(connection);
+		return true;
+	}
+
+	// Listen for input unless paused or closed by the peer, and for output while a write is pending
+	void UpdateEvents(const ServerConnectionPtr& connection)
+	{
+		bool wantWrite = connection->mWriteOffset < connection->mWriting.size();
+		bool wantRead = !connection->mReadPaused && !connection->mPeerClosed;
+
+		epoll_event event = {};
+		event.events = (wantRead ? static_cast<uint32_t>(EPOLLIN) : 0u) | (wantWrite ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+		event.data.fd = connection->mSocket;
+		epoll_ctl(mEpoll, EPOLL_CTL_MOD, connection->mSocket, &event);
+	}
+
+	void Close(const ServerConnectionPtr& connection)
+	{
+		if (connection->mSocket < 0)
+		{
+			return;
+		}
+
+		// Workers still holding the connection finish its queued requests, their responses are dropped
+		epoll_ctl(mEpoll, EPOLL_CTL_DEL, connection->mSocket, nullptr);
+		close(connection->mSocket);
+		mConnections.erase(connection->mSocket);
+		connection->mSocket = -1;
+	}
+
+private:
+	CServerAddress mAddress;
+	int mEpoll = -1;
+	int mListenSocket = -1;
+	int mWakeEvent = -1;
+	std::atomic<bool> mStopping{ false };
+
+	// Keyed by socket, event loop only
+	std::unordered_map<int, ServerConnectionPtr> mConnections;
+
+	std::mutex mReadyMutex;
+	std::vector<ServerConnectionPtr> mReady;
+
+	CWorkerPool mWorkers;
+};
+
+//=======================================================
+//		Signal handling
+//=======================================================
+static CAddressBookServer* gServer = nullptr;
+
+static void HandleStopSignal(int)
+{
+	if (gServer != nullptr)
+	{
+		gServer->Stop();
+	}
+}
+
+//=======================================================
+//		main
+//		usage: AddressBookServer [unix:<path> | tcp:<port>] [worker count]
+//=======================================================
+int main(int argc, char* argv[])
+{
+	CServerAddress address;
+	if (!address.Parse(argc > 1 ? argv[1] : kServerDefaultAddress))
+	{
+		std::fprintf(stderr, "usage: AddressBookServer [unix:<path> | tcp:<port>] [worker count]\n");
+		return 1;
+	}
+
+	uint32_t workerCount = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : kDefaultWorkerCount;
+	workerCount = std::max<uint32_t>(workerCount, 1);
+
+	CAddressBookServer server;
+	if (!server.Start(address, workerCount))
+	{
+		std::perror("AddressBookServer");
+		return 1;
+	}
+
+	gServer = &server;
+	std::signal(SIGINT, HandleStopSignal);
+	std::signal(SIGTERM, HandleStopSignal);
+
+	std::printf("Address book server listening on %s with %u workers\n", argc > 1 ? argv[1] : kServerDefaultAddress, workerCount);
+	std::fflush(stdout);
+
+	server.Run();
+
+	std::printf("Address book server stopped\n");
+	return 0;
+}
@@ -0,0 +1,847 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookInterface.h"
+#include "ToolsCommon.h"
+
+// System
+#include <filesystem>
+
+//=======================================================
+//		Allocation counting
+//=======================================================
+static std::atomic<uint64_t> gAllocationCount(0);
+
+void* operator new(size_t size)
+{
+	gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* pMemory = std::malloc(size == 0 ? 1 : size))
+	{
+		return pMemory;
+	}
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete(void* pMemory, size_t) noexcept
+{
+	std::free(pMemory);
+}
+
+//=======================================================
+//		Constants
+//=======================================================
+constexpr size_t kDefaultEntryCount = 200000;
+constexpr uint32_t kDefaultThreadCount = 4;
+constexpr uint32_t kDefaultSeed = 42;
+
+// Short prefixes match a large share of the book, so they are sampled less
+constexpr size_t kSearchKeyLengthMax = 5;
+constexpr size_t kSearchesPerKeyLength[kSearchKeyLengthMax] = { 100, 500, 1000, 2000, 5000 };
+
+// Ranked searches per key length, for the highest scored kRankedSearchCount entries
+constexpr size_t kRankedSearchKeyLengthMax = 3;
+constexpr size_t kRankedSearchesPerKeyLength = 2000;
+constexpr size_t kRankedSearchCount = 10;
+
+// Entry scores are drawn from [0, kRankedScoreMax)
+constexpr uint64_t kRankedScoreMax = 1000;
+
+// Substring searches per phase, with and without the trigram index
+constexpr size_t kSubstringSearchCount = 200;
+
+// Compound queries of a name prefix and a phone number prefix
+constexpr size_t kCompoundQueryCount = 1000;
+constexpr size_t kFullPassRepetitions = 5;
+constexpr size_t kInsertBatchSize = 1000;
+constexpr size_t kMixedOperationsPerThread = 5000;
+
+// Read-only searches per thread, against the locked and the frozen book
+constexpr size_t kConcurrentSearchesPerThread = 5000;
+
+// One in every kSyncChurnInterval entries is replaced in the synchronised export
+constexpr size_t kSyncChurnInterval = 100;
+
+// Slow sweeps pause for kSlowSweepPause every kSlowSweepPauseInterval entries,
+// while a writer adds an entry every kSlowSweepAddInterval
+constexpr size_t kSlowSweepPauseInterval = 1000;
+constexpr std::chrono::microseconds kSlowSweepPause(1000);
+constexpr std::chrono::microseconds kSlowSweepAddInterval(100);
+constexpr size_t kSlowSweepAddsMax = 10000;
+
+// Lookups of names no entry has, against the book and against its lookup filter
+constexpr size_t kMissingLookupCount = 5000;
+constexpr size_t kMissingKeyLength = 5;
+constexpr double kLookupFilterFalsePositiveRate = 0.01;
+
+// Entries read at random from a snapshot encoded into the compressed block format
+constexpr size_t kBlockReadCount = 20000;
+
+// Page cache of the tiered frozen book, well below its payload so searches of cold keys miss
+constexpr size_t kTieredCacheBytes = 2 * 1024 * 1024;
+
+//=======================================================
+//		PrintHeader : Print result table header
+//=======================================================
+static void PrintHeader()
+{
+	std::printf("%-34s %10s %14s %10s %10s %10s %10s %10s %10s\n",
+				"benchmark", "ops", "ops/s", "p50 us", "p90 us", "p99 us", "p99.9 us", "allocs/op", "peak MB");
+}
+
+//=======================================================
+//		RunPhase : Run and report a benchmark phase
+//		*phase* records one latency sample per operation
+//=======================================================
+template <typename Phase>
+static void RunPhase(const std::string& name, Phase&& phase)
+{
+	CLatencyRecorder latencies;
+
+	uint64_t allocationsBefore = gAllocationCount.load();
+	ToolsClock::time_point start = ToolsClock::now();
+
+	phase(latencies);
+
+	double elapsedSeconds = ElapsedNanoseconds(start) / 1e9;
+	uint64_t allocations = gAllocationCount.load() - allocationsBefore;
+
+	size_t operations = latencies.GetCount();
+	double perOperation = operations == 0 ? 0.0 : static_cast<double>(allocations) / operations;
+
+	std::printf("%-34s %10zu %14.0f %10.2f %10.2f %10.2f %10.2f %10.1f %10.1f\n",
+				name.c_str(),
+				operations,
+				elapsedSeconds > 0.0 ? operations / elapsedSeconds : 0.0,
+				latencies.Percentile(50.0) / 1e3,
+				latencies.Percentile(90.0) / 1e3,
+				latencies.Percentile(99.0) / 1e3,
+				latencies.Percentile(99.9) / 1e3,
+				perOperation,
+				PeakResidentBytes() / (1024.0 * 1024.0));
+	std::fflush(stdout);
+}
+
+//=======================================================
+//		Timed : Record latency of a single operation
+//=======================================================
+template <typename Operation>
+static void Timed(CLatencyRecorder& latencies, Operation&& operation)
+{
+	ToolsClock::time_point start = ToolsClock::now();
+	operation();
+	latencies.Record(ElapsedNanoseconds(start));
+}
+
+//=======================================================
+//		main
+//		usage: BenchmarkApp [entry count] [thread count] [seed]
+//=======================================================
+int main(int argc, char* argv[])
+{
+	const size_t entryCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : kDefaultEntryCount;
+	const uint32_t threadCount = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : kDefaultThreadCount;
+	const uint32_t seed = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : kDefaultSeed;
+
+	std::printf("Address book benchmark: %zu entries, %u threads, seed %u\n\n", entryCount, threadCount, seed);
+
+	// Datasets are generated up front so they are not part of any measurement
+	CDatasetGenerator generator(seed);
+	AddressEntries entryList = generator.NextEntries(entryCount);
+	std::vector<AddressEntry> entries(entryList.begin(), entryList.end());
+	entryList.clear();
+
+	std::vector<AddressEntry> removals(entries);
+	std::shuffle(removals.begin(), removals.end(), generator.GetGenerator());
+	removals.resize(removals.size() / 2);
+
+	PrintHeader();
+
+	RunPhase("insert", [&](CLatencyRecorder& latencies)
+		{
+			for (const auto& entry : entries)
+			{
+				Timed(latencies, [&]() { AddressBookInterface::AddEntry(entry); });
+			}
+		});
+
+	for (size_t keyLength = 1; keyLength <= kSearchKeyLengthMax; keyLength++)
+	{
+		std::vector<std::string> keys;
+		for (size_t i = 0; i < kSearchesPerKeyLength[keyLength - 1]; i++)
+		{
+			keys.push_back(generator.NextSearchKey(keyLength));
+		}
+
+		RunPhase("search prefix length " + std::to_string(keyLength), [&](CLatencyRecorder& latencies)
+			{
+				for (const auto& key : keys)
+				{
+					Timed(latencies, [&]() { AddressBookInterface::Search(key); });
+				}
+			});
+	}
+
+	std::vector<std::string> missingKeys;
+	std::vector<AddressEntry> missingEntries;
+	for (size_t i = 0; i < kMissingLookupCount; i++)
+	{
+		missingKeys.push_back(generator.NextMissingKey(kMissingKeyLength));
+
+		AddressEntry entry(generator.NextEntry());
+		entry.mFirstName = generator.NextMissingKey(kMissingKeyLength);
+		missingEntries.push_back(std::move(entry));
+	}
+
+	auto missingSearch = [&](CLatencyRecorder& latencies)
+		{
+			for (const auto& key : missingKeys)
+			{
+				Timed(latencies, [&]() { AddressBookInterface::Search(key); });
+			}
+		};
+
+	auto missingRemove = [&](CLatencyRecorder& latencies)
+		{
+			for (const auto& entry : missingEntries)
+			{
+				Timed(latencies, [&]() { AddressBookInterface::RemoveEntry(entry); });
+			}
+		};
+
+	RunPhase("search missing names", missingSearch);
+	RunPhase("remove missing entries", missingRemove);
+
+	AddressBookInterface::SetLookupFilter(entries.size(), kLookupFilterFalsePositiveRate);
+	RunPhase("search missing names (filter)", missingSearch);
+	RunPhase("remove missing entries (filter)", missingRemove);
+	AddressLookupFilterStats filterStats = AddressBookInterface::GetLookupFilterStats();
+	AddressBookInterface::SetLookupFilter(0, 0.0);
+
+	std::vector<uint64_t> scores;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		scores.push_back(generator.GetGenerator()() % kRankedScoreMax);
+	}
+
+	RunPhase("set scores", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t i = 0; i < entries.size(); i++)
+			{
+				Timed(latencies, [&]() { AddressBookInterface::SetEntryScore(entries[i], scores[i]); });
+			}
+		});
+
+	// The first ranked search rebuilds every ranking the new scores invalidated
+	for (size_t keyLength = 1; keyLength <= kRankedSearchKeyLengthMax; keyLength++)
+	{
+		std::vector<std::string> keys;
+		for (size_t i = 0; i < kRankedSearchesPerKeyLength; i++)
+		{
+			keys.push_back(generator.NextSearchKey(keyLength));
+		}
+
+		RunPhase("search ranked top " + std::to_string(kRankedSearchCount) + " length " + std::to_string(keyLength), [&](CLatencyRecorder& latencies)
+			{
+				for (const auto& key : keys)
+				{
+					Timed(latencies, [&]() { AddressBookInterface::SearchRanked(key, kRankedSearchCount); });
+				}
+			});
+	}
+
+	// Keys shorter than a trigram match large parts of the book
+	std::vector<std::string> substringKeys;
+	std::vector<std::string> shortSubstringKeys;
+	for (size_t i = 0; i < kSubstringSearchCount; i++)
+	{
+		substringKeys.push_back(generator.NextSubstringKey(3 + i % 3));
+		shortSubstringKeys.push_back(generator.NextSubstringKey(1 + i % 2));
+	}
+
+	RunPhase("search substring (scan)", [&](CLatencyRecorder& latencies)
+		{
+			for (const auto& key : substringKeys)
+			{
+				Timed(latencies, [&]() { AddressBookInterface::Search(key, AddressEntrySearchType::SubstringSearch); });
+			}
+		});
+
+	RunPhase("search substring 1-2 letters (scan)", [&](CLatencyRecorder& latencies)
+		{
+			for (const auto& key : shortSubstringKeys)
+			{
+				Timed(latencies, [&]() { AddressBookInterface::Search(key, AddressEntrySearchType::SubstringSearch); });
+			}
+		});
+
+	RunPhase("build substring index", [&](CLatencyRecorder& latencies)
+		{
+			Timed(latencies, [&]() { AddressBookInterface::SetSubstringIndexEnabled(true).get(); });
+		});
+
+	RunPhase("search substring (index)", [&](CLatencyRecorder& latencies)
+		{
+			for (const auto& key : substringKeys)
+			{
+				Timed(latencies, [&]() { AddressBookInterface::Search(key, AddressEntrySearchType::SubstringSearch); });
+			}
+		});
+
+	RunPhase("search substring 1-2 letters (index)", [&](CLatencyRecorder& latencies)
+		{
+			for (const auto& key : shortSubstringKeys)
+			{
+				Timed(latencies, [&]() { AddressBookInterface::Search(key, AddressEntrySearchType::SubstringSearch); });
+			}
+		});
+
+	// Later phases measure the book without index maintenance
+	AddressBookInterface::SetSubstringIndexEnabled(false).get();
+
+	std::vector<AddressQuery> queries;
+	for (size_t i = 0; i < kCompoundQueryCount; i++)
+	{
+		AddressQuery query;
+		query.mTerms.push_back({ (i % 2 == 0) ? AddressEntryField::FirstName : AddressEntryField::LastName, generator.NextSearchKey(2) });
+		query.mTerms.push_back({ AddressEntryField::PhoneNumber, std::to_string(100 + generator.GetGenerator()() % 900) });
+		queries.push_back(std::move(query));
+	}
+
+	RunPhase("query name and phone prefix", [&](CLatencyRecorder& latencies)
+		{
+			for (const auto& query : queries)
+			{
+				Timed(latencies, [&]() { AddressBookInterface::Query(query); });
+			}
+		});
+
+	RunPhase("retrieve first name order", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t i = 0; i < kFullPassRepetitions; i++)
+			{
+				Timed(latencies, [&]() { AddressBookInterface::RetrieveEntries(AddressEntryOrderType::FirstNameOrder); });
+			}
+		});
+
+	RunPhase("retrieve last name order", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t i = 0; i < kFullPassRepetitions; i++)
+			{
+				Timed(latencies, [&]() { AddressBookInterface::RetrieveEntries(AddressEntryOrderType::LastNameOrder); });
+			}
+		});
+
+	std::atomic<uint64_t> checksum(0);
+	RunPhase("foreach", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t i = 0; i < kFullPassRepetitions; i++)
+			{
+				Timed(latencies, [&]()
+					{
+						AddressBookInterface::ForEach([&](const AddressEntry& entry) { checksum += entry.mPhoneNumber.size(); });
+					});
+			}
+		});
+
+	RunPhase("parallel foreach unordered", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t i = 0; i < kFullPassRepetitions; i++)
+			{
+				Timed(latencies, [&]()
+					{
+						AddressBookInterface::ParallelForEach([&](const AddressEntry& entry) { checksum += entry.mPhoneNumber.size(); },
+															  AddressEntryTraversalType::Unordered);
+					});
+			}
+		});
+
+	RunPhase("parallel foreach ordered", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t i = 0; i < kFullPassRepetitions; i++)
+			{
+				Timed(latencies, [&]()
+					{
+						AddressBookInterface::ParallelForEach([&](const AddressEntry& entry) { checksum += entry.mPhoneNumber.size(); },
+															  AddressEntryTraversalType::Ordered);
+					});
+			}
+		});
+
+	// Every pin below follows a write, so none reuses the previous version
+	AddressEntry pinEntry(generator.NextEntry());
+	RunPhase("pin snapshot (after a write)", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t i = 0; i < kFullPassRepetitions; i++)
+			{
+				AddressBookInterface::AddEntry(pinEntry);
+				AddressBookInterface::RemoveEntry(pinEntry);
+				Timed(latencies, [&]() { AddressBookInterface::PinSnapshot(); });
+			}
+		});
+
+	AddressBookSnapshot snapshot(AddressBookInterface::PinSnapshot());
+	RunPhase("foreach (snapshot)", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t i = 0; i < kFullPassRepetitions; i++)
+			{
+				Timed(latencies, [&]()
+					{
+						snapshot.ForEach([&](const AddressEntry& entry) { checksum += entry.mPhoneNumber.size(); });
+					});
+			}
+		});
+
+	// Compressed block format against the fixed field-length record of the change log and tiered payload file
+	size_t naiveBytes = 0;
+	snapshot.ForEach([&](const AddressEntry& entry)
+		{
+			naiveBytes += 3 * sizeof(uint32_t) + entry.mFirstName.size() + entry.mLastName.size() + entry.mPhoneNumber.size();
+		});
+
+	std::string firstNameBlocks;
+	std::string lastNameBlocks;
+	RunPhase("encode blocks (first name order)", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t i = 0; i < kFullPassRepetitions; i++)
+			{
+				Timed(latencies, [&]() { firstNameBlocks = snapshot.Encode(AddressEntryOrderType::FirstNameOrder); });
+			}
+		});
+
+	RunPhase("encode blocks (last name order)", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t i = 0; i < kFullPassRepetitions; i++)
+			{
+				Timed(latencies, [&]() { lastNameBlocks = snapshot.Encode(AddressEntryOrderType::LastNameOrder); });
+			}
+		});
+
+	snapshot.Release();
+
+	AddressEntryBlockReader blockReader;
+	blockReader.Open(firstNameBlocks);
+	RunPhase("decode blocks", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t i = 0; i < kFullPassRepetitions; i++)
+			{
+				Timed(latencies, [&]()
+					{
+						blockReader.ForEach([&](const AddressEntry& entry) { checksum += entry.mPhoneNumber.size(); });
+					});
+			}
+		});
+
+	std::mt19937 blockIndexGenerator(seed);
+	RunPhase("read entry from blocks (random)", [&](CLatencyRecorder& latencies)
+		{
+			AddressEntry entry;
+			for (size_t i = 0; i < kBlockReadCount && blockReader.GetCount() != 0; i++)
+			{
+				size_t index = blockIndexGenerator() % blockReader.GetCount();
+				Timed(latencies, [&]() { blockReader.Read(index, entry); });
+			}
+		});
+
+	// Writer latency while a slow consumer sweeps the book, under the lock or from a snapshot
+	std::vector<AddressEntry> sweepEntries;
+	for (size_t i = 0; i < kSlowSweepAddsMax; i++)
+	{
+		AddressEntry entry(generator.NextEntry());
+		entry.mPhoneNumber += "8" + std::to_string(i);
+		sweepEntries.push_back(std::move(entry));
+	}
+
+	auto addsDuringSweep = [&](CLatencyRecorder& latencies, const std::function<void(const AddressEntryCallback&)>& sweep)
+		{
+			std::atomic<bool> sweeping(true);
+			std::thread reader([&]()
+				{
+					size_t visited = 0;
+					sweep([&](const AddressEntry&)
+						{
+							if (++visited % kSlowSweepPauseInterval == 0)
+							{
+								std::this_thread::sleep_for(kSlowSweepPause);
+							}
+						});
+
+					sweeping.store(false);
+				});
+
+			size_t added = 0;
+			while (sweeping.load() && added < sweepEntries.size())
+			{
+				std::this_thread::sleep_for(kSlowSweepAddInterval);
+				Timed(latencies, [&]() { AddressBookInterface::AddEntry(sweepEntries[added++]); });
+			}
+
+			reader.join();
+			for (size_t i = 0; i < added; i++)
+			{
+				AddressBookInterface::RemoveEntry(sweepEntries[i]);
+			}
+		};
+
+	RunPhase("adds during slow foreach", [&](CLatencyRecorder& latencies)
+		{
+			addsDuringSweep(latencies, [](const AddressEntryCallback& callback) { AddressBookInterface::ForEach(callback); });
+		});
+
+	RunPhase("adds during slow snapshot sweep", [&](CLatencyRecorder& latencies)
+		{
+			addsDuringSweep(latencies, [](const AddressEntryCallback& callback) { AddressBookInterface::PinSnapshot().ForEach(callback); });
+		});
+
+	std::vector<std::vector<std::string>> readKeys(threadCount);
+	for (uint32_t thread = 0; thread < threadCount; thread++)
+	{
+		for (size_t i = 0; i < kConcurrentSearchesPerThread; i++)
+		{
+			readKeys[thread].push_back(generator.NextSearchKey(3 + i % 3));
+		}
+	}
+
+	auto concurrentSearch = [&](CLatencyRecorder& latencies)
+		{
+			std::vector<CLatencyRecorder> threadLatencies(threadCount);
+			std::vector<std::thread> threads;
+
+			for (uint32_t thread = 0; thread < threadCount; thread++)
+			{
+				threads.emplace_back([&, thread]()
+					{
+						for (const auto& key : readKeys[thread])
+						{
+							Timed(threadLatencies[thread], [&]() { AddressBookInterface::Search(key); });
+						}
+					});
+			}
+
+			for (uint32_t thread = 0; thread < threadCount; thread++)
+			{
+				threads[thread].join();
+				latencies.Merge(threadLatencies[thread]);
+			}
+		};
+
+	RunPhase("search x" + std::to_string(threadCount) + " threads (locked)", concurrentSearch);
+
+	AddressBookMemoryUsage mutableUsage = AddressBookInterface::GetMemoryUsage();
+	AddressBookMemoryUsage frozenUsage;
+	RunPhase("freeze", [&](CLatencyRecorder& latencies)
+		{
+			Timed(latencies, [&]() { frozenUsage = AddressBookInterface::Freeze().get(); });
+		});
+
+	RunPhase("search x" + std::to_string(threadCount) + " threads (frozen)", concurrentSearch);
+
+	RunPhase("retrieve first name order (frozen)", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t i = 0; i < kFullPassRepetitions; i++)
+			{
+				Timed(latencies, [&]() { AddressBookInterface::RetrieveEntries(AddressEntryOrderType::FirstNameOrder); });
+			}
+		});
+
+	RunPhase("foreach (frozen)", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t i = 0; i < kFullPassRepetitions; i++)
+			{
+				Timed(latencies, [&]()
+					{
+						AddressBookInterface::ForEach([&](const AddressEntry& entry) { checksum += entry.mPhoneNumber.size(); });
+					});
+			}
+		});
+
+	RunPhase("thaw", [&](CLatencyRecorder& latencies)
+		{
+			Timed(latencies, [&]() { AddressBookInterface::Thaw().get(); });
+		});
+
+	// Tiered: entries spilled to a payload file, only the tries and offsets stay in memory
+	AddressBookInterface::SetTieredStorage(std::filesystem::temp_directory_path().string(), kTieredCacheBytes);
+
+	AddressBookMemoryUsage tieredUsage;
+	RunPhase("freeze (tiered)", [&](CLatencyRecorder& latencies)
+		{
+			Timed(latencies, [&]() { tieredUsage = AddressBookInterface::Freeze().get(); });
+		});
+
+	RunPhase("search x" + std::to_string(threadCount) + " threads (tiered)", concurrentSearch);
+	AddressBookTierStats searchTierStats = AddressBookInterface::GetTierStats();
+
+	RunPhase("foreach (tiered)", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t i = 0; i < kFullPassRepetitions; i++)
+			{
+				Timed(latencies, [&]()
+					{
+						AddressBookInterface::ForEach([&](const AddressEntry& entry) { checksum += entry.mPhoneNumber.size(); });
+					});
+			}
+		});
+
+	RunPhase("thaw (tiered)", [&](CLatencyRecorder& latencies)
+		{
+			Timed(latencies, [&]() { AddressBookInterface::Thaw().get(); });
+		});
+
+	// Bulk load: the same entries packed straight into a tiered frozen book, without the mutable tries
+	uint64_t loadSequence = 0;
+	AddressEntries loadEntries(AddressBookInterface::RetrieveChangeSnapshot(loadSequence));
+
+	AddressBookMemoryUsage loadedUsage;
+	RunPhase("bulk load (tiered)", [&](CLatencyRecorder& latencies)
+		{
+			auto it = loadEntries.cbegin();
+			Timed(latencies, [&]()
+				{
+					AddressBookInterface::LoadFrozen([&](AddressEntry& outEntry)
+						{
+							if (it == loadEntries.cend())
+							{
+								return false;
+							}
+
+							outEntry = *it++;
+							return true;
+						});
+				});
+
+			loadedUsage = AddressBookInterface::GetMemoryUsage();
+		});
+
+	AddressBookInterface::Thaw().get();
+	loadEntries.clear();
+	AddressBookInterface::SetTieredStorage("", 0);
+
+	RunPhase("remove", [&](CLatencyRecorder& latencies)
+		{
+			for (const auto& entry : removals)
+			{
+				Timed(latencies, [&]() { AddressBookInterface::RemoveEntry(entry); });
+			}
+		});
+
+	RunPhase("clear (half full)", [&](CLatencyRecorder& latencies)
+		{
+			Timed(latencies, [&]() { AddressBookInterface::Clear(); });
+		});
+
+	// Inserts below are also published to the change feed, as on a replicated leader
+	AddressBookInterface::SetChangeFeedCapacity(entries.size());
+
+	RunPhase("insert batches of " + std::to_string(kInsertBatchSize) + " (feed)", [&](CLatencyRecorder& latencies)
+		{
+			for (size_t begin = 0; begin < entries.size(); begin += kInsertBatchSize)
+			{
+				size_t end = std::min(entries.size(), begin + kInsertBatchSize);
+				Timed(latencies, [&]()
+					{
+						for (size_t i = begin; i < end; i++)
+						{
+							AddressBookInterface::AddEntry(entries[i]);
+						}
+					});
+			}
+		});
+
+	RunPhase("read changes in batches of " + std::to_string(kInsertBatchSize), [&](CLatencyRecorder& latencies)
+		{
+			uint64_t sequence = 0;
+			AddressChanges changes;
+			do
+			{
+				changes.clear();
+				Timed(latencies, [&]() { AddressBookInterface::ReadChanges(sequence, kInsertBatchSize, std::chrono::milliseconds(0), changes); });
+				if (!changes.empty())
+				{
+					sequence = changes.back().mSequence;
+				}
+			} while (!changes.empty());
+
+			checksum += sequence;
+		});
+
+	AddressBookInterface::SetChangeFeedCapacity(0);
+
+	// Fresh export with 1% of the entries replaced, against a full reload of the same export
+	AddressEntries exportEntries;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (i % kSyncChurnInterval != 0)
+		{
+			exportEntries.push_back(entries[i]);
+			continue;
+		}
+
+		AddressEntry entry(generator.NextEntry());
+		entry.mPhoneNumber += "9" + std::to_string(i);
+		exportEntries.push_back(std::move(entry));
+	}
+
+	AddressEntries originalEntries(entries.begin(), entries.end());
+	AddressEntrySyncStats syncStats;
+
+	RunPhase("sync export (1% churn)", [&](CLatencyRecorder& latencies)
+		{
+			Timed(latencies, [&]() { AddressBookInterface::SyncEntries(exportEntries, syncStats); });
+		});
+
+	RunPhase("sync export (unchanged)", [&](CLatencyRecorder& latencies)
+		{
+			Timed(latencies, [&]() { AddressBookInterface::SyncEntries(exportEntries, syncStats); });
+		});
+
+	RunPhase("clear and reload export", [&](CLatencyRecorder& latencies)
+		{
+			Timed(latencies, [&]()
+				{
+					AddressBookInterface::Clear();
+					AddressBookInterface::AddEntries(exportEntries);
+				});
+		});
+
+	// Back to the original entries for the mixed workload
+	AddressBookInterface::SyncEntries(originalEntries, syncStats);
+
+	// Mixed workload: 80% search, 10% insert of new entries, 10% remove
+	std::vector<std::vector<AddressEntry>> newEntries(threadCount);
+	std::vector<std::vector<std::string>> searchKeys(threadCount);
+	for (uint32_t thread = 0; thread < threadCount; thread++)
+	{
+		for (size_t i = 0; i < kMixedOperationsPerThread / 10; i++)
+		{
+			AddressEntry entry(generator.NextEntry());
+			entry.mPhoneNumber += std::to_string(thread) + "0" + std::to_string(i);
+			newEntries[thread].push_back(std::move(entry));
+		}
+
+		for (size_t i = 0; i < kMixedOperationsPerThread; i++)
+		{
+			searchKeys[thread].push_back(generator.NextSearchKey(2 + i % 4));
+		}
+	}
+
+	RunPhase("mixed 80/10/10 x" + std::to_string(threadCount) + " threads", [&](CLatencyRecorder& latencies)
+		{
+			std::vector<CLatencyRecorder> threadLatencies(threadCount);
+			std::vector<std::thread> threads;
+
+			for (uint32_t thread = 0; thread < threadCount; thread++)
+			{
+				threads.emplace_back([&, thread]()
+					{
+						size_t inserted = 0;
+						size_t removed = 0;
+						for (size_t i = 0; i < kMixedOperationsPerThread; i++)
+						{
+							if (i % 10 == 0)
+							{
+								const AddressEntry& entry = newEntries[thread][inserted++ % newEntries[thread].size()];
+								Timed(threadLatencies[thread], [&]() { AddressBookInterface::AddEntry(entry); });
+							}
+							else if (i % 10 == 5)
+							{
+								const AddressEntry& entry = entries[(thread + removed++ * threadCount) % entries.size()];
+								Timed(threadLatencies[thread], [&]() { AddressBookInterface::RemoveEntry(entry); });
+							}
+							else
+							{
+								const std::string& key = searchKeys[thread][i];
+								Timed(threadLatencies[thread], [&]() { AddressBookInterface::Search(key); });
+							}
+						}
+					});
+			}
+
+			for (uint32_t thread = 0; thread < threadCount; thread++)
+			{
+				threads[thread].join();
+				latencies.Merge(threadLatencies[thread]);
+			}
+		});
+
+	// Library side view of the same run, before the final clear empties the tries
+	AddressBookMetrics metrics = AddressBookInterface::GetMetrics();
+
+	RunPhase("clear (full)", [&](CLatencyRecorder& latencies)
+		{
+			Timed(latencies, [&]() { AddressBookInterface::Clear(); });
+		});
+
+	if (metrics.mEnabled)
+	{
+		std::printf("\n%-34s %10s %10s %10s %10s\n", "library metrics", "count", "mean us", "p99 us", "max us");
+		auto printHistogram = [](const char* name, const AddressBookLatencyHistogram& histogram)
+			{
+				std::printf("%-34s %10llu %10.2f %10.2f %10.2f\n", name,
+							static_cast<unsigned long long>(histogram.mCount),
+							histogram.Mean() / 1e3,
+							histogram.Percentile(99.0) / 1e3,
+							histogram.mMaxNanoseconds / 1e3);
+			};
+
+		printHistogram("lock wait", metrics.mLockWait);
+		printHistogram("lock hold", metrics.mLockHold);
+		printHistogram("foreach callback", metrics.mForEachCallback);
+	}
+
+	std::printf("\n%-34s %10s %10s %10s\n", "trie", "nodes", "entries", "MB");
+	auto printTrie = [](const char* name, const AddressTrieMetrics& trie)
+		{
+			std::printf("%-34s %10zu %10zu %10.1f\n", name, trie.mNodeCount, trie.mEntryCount, trie.mBytes / (1024.0 * 1024.0));
+		};
+
+	printTrie("first name", metrics.mFirstNameTrie);
+	printTrie("last name", metrics.mLastNameTrie);
+
+	std::printf("\n%-34s %10s %10s %10s\n", "memory", "nodes", "entries", "MB");
+	auto printUsage = [](const char* name, const AddressBookMemoryUsage& usage)
+		{
+			std::printf("%-34s %10zu %10zu %10.1f\n", name, usage.mLiveNodes + usage.mDeadNodes, usage.mEntries, usage.mBytes / (1024.0 * 1024.0));
+		};
+
+	printUsage("mutable", mutableUsage);
+	printUsage("frozen", frozenUsage);
+	printUsage("frozen (tiered)", tieredUsage);
+	printUsage("bulk loaded (tiered)", loadedUsage);
+
+	std::printf("\n%-34s %10s %10s %10s\n", "entry format", "MB", "B/entry", "% naive");
+	auto printFormat = [&](const char* name, size_t bytes)
+		{
+			std::printf("%-34s %10.1f %10.1f %10.1f\n", name,
+						bytes / (1024.0 * 1024.0),
+						blockReader.GetCount() != 0 ? static_cast<double>(bytes) / blockReader.GetCount() : 0.0,
+						naiveBytes != 0 ? 100.0 * bytes / naiveBytes : 0.0);
+		};
+
+	printFormat("length prefixed fields", naiveBytes);
+	printFormat("blocks (first name order)", firstNameBlocks.size());
+	printFormat("blocks (last name order)", lastNameBlocks.size());
+
+	std::printf("\n%-34s %10s %10s %10s %10s\n", "lookup filter", "MB", "lookups", "rejected", "false pos");
+	std::printf("%-34s %10.1f %10llu %10llu %10llu\n", "missing names",
+				filterStats.mBytes / (1024.0 * 1024.0),
+				static_cast<unsigned long long>(filterStats.mLookups),
+				static_cast<unsigned long long>(filterStats.mRejected),
+				static_cast<unsigned long long>(filterStats.mFalsePositives));
+
+	uint64_t pageReads = searchTierStats.mHits + searchTierStats.mMisses;
+	std::printf("\n%-34s %10s %10s %10s %10s\n", "tiered searches", "payload MB", "cache MB", "page reads", "hit %");
+	std::printf("%-34s %10.1f %10.1f %10llu %10.1f\n", "page cache",
+				searchTierStats.mPayloadBytes / (1024.0 * 1024.0),
+				searchTierStats.mBudgetBytes / (1024.0 * 1024.0),
+				static_cast<unsigned long long>(pageReads),
+				pageReads != 0 ? 100.0 * searchTierStats.mHits / pageReads : 0.0);
+
+	std::printf("\nchecksum %llu\n", static_cast<unsigned long long>(checksum.load()));
+	return 0;
+}
\ No newline at end of file
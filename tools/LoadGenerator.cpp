@@ -0,0 +1,514 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "ServerProtocol.h"
+#include "ToolsCommon.h"
+
+// System
+#include <cerrno>
+
+//=======================================================
+//		Constants
+//=======================================================
+constexpr uint32_t kDefaultConnectionCount = 4;
+constexpr size_t kDefaultPipelineDepth = 32;
+constexpr uint32_t kDefaultDurationSeconds = 5;
+constexpr size_t kDefaultEntryCount = 100000;
+constexpr uint32_t kDefaultSeed = 42;
+
+// Mixed workload shares in percent, the rest are searches
+constexpr uint32_t kMixedAddShare = 5;
+constexpr uint32_t kMixedRemoveShare = 5;
+
+// Prefix searches use keys of kMixedSearchKeyLengthMin to kMixedSearchKeyLengthMax characters
+constexpr size_t kMixedSearchKeyLengthMin = 3;
+constexpr size_t kMixedSearchKeyLengthMax = 5;
+
+// Full retrievals, one at a time
+constexpr size_t kRetrieveCount = 5;
+
+// Names with digits and punctuation, at the start and in the middle, every add of one must be rejected as invalid
+constexpr const char* kInvalidNames[] = { "1abc", "ab1c", "O'Brien", "ab-", "-ab", "Mary Ann" };
+
+// Room left in the largest frame for the request header and the rest of the entry
+constexpr size_t kLargeFrameMarginBytes = 1024;
+
+constexpr size_t kReceiveChunkBytes = 64 * 1024;
+
+//=======================================================
+//		CLoadResults : Latencies per opcode and rejected requests
+//=======================================================
+struct CLoadResults
+{
+	std::array<CLatencyRecorder, kServerOpcodeCount> mLatencies;
+	size_t mInvalidCount = 0;
+
+	void Merge(CLoadResults& other)
+	{
+		for (size_t i = 0; i < kServerOpcodeCount; i++)
+		{
+			mLatencies[i].Merge(other.mLatencies[i]);
+		}
+
+		mInvalidCount += other.mInvalidCount;
+	}
+};
+
+//=======================================================
+//		CLoadConnection : Blocking client connection keeping up to a pipeline depth of requests in flight
+//=======================================================
+class CLoadConnection
+{
+public:
+	~CLoadConnection()
+	{
+		if (mSocket >= 0)
+		{
+			close(mSocket);
+		}
+	}
+
+	bool Connect(const CServerAddress& address)
+	{
+		sockaddr_storage socketAddress;
+		socklen_t socketAddressLength = address.ToSockaddr(socketAddress);
+
+		mSocket = socket(address.mUnix ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (mSocket < 0 || connect(mSocket, reinterpret_cast<sockaddr*>(&socketAddress), socketAddressLength) != 0)
+		{
+			return false;
+		}
+
+		SetNoDelay(mSocket, address);
+		return true;
+	}
+
+	// Send requests appended by *nextRequest(id, buffer, opcode)*, which returns false when done,
+	// recording the latency of each from the send of its batch to its response
+	template <typename NextRequest>
+	bool Run(size_t pipelineDepth, NextRequest&& nextRequest, CLoadResults& outResults)
+	{
+		struct COutstanding
+		{
+			uint64_t mId;
+			ServerOpcode mOpcode;
+			ToolsClock::time_point mSent;
+		};
+
+		std::deque<COutstanding> outstanding;
+		std::string requests;
+		bool more = true;
+		while (true)
+		{
+			// Top the pipeline up in one write
+			size_t batchStart = outstanding.size();
+			while (more && outstanding.size() < pipelineDepth)
+			{
+				ServerOpcode opcode;
+				more = nextRequest(mNextId, requests, opcode);
+				if (more)
+				{
+					outstanding.push_back({ mNextId++, opcode, ToolsClock::time_point() });
+				}
+			}
+
+			ToolsClock::time_point sent = ToolsClock::now();
+			for (size_t i = batchStart; i < outstanding.size(); i++)
+			{
+				outstanding[i].mSent = sent;
+			}
+
+			if (!SendAll(requests))
+			{
+				return false;
+			}
+
+			requests.clear();
+			if (outstanding.empty())
+			{
+				return true;
+			}
+
+			// Responses come back in request order
+			if (!Receive())
+			{
+				return false;
+			}
+
+			size_t offset = 0;
+			uint32_t length = 0;
+			while (PeekFrameLength(mInput.data() + offset, mInput.size() - offset, length) &&
+				   mInput.size() - offset >= kServerFrameLengthBytes + length)
+			{
+				CFrameReader reader(mInput.data() + offset + kServerFrameLengthBytes, length);
+				uint64_t id = 0;
+				uint32_t error = 0;
+				if (outstanding.empty() || !reader.GetU64(id) || !reader.GetU32(error) || id != outstanding.front().mId)
+				{
+					std::fprintf(stderr, "Unexpected response\n");
+					return false;
+				}
+
+				if (static_cast<AddressEntryError>(error) == AddressEntryError::kAddressEntryInvalid)
+				{
+					outResults.mInvalidCount++;
+				}
+
+				const COutstanding& request = outstanding.front();
+				outResults.mLatencies[static_cast<size_t>(request.mOpcode)].Record(ElapsedNanoseconds(request.mSent));
+				outstanding.pop_front();
+
+				offset += kServerFrameLengthBytes + length;
+			}
+
+			mInput.erase(0, offset);
+		}
+	}
+
+private:
+	bool SendAll(const std::string& data)
+	{
+		size_t offset = 0;
+		while (offset < data.size())
+		{
+			ssize_t sent = send(mSocket, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+			if (sent < 0 && errno != EINTR)
+			{
+				std::perror("send");
+				return false;
+			}
+
+			offset += sent > 0 ? static_cast<size_t>(sent) : 0;
+		}
+
+		return true;
+	}
+
+	bool Receive()
+	{
+		char chunk[kReceiveChunkBytes];
+		while (true)
+		{
+			ssize_t received = recv(mSocket, chunk, sizeof(chunk), 0);
+			if (received > 0)
+			{
+				mInput.append(chunk, static_cast<size_t>(received));
+				return true;
+			}
+
+			if (received < 0 && errno == EINTR)
+			{
+				continue;
+			}
+
+			std::fprintf(stderr, "Connection closed by server\n");
+			return false;
+		}
+	}
+
+private:
+	int mSocket = -1;
+	uint64_t mNextId = 0;
+	std::string mInput;
+};
+
+//=======================================================
+//		Request builders
+//=======================================================
+static void PutAdd(uint64_t id, const AddressEntry& entry, std::string& outRequests)
+{
+	CFrameWriter writer(outRequests);
+	writer.PutU64(id);
+	writer.PutU8(static_cast<uint8_t>(ServerOpcode::Add));
+	writer.PutEntry(entry);
+	writer.Finish();
+}
+
+static void PutRemove(uint64_t id, const AddressEntry& entry, std::string& outRequests)
+{
+	CFrameWriter writer(outRequests);
+	writer.PutU64(id);
+	writer.PutU8(static_cast<uint8_t>(ServerOpcode::Remove));
+	writer.PutEntry(entry);
+	writer.PutU8(1);
+	writer.Finish();
+}
+
+static void PutSearch(uint64_t id, const std::string& key, std::string& outRequests)
+{
+	CFrameWriter writer(outRequests);
+	writer.PutU64(id);
+	writer.PutU8(static_cast<uint8_t>(ServerOpcode::Search));
+	writer.PutU8(static_cast<uint8_t>(AddressEntrySearchType::FirstAndLastNameSearch));
+	writer.PutString(key);
+	writer.Finish();
+}
+
+static void PutRetrieve(uint64_t id, AddressEntryOrderType orderType, std::string& outRequests)
+{
+	CFrameWriter writer(outRequests);
+	writer.PutU64(id);
+	writer.PutU8(static_cast<uint8_t>(ServerOpcode::Retrieve));
+	writer.PutU8(static_cast<uint8_t>(orderType));
+	writer.Finish();
+}
+
+//=======================================================
+//		RunConnections : Run *client(index, connection, results)* on each of count connections at once
+//=======================================================
+template <typename Client>
+static bool RunConnections(const CServerAddress& address, uint32_t count, Client&& client, CLoadResults& outResults)
+{
+	std::vector<CLoadResults> results(count);
+	std::atomic<bool> succeeded(true);
+	std::vector<std::thread> threads;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		threads.emplace_back([&, i]()
+			{
+				CLoadConnection connection;
+				if (!connection.Connect(address))
+				{
+					std::perror("connect");
+					succeeded.store(false);
+					return;
+				}
+
+				if (!client(i, connection, results[i]))
+				{
+					succeeded.store(false);
+				}
+			});
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	for (auto& result : results)
+	{
+		outResults.Merge(result);
+	}
+
+	return succeeded.load();
+}
+
+//=======================================================
+//		PrintRow : Report the latencies of one operation over a phase
+//=======================================================
+static void PrintRow(const std::string& name, CLatencyRecorder& latencies, double elapsedSeconds)
+{
+	if (latencies.GetCount() == 0)
+	{
+		return;
+	}
+
+	std::printf("%-34s %10zu %14.0f %10.2f %10.2f %10.2f %10.2f\n",
+				name.c_str(),
+				latencies.GetCount(),
+				elapsedSeconds > 0.0 ? latencies.GetCount() / elapsedSeconds : 0.0,
+				latencies.Percentile(50.0) / 1e3,
+				latencies.Percentile(90.0) / 1e3,
+				latencies.Percentile(99.0) / 1e3,
+				latencies.Percentile(99.9) / 1e3);
+	std::fflush(stdout);
+}
+
+//=======================================================
+//		main
+//		usage: LoadGenerator [unix:<path> | tcp:<port>] [connections] [pipeline depth] [seconds] [entry count] [seed]
+//=======================================================
+int main(int argc, char* argv[])
+{
+	CServerAddress address;
+	if (!address.Parse(argc > 1 ? argv[1] : kServerDefaultAddress))
+	{
+		std::fprintf(stderr, "usage: LoadGenerator [unix:<path> | tcp:<port>] [connections] [pipeline depth] [seconds] [entry count] [seed]\n");
+		return 1;
+	}
+
+	const uint32_t connectionCount = std::max<uint32_t>(argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : kDefaultConnectionCount, 1);
+	const size_t pipelineDepth = std::max<size_t>(argc > 3 ? std::strtoull(argv[3], nullptr, 10) : kDefaultPipelineDepth, 1);
+	const uint32_t durationSeconds = argc > 4 ? static_cast<uint32_t>(std::strtoul(argv[4], nullptr, 10)) : kDefaultDurationSeconds;
+	const size_t entryCount = argc > 5 ? std::strtoull(argv[5], nullptr, 10) : kDefaultEntryCount;
+	const uint32_t seed = argc > 6 ? static_cast<uint32_t>(std::strtoul(argv[6], nullptr, 10)) : kDefaultSeed;
+
+	std::printf("Address book load: %u connections, pipeline depth %zu, %u s, %zu entries, seed %u\n\n",
+				connectionCount, pipelineDepth, durationSeconds, entryCount, seed);
+
+	CDatasetGenerator generator(seed);
+	AddressEntries entryList = generator.NextEntries(entryCount);
+	std::vector<AddressEntry> entries(entryList.begin(), entryList.end());
+	entryList.clear();
+
+	std::printf("%-34s %10s %14s %10s %10s %10s %10s\n", "phase", "ops", "ops/s", "p50 us", "p90 us", "p99 us", "p99.9 us");
+
+	// Preload, each connection adds an interleaved share of the entries
+	CLoadResults preload;
+	ToolsClock::time_point start = ToolsClock::now();
+	bool succeeded = RunConnections(address, connectionCount, [&](uint32_t index, CLoadConnection& connection, CLoadResults& results)
+		{
+			size_t next = index;
+			return connection.Run(pipelineDepth, [&](uint64_t id, std::string& requests, ServerOpcode& outOpcode)
+				{
+					if (next >= entries.size())
+					{
+						return false;
+					}
+
+					PutAdd(id, entries[next], requests);
+					next += connectionCount;
+					outOpcode = ServerOpcode::Add;
+					return true;
+				}, results);
+		}, preload);
+
+	PrintRow("preload add", preload.mLatencies[static_cast<size_t>(ServerOpcode::Add)], ElapsedNanoseconds(start) / 1e9);
+
+	// Invalid names as first and as last name, the server must answer each with an error and keep the connection
+	CLoadResults invalid;
+	const size_t invalidAddCount = 2 * (sizeof(kInvalidNames) / sizeof(kInvalidNames[0]));
+	start = ToolsClock::now();
+	succeeded = succeeded && RunConnections(address, 1, [&](uint32_t, CLoadConnection& connection, CLoadResults& results)
+		{
+			size_t sent = 0;
+			return connection.Run(pipelineDepth, [&](uint64_t id, std::string& requests, ServerOpcode& outOpcode)
+				{
+					if (sent == invalidAddCount)
+					{
+						return false;
+					}
+
+					const std::string name(kInvalidNames[sent / 2]);
+					PutAdd(id, (sent % 2 == 0) ? AddressEntry(name, "Smith", "5550100", std::string()) : AddressEntry("Ann", name, "5550100", std::string()), requests);
+					sent++;
+					outOpcode = ServerOpcode::Add;
+					return true;
+				}, results);
+		}, invalid);
+
+	PrintRow("invalid add", invalid.mLatencies[static_cast<size_t>(ServerOpcode::Add)], ElapsedNanoseconds(start) / 1e9);
+	if (succeeded && invalid.mInvalidCount != invalidAddCount)
+	{
+		std::fprintf(stderr, "%zu of %zu invalid adds were rejected as invalid\n", invalid.mInvalidCount, invalidAddCount);
+		succeeded = false;
+	}
+
+	// An add of an invalid name filling a frame of nearly the maximum size, well past what pauses reading,
+	// must be read in full and answered
+	CLoadResults large;
+	start = ToolsClock::now();
+	succeeded = succeeded && RunConnections(address, 1, [&](uint32_t, CLoadConnection& connection, CLoadResults& results)
+		{
+			bool sent = false;
+			return connection.Run(1, [&](uint64_t id, std::string& requests, ServerOpcode& outOpcode)
+				{
+					if (sent)
+					{
+						return false;
+					}
+
+					std::string name("1");
+					name.append(kServerMaxFrameBytes - kLargeFrameMarginBytes, 'a');
+					PutAdd(id, AddressEntry(name, "Smith", "5550100", std::string()), requests);
+					sent = true;
+					outOpcode = ServerOpcode::Add;
+					return true;
+				}, results);
+		}, large);
+
+	PrintRow("largest frame add", large.mLatencies[static_cast<size_t>(ServerOpcode::Add)], ElapsedNanoseconds(start) / 1e9);
+	if (succeeded && large.mInvalidCount != 1)
+	{
+		std::fprintf(stderr, "add filling the largest frame was not rejected as invalid\n");
+		succeeded = false;
+	}
+
+	// Mixed searches, adds and removes for the duration, each connection removes only entries it added
+	CLoadResults mixed;
+	const ToolsClock::time_point deadline = ToolsClock::now() + std::chrono::seconds(durationSeconds);
+	start = ToolsClock::now();
+	succeeded = succeeded && RunConnections(address, connectionCount, [&](uint32_t index, CLoadConnection& connection, CLoadResults& results)
+		{
+			CDatasetGenerator clientGenerator(seed + 1 + index);
+			std::deque<AddressEntry> added;
+			uint64_t addCount = 0;
+
+			return connection.Run(pipelineDepth, [&](uint64_t id, std::string& requests, ServerOpcode& outOpcode)
+				{
+					if (ToolsClock::now() >= deadline)
+					{
+						return false;
+					}
+
+					uint32_t share = clientGenerator.GetGenerator()() % 100;
+					if (share < kMixedAddShare)
+					{
+						// Phone number suffix unique across connections keeps added entries distinct
+						AddressEntry entry(clientGenerator.NextEntry());
+						entry.mPhoneNumber += std::to_string(addCount++ * connectionCount + index);
+
+						PutAdd(id, entry, requests);
+						added.push_back(std::move(entry));
+						outOpcode = ServerOpcode::Add;
+					}
+					else if (share < kMixedAddShare + kMixedRemoveShare && !added.empty())
+					{
+						PutRemove(id, added.front(), requests);
+						added.pop_front();
+						outOpcode = ServerOpcode::Remove;
+					}
+					else
+					{
+						size_t keyLength = kMixedSearchKeyLengthMin +
+										   clientGenerator.GetGenerator()() % (kMixedSearchKeyLengthMax - kMixedSearchKeyLengthMin + 1);
+						PutSearch(id, clientGenerator.NextSearchKey(keyLength), requests);
+						outOpcode = ServerOpcode::Search;
+					}
+
+					return true;
+				}, results);
+		}, mixed);
+
+	double mixedSeconds = ElapsedNanoseconds(start) / 1e9;
+	CLatencyRecorder mixedTotal;
+	for (auto& latencies : mixed.mLatencies)
+	{
+		mixedTotal.Merge(latencies);
+	}
+
+	PrintRow("mixed search", mixed.mLatencies[static_cast<size_t>(ServerOpcode::Search)], mixedSeconds);
+	PrintRow("mixed add", mixed.mLatencies[static_cast<size_t>(ServerOpcode::Add)], mixedSeconds);
+	PrintRow("mixed remove", mixed.mLatencies[static_cast<size_t>(ServerOpcode::Remove)], mixedSeconds);
+	PrintRow("mixed total", mixedTotal, mixedSeconds);
+
+	// Whole book retrievals, the largest responses
+	CLoadResults retrieve;
+	start = ToolsClock::now();
+	succeeded = succeeded && RunConnections(address, 1, [&](uint32_t, CLoadConnection& connection, CLoadResults& results)
+		{
+			size_t sent = 0;
+			return connection.Run(1, [&](uint64_t id, std::string& requests, ServerOpcode& outOpcode)
+				{
+					if (sent == kRetrieveCount)
+					{
+						return false;
+					}
+
+					PutRetrieve(id, sent++ % 2 == 0 ? AddressEntryOrderType::FirstNameOrder : AddressEntryOrderType::LastNameOrder, requests);
+					outOpcode = ServerOpcode::Retrieve;
+					return true;
+				}, results);
+		}, retrieve);
+
+	PrintRow("retrieve", retrieve.mLatencies[static_cast<size_t>(ServerOpcode::Retrieve)], ElapsedNanoseconds(start) / 1e9);
+
+	size_t invalidCount = preload.mInvalidCount + mixed.mInvalidCount + retrieve.mInvalidCount;
+	if (invalidCount > 0)
+	{
+		std::printf("\n%zu requests rejected as invalid\n", invalidCount);
+	}
+
+	return succeeded ? 0 : 1;
+}
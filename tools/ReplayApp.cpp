@@ -0,0 +1,521 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookInterface.h"
+#include "ToolsCommon.h"
+
+// System
+#include <fstream>
+#include <sstream>
+
+//=======================================================
+//		Trace format
+//		one operation per line, tab separated, empty lines and lines starting with '#' are skipped
+//		<microseconds>	add			<first name>	<last name>	<phone number>
+//		<microseconds>	remove		<first name>	<last name>	<phone number>	[match 0|1]
+//		<microseconds>	search		<first|last|both|substring>	<key>
+//		<microseconds>	retrieve	<first|last>
+//		timestamps are relative to the start of the trace and must not decrease
+//=======================================================
+enum class ReplayOperation : uint32_t
+{
+	Add,
+	Remove,
+	Search,
+	Retrieve
+};
+
+constexpr size_t kReplayOperationCount = 4;
+constexpr const char* kReplayOperationNames[kReplayOperationCount] = { "add", "remove", "search", "retrieve" };
+
+constexpr const char* kReplaySearchTypeNames[] = { "first", "last", "both", "substring" };
+constexpr const char* kReplayOrderTypeNames[] = { "first", "last" };
+
+constexpr size_t kAddressEntryErrorCount = static_cast<size_t>(AddressEntryError::kAddressEntryIOFailure) + 1;
+constexpr const char* kAddressEntryErrorNames[kAddressEntryErrorCount] =
+	{ "success", "duplicate", "invalid", "not found", "not attempted", "read only", "out of sequence", "io failure" };
+
+//=======================================================
+//		Constants
+//=======================================================
+constexpr uint32_t kDefaultThreadCount = 4;
+constexpr size_t kDefaultGeneratedCount = 100000;
+constexpr uint32_t kDefaultSeed = 42;
+
+// Mean arrival rate of generated traces, arrivals are Poisson
+constexpr double kGeneratedOperationsPerSecond = 5000.0;
+
+// Generated operation shares in per mille, the rest are searches
+constexpr uint32_t kGeneratedAddShare = 300;
+constexpr uint32_t kGeneratedRemoveShare = 100;
+constexpr uint32_t kGeneratedRetrieveShare = 1;
+
+// Generated searches use keys of kGeneratedSearchKeyLengthMin to kGeneratedSearchKeyLengthMax characters
+constexpr size_t kGeneratedSearchKeyLengthMin = 2;
+constexpr size_t kGeneratedSearchKeyLengthMax = 5;
+
+// Histogram bars are scaled to the fullest bucket
+constexpr size_t kHistogramBarWidth = 40;
+
+//=======================================================
+//		CReplayRecord : One operation of a trace
+//=======================================================
+struct CReplayRecord
+{
+	uint64_t mMicroseconds = 0;
+	ReplayOperation mOperation = ReplayOperation::Search;
+	AddressEntry mEntry;
+	std::string mKey;
+
+	// Search or order type, or remove match
+	uint32_t mOption = 0;
+};
+
+//=======================================================
+//		CReplayResults : Latencies and outcomes per operation
+//=======================================================
+struct CReplayResults
+{
+	std::array<CLatencyRecorder, kReplayOperationCount> mLatencies;
+	std::array<std::array<uint64_t, kAddressEntryErrorCount>, kReplayOperationCount> mErrors{};
+
+	void Merge(const CReplayResults& other)
+	{
+		for (size_t i = 0; i < kReplayOperationCount; i++)
+		{
+			mLatencies[i].Merge(other.mLatencies[i]);
+			for (size_t error = 0; error < kAddressEntryErrorCount; error++)
+			{
+				mErrors[i][error] += other.mErrors[i][error];
+			}
+		}
+	}
+};
+
+//=======================================================
+//		FindName : Index of name in names, count if absent
+//=======================================================
+template <size_t Count>
+static uint32_t FindName(const char* const (&names)[Count], const std::string& name)
+{
+	uint32_t index = 0;
+	while (index < Count && name != names[index])
+	{
+		index++;
+	}
+
+	return index;
+}
+
+//=======================================================
+//		SplitFields : Split a line at tabs, keeping empty fields
+//=======================================================
+static std::vector<std::string> SplitFields(const std::string& line)
+{
+	std::vector<std::string> fields;
+	std::istringstream stream(line);
+	std::string field;
+	while (std::getline(stream, field, '\t'))
+	{
+		fields.push_back(field);
+	}
+
+	// A trailing tab ends an empty field
+	if (!line.empty() && line.back() == '\t')
+	{
+		fields.emplace_back();
+	}
+
+	return fields;
+}
+
+//=======================================================
+//		ParseRecord : Parse one trace line, false if malformed
+//=======================================================
+static bool ParseRecord(const std::string& line, CReplayRecord& outRecord)
+{
+	std::vector<std::string> fields = SplitFields(line);
+	if (fields.size() < 2 || fields[0].empty())
+	{
+		return false;
+	}
+
+	char* end = nullptr;
+	outRecord.mMicroseconds = std::strtoull(fields[0].c_str(), &end, 10);
+	if (*end != '\0')
+	{
+		return false;
+	}
+
+	uint32_t operation = FindName(kReplayOperationNames, fields[1]);
+	outRecord.mOperation = static_cast<ReplayOperation>(operation);
+	switch (outRecord.mOperation)
+	{
+	case ReplayOperation::Add:
+	case ReplayOperation::Remove:
+		if (fields.size() < 5 || fields.size() > (outRecord.mOperation == ReplayOperation::Add ? 5u : 6u))
+		{
+			return false;
+		}
+
+		outRecord.mEntry.mFirstName = fields[2];
+		outRecord.mEntry.mLastName = fields[3];
+		outRecord.mEntry.mPhoneNumber = fields[4];
+		outRecord.mOption = fields.size() == 6 ? (fields[5] != "0") : 1;
+		return true;
+
+	case ReplayOperation::Search:
+		outRecord.mOption = FindName(kReplaySearchTypeNames, fields.size() > 2 ? fields[2] : std::string());
+		if (fields.size() != 4 || outRecord.mOption == std::size(kReplaySearchTypeNames))
+		{
+			return false;
+		}
+
+		outRecord.mKey = fields[3];
+		return true;
+
+	case ReplayOperation::Retrieve:
+		outRecord.mOption = FindName(kReplayOrderTypeNames, fields.size() > 2 ? fields[2] : std::string());
+		return fields.size() == 3 && outRecord.mOption != std::size(kReplayOrderTypeNames);
+
+	default:
+		return false;
+	}
+}
+
+//=======================================================
+//		LoadTrace : Read every record of the trace at path, false after reporting the first error
+//=======================================================
+static bool LoadTrace(const std::string& path, std::vector<CReplayRecord>& outRecords)
+{
+	std::ifstream trace(path);
+	if (!trace.is_open())
+	{
+		std::fprintf(stderr, "Cannot open trace %s\n", path.c_str());
+		return false;
+	}
+
+	std::string line;
+	size_t lineNumber = 0;
+	while (std::getline(trace, line))
+	{
+		lineNumber++;
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		CReplayRecord record;
+		if (!ParseRecord(line, record))
+		{
+			std::fprintf(stderr, "%s:%zu: malformed operation\n", path.c_str(), lineNumber);
+			return false;
+		}
+
+		if (!outRecords.empty() && record.mMicroseconds < outRecords.back().mMicroseconds)
+		{
+			std::fprintf(stderr, "%s:%zu: timestamp goes backwards\n", path.c_str(), lineNumber);
+			return false;
+		}
+
+		outRecords.push_back(std::move(record));
+	}
+
+	return true;
+}
+
+//=======================================================
+//		Execute : Run one record against the address book
+//=======================================================
+static AddressEntryError Execute(const CReplayRecord& record)
+{
+	switch (record.mOperation)
+	{
+	case ReplayOperation::Add:
+		return AddressBookInterface::AddEntry(record.mEntry);
+
+	case ReplayOperation::Remove:
+		return AddressBookInterface::RemoveEntry(record.mEntry, record.mOption != 0);
+
+	case ReplayOperation::Search:
+		AddressBookInterface::Search(record.mKey, static_cast<AddressEntrySearchType>(record.mOption));
+		return AddressEntryError::kAddressEntrySuccess;
+
+	case ReplayOperation::Retrieve:
+		AddressBookInterface::RetrieveEntries(static_cast<AddressEntryOrderType>(record.mOption));
+		return AddressEntryError::kAddressEntrySuccess;
+
+	default:
+		return AddressEntryError::kAddressEntryNotAttempted;
+	}
+}
+
+//=======================================================
+//		Replay : Execute records on threadCount threads, taking them in trace order
+//		open loop starts record i at *scheduled(i)* and measures latency from then, so falling behind counts
+//		closed loop starts each record as soon as a thread is free and measures the call alone
+//=======================================================
+template <typename Schedule>
+static void Replay(const std::vector<CReplayRecord>& records,
+				   uint32_t threadCount,
+				   bool openLoop,
+				   Schedule&& scheduled,
+				   CReplayResults& outResults)
+{
+	std::atomic<size_t> next(0);
+	std::vector<CReplayResults> results(threadCount);
+	std::vector<std::thread> threads;
+	for (uint32_t i = 0; i < threadCount; i++)
+	{
+		threads.emplace_back([&, i]()
+			{
+				for (size_t index = next.fetch_add(1); index < records.size(); index = next.fetch_add(1))
+				{
+					ToolsClock::time_point start = ToolsClock::now();
+					if (openLoop)
+					{
+						start = scheduled(index);
+						std::this_thread::sleep_until(start);
+					}
+
+					const CReplayRecord& record = records[index];
+					AddressEntryError error = Execute(record);
+
+					size_t operation = static_cast<size_t>(record.mOperation);
+					results[i].mLatencies[operation].Record(ElapsedNanoseconds(start));
+					results[i].mErrors[operation][static_cast<size_t>(error)]++;
+				}
+			});
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	for (const auto& result : results)
+	{
+		outResults.Merge(result);
+	}
+}
+
+//=======================================================
+//		PrintResults : Percentiles, outcomes and histogram per operation
+//=======================================================
+static void PrintResults(CReplayResults& results, double elapsedSeconds)
+{
+	std::printf("%-10s %10s %14s %10s %10s %10s %10s %10s\n",
+				"operation", "ops", "ops/s", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+
+	for (size_t i = 0; i < kReplayOperationCount; i++)
+	{
+		CLatencyRecorder& latencies = results.mLatencies[i];
+		if (latencies.GetCount() == 0)
+		{
+			continue;
+		}
+
+		std::printf("%-10s %10zu %14.0f %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+					kReplayOperationNames[i],
+					latencies.GetCount(),
+					elapsedSeconds > 0.0 ? latencies.GetCount() / elapsedSeconds : 0.0,
+					latencies.Percentile(50.0) / 1e3,
+					latencies.Percentile(90.0) / 1e3,
+					latencies.Percentile(99.0) / 1e3,
+					latencies.Percentile(99.9) / 1e3,
+					latencies.Percentile(100.0) / 1e3);
+	}
+
+	for (size_t i = 0; i < kReplayOperationCount; i++)
+	{
+		if (results.mLatencies[i].GetCount() == 0)
+		{
+			continue;
+		}
+
+		std::printf("\n%s outcomes:", kReplayOperationNames[i]);
+		for (size_t error = 0; error < kAddressEntryErrorCount; error++)
+		{
+			if (results.mErrors[i][error] > 0)
+			{
+				std::printf(" %s %llu", kAddressEntryErrorNames[error],
+							static_cast<unsigned long long>(results.mErrors[i][error]));
+			}
+		}
+
+		std::printf("\n%s latency histogram:\n", kReplayOperationNames[i]);
+
+		AddressBookLatencyHistogram histogram = results.mLatencies[i].ToHistogram();
+		uint64_t fullest = *std::max_element(histogram.mBuckets.begin(), histogram.mBuckets.end());
+		for (uint32_t bucket = 0; bucket < kAddressBookLatencyBuckets; bucket++)
+		{
+			if (histogram.mBuckets[bucket] == 0)
+			{
+				continue;
+			}
+
+			size_t width = static_cast<size_t>(histogram.mBuckets[bucket] * kHistogramBarWidth / fullest);
+			std::printf("  [%12.3f, %12.3f) us %10llu %s\n",
+						static_cast<double>(uint64_t(1) << bucket) / 1e3,
+						static_cast<double>(uint64_t(2) << bucket) / 1e3,
+						static_cast<unsigned long long>(histogram.mBuckets[bucket]),
+						std::string(std::max<size_t>(width, 1), '#').c_str());
+		}
+	}
+}
+
+//=======================================================
+//		Generate : Write a synthetic trace of count operations
+//=======================================================
+static bool Generate(const std::string& path, size_t count, uint32_t seed)
+{
+	std::ofstream trace(path);
+	if (!trace.is_open())
+	{
+		std::fprintf(stderr, "Cannot create trace %s\n", path.c_str());
+		return false;
+	}
+
+	CDatasetGenerator generator(seed);
+	std::exponential_distribution<double> arrivals(kGeneratedOperationsPerSecond / 1e6);
+	std::deque<AddressEntry> added;
+	double microseconds = 0.0;
+
+	trace << "# Synthetic address book trace, seed " << seed << "\n";
+	for (size_t i = 0; i < count; i++)
+	{
+		microseconds += arrivals(generator.GetGenerator());
+		trace << static_cast<uint64_t>(microseconds) << '\t';
+
+		uint32_t share = generator.GetGenerator()() % 1000;
+		if (share < kGeneratedAddShare || (share < kGeneratedAddShare + kGeneratedRemoveShare && added.empty()))
+		{
+			// Phone number suffix makes colliding samples distinct
+			AddressEntry entry(generator.NextEntry());
+			entry.mPhoneNumber += std::to_string(i);
+
+			trace << "add\t" << entry.mFirstName << '\t' << entry.mLastName << '\t' << entry.mPhoneNumber << '\n';
+			added.push_back(std::move(entry));
+		}
+		else if (share < kGeneratedAddShare + kGeneratedRemoveShare)
+		{
+			// Remove a random earlier add
+			size_t index = generator.GetGenerator()() % added.size();
+			std::swap(added[index], added.back());
+
+			const AddressEntry& entry = added.back();
+			trace << "remove\t" << entry.mFirstName << '\t' << entry.mLastName << '\t' << entry.mPhoneNumber << '\n';
+			added.pop_back();
+		}
+		else if (share < kGeneratedAddShare + kGeneratedRemoveShare + kGeneratedRetrieveShare)
+		{
+			trace << "retrieve\t" << kReplayOrderTypeNames[generator.GetGenerator()() % 2] << '\n';
+		}
+		else
+		{
+			size_t keyLength = kGeneratedSearchKeyLengthMin +
+							   generator.GetGenerator()() % (kGeneratedSearchKeyLengthMax - kGeneratedSearchKeyLengthMin + 1);
+			trace << "search\t" << kReplaySearchTypeNames[generator.GetGenerator()() % 3] << '\t'
+				  << generator.NextSearchKey(keyLength) << '\n';
+		}
+	}
+
+	return trace.good();
+}
+
+//=======================================================
+//		PrintUsage
+//=======================================================
+static int PrintUsage()
+{
+	std::fprintf(stderr,
+				 "usage: ReplayApp <trace> [closed [thread count] | open <ops per second, 0 for trace timing> [thread count]]\n"
+				 "       ReplayApp generate <trace> [operation count] [seed]\n");
+	return 1;
+}
+
+//=======================================================
+//		main
+//=======================================================
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		return PrintUsage();
+	}
+
+	const std::string command(argv[1]);
+	if (command == "generate")
+	{
+		if (argc < 3)
+		{
+			return PrintUsage();
+		}
+
+		size_t count = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : kDefaultGeneratedCount;
+		uint32_t seed = argc > 4 ? static_cast<uint32_t>(std::strtoul(argv[4], nullptr, 10)) : kDefaultSeed;
+		return Generate(argv[2], count, seed) ? 0 : 1;
+	}
+
+	const std::string mode(argc > 2 ? argv[2] : "closed");
+	const bool openLoop = mode == "open";
+	if (!openLoop && mode != "closed")
+	{
+		return PrintUsage();
+	}
+
+	double rate = 0.0;
+	int threadArgument = 3;
+	if (openLoop)
+	{
+		if (argc < 4)
+		{
+			return PrintUsage();
+		}
+
+		rate = std::strtod(argv[3], nullptr);
+		threadArgument = 4;
+	}
+
+	uint32_t threadCount = argc > threadArgument ? static_cast<uint32_t>(std::strtoul(argv[threadArgument], nullptr, 10)) : kDefaultThreadCount;
+	threadCount = std::max<uint32_t>(threadCount, 1);
+
+	std::vector<CReplayRecord> records;
+	if (!LoadTrace(command, records))
+	{
+		return 1;
+	}
+
+	if (openLoop && rate > 0.0)
+	{
+		std::printf("Replaying %zu operations open loop at %.0f ops/s on %u threads\n\n", records.size(), rate, threadCount);
+	}
+	else if (openLoop)
+	{
+		std::printf("Replaying %zu operations open loop at trace timing on %u threads\n\n", records.size(), threadCount);
+	}
+	else
+	{
+		std::printf("Replaying %zu operations closed loop on %u threads\n\n", records.size(), threadCount);
+	}
+
+	CReplayResults results;
+	const uint64_t firstMicroseconds = records.empty() ? 0 : records.front().mMicroseconds;
+	const ToolsClock::time_point start = ToolsClock::now();
+
+	Replay(records, threadCount, openLoop, [&](size_t index)
+		{
+			std::chrono::nanoseconds offset = rate > 0.0
+				? std::chrono::nanoseconds(static_cast<int64_t>(index * 1e9 / rate))
+				: std::chrono::nanoseconds(std::chrono::microseconds(records[index].mMicroseconds - firstMicroseconds));
+			return start + std::chrono::duration_cast<ToolsClock::duration>(offset);
+		}, results);
+
+	PrintResults(results, ElapsedNanoseconds(start) / 1e9);
+	return 0;
+}
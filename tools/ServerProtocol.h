@@ -0,0 +1,256 @@
+#ifndef SERVER_PROTOCOL_H
+#define SERVER_PROTOCOL_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookTypes.h"
+
+// System
+#include <cstring>
+#include <cstdlib>
+
+#if !defined(__linux__)
+#error "The address book server protocol requires Linux sockets"
+#endif
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+//=======================================================
+//		Wire format
+//		every frame is a u32 byte count followed by that many bytes, integers are little endian
+//		request:  u64 id, u8 opcode, operands
+//		response: u64 id, u32 AddressEntryError, u32 entry count, entries
+//		strings are a u32 byte count and the bytes, an entry is first name, last name and phone number
+//		requests of a connection are executed and answered in the order they were sent,
+//		so clients may pipeline any number of them without waiting for responses
+//=======================================================
+enum class ServerOpcode : uint8_t
+{
+	Add,		// entry
+	Remove,		// entry, u8 match
+	Search,		// u8 AddressEntrySearchType, string key
+	Retrieve	// u8 AddressEntryOrderType
+};
+
+constexpr size_t kServerOpcodeCount = 4;
+
+constexpr size_t kServerFrameLengthBytes = sizeof(uint32_t);
+
+// Larger frames are a protocol error and close the connection
+constexpr uint32_t kServerMaxFrameBytes = 64 * 1024 * 1024;
+
+constexpr const char* kServerDefaultAddress = "unix:/tmp/addressbook.sock";
+
+//=======================================================
+//		CFrameWriter : Appends one frame to a buffer
+//=======================================================
+class CFrameWriter
+{
+public:
+	// C-tor, reserves the length of the frame
+	explicit CFrameWriter(std::string& buffer) :
+		mBuffer(buffer),
+		mStart(buffer.size())
+	{
+		mBuffer.append(kServerFrameLengthBytes, '\0');
+	}
+
+	void PutU8(uint8_t value) { mBuffer.push_back(static_cast<char>(value)); }
+	void PutU32(uint32_t value) { Put(value, sizeof(uint32_t)); }
+	void PutU64(uint64_t value) { Put(value, sizeof(uint64_t)); }
+
+	void PutString(const std::string& value)
+	{
+		PutU32(static_cast<uint32_t>(value.size()));
+		mBuffer.append(value);
+	}
+
+	void PutEntry(const AddressEntry& entry)
+	{
+		PutString(entry.mFirstName);
+		PutString(entry.mLastName);
+		PutString(entry.mPhoneNumber);
+	}
+
+	// Write the length of the frame, nothing may be put after
+	void Finish()
+	{
+		uint64_t length = mBuffer.size() - mStart - kServerFrameLengthBytes;
+		for (size_t i = 0; i < kServerFrameLengthBytes; i++)
+		{
+			mBuffer[mStart + i] = static_cast<char>((length >> (8 * i)) & 0xff);
+		}
+	}
+
+private:
+	void Put(uint64_t value, size_t bytes)
+	{
+		for (size_t i = 0; i < bytes; i++)
+		{
+			mBuffer.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+		}
+	}
+
+private:
+	std::string& mBuffer;
+	size_t mStart;
+};
+
+//=======================================================
+//		CFrameReader : Reads the body of one frame, every read fails once past its end
+//=======================================================
+class CFrameReader
+{
+public:
+	CFrameReader(const char* data, size_t size) :
+		mData(data),
+		mRemaining(size)
+	{
+
+	}
+
+	bool GetU8(uint8_t& outValue)
+	{
+		uint64_t value = 0;
+		bool read = Get(value, sizeof(uint8_t));
+		outValue = static_cast<uint8_t>(value);
+		return read;
+	}
+
+	bool GetU32(uint32_t& outValue)
+	{
+		uint64_t value = 0;
+		bool read = Get(value, sizeof(uint32_t));
+		outValue = static_cast<uint32_t>(value);
+		return read;
+	}
+
+	bool GetU64(uint64_t& outValue) { return Get(outValue, sizeof(uint64_t)); }
+
+	bool GetString(std::string& outValue)
+	{
+		uint32_t length = 0;
+		if (!GetU32(length) || length > mRemaining)
+		{
+			return false;
+		}
+
+		outValue.assign(mData, length);
+		mData += length;
+		mRemaining -= length;
+		return true;
+	}
+
+	bool GetEntry(AddressEntry& outEntry)
+	{
+		return GetString(outEntry.mFirstName) && GetString(outEntry.mLastName) && GetString(outEntry.mPhoneNumber);
+	}
+
+	bool AtEnd() const { return mRemaining == 0; }
+
+private:
+	bool Get(uint64_t& outValue, size_t bytes)
+	{
+		if (bytes > mRemaining)
+		{
+			return false;
+		}
+
+		outValue = 0;
+		for (size_t i = 0; i < bytes; i++)
+		{
+			outValue |= static_cast<uint64_t>(static_cast<uint8_t>(mData[i])) << (8 * i);
+		}
+
+		mData += bytes;
+		mRemaining -= bytes;
+		return true;
+	}
+
+private:
+	const char* mData;
+	size_t mRemaining;
+};
+
+//=======================================================
+//		PeekFrameLength : Body length of the frame at the start of data, false until the length is received
+//=======================================================
+inline bool PeekFrameLength(const char* data, size_t size, uint32_t& outLength)
+{
+	if (size < kServerFrameLengthBytes)
+	{
+		return false;
+	}
+
+	CFrameReader reader(data, kServerFrameLengthBytes);
+	return reader.GetU32(outLength);
+}
+
+//=======================================================
+//		CServerAddress : "unix:<path>" or "tcp:<port>", tcp is bound to and connects over loopback only
+//=======================================================
+struct CServerAddress
+{
+	bool mUnix = true;
+	std::string mPath;
+	uint16_t mPort = 0;
+
+	bool Parse(const std::string& text)
+	{
+		if (text.compare(0, 5, "unix:") == 0 && text.size() > 5)
+		{
+			mUnix = true;
+			mPath = text.substr(5);
+			return mPath.size() < sizeof(sockaddr_un::sun_path);
+		}
+
+		if (text.compare(0, 4, "tcp:") == 0 && text.size() > 4)
+		{
+			char* end = nullptr;
+			unsigned long port = std::strtoul(text.c_str() + 4, &end, 10);
+
+			mUnix = false;
+			mPort = static_cast<uint16_t>(port);
+			return *end == '\0' && port > 0 && port <= 0xffff;
+		}
+
+		return false;
+	}
+
+	// Fill *outAddress* for bind or connect, returns its length
+	socklen_t ToSockaddr(sockaddr_storage& outAddress) const
+	{
+		std::memset(&outAddress, 0, sizeof(outAddress));
+		if (mUnix)
+		{
+			sockaddr_un& address = reinterpret_cast<sockaddr_un&>(outAddress);
+			address.sun_family = AF_UNIX;
+			std::memcpy(address.sun_path, mPath.c_str(), mPath.size() + 1);
+			return sizeof(sockaddr_un);
+		}
+
+		sockaddr_in& address = reinterpret_cast<sockaddr_in&>(outAddress);
+		address.sin_family = AF_INET;
+		address.sin_port = htons(mPort);
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		return sizeof(sockaddr_in);
+	}
+};
+
+//=======================================================
+//		SetNoDelay : Send small tcp frames immediately, no-op for unix sockets
+//=======================================================
+inline void SetNoDelay(int socketHandle, const CServerAddress& address)
+{
+	if (!address.mUnix)
+	{
+		int enabled = 1;
+		setsockopt(socketHandle, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+	}
+}
+#endif // SERVER_PROTOCOL_H
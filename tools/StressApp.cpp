@@ -0,0 +1,1479 @@
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookInterface.h"
+#include "ToolsCommon.h"
+
+// System
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <set>
+#include <shared_mutex>
+
+//=======================================================
+//		Stress test
+//		worker threads add, remove, search and query entries at random while a chaos thread clears, freezes,
+//		thaws and compacts the book and toggles its fast paths (lookup filter, search cache, substring index,
+//		tiered storage), every worker checks its results against a reference model of the entries it owns,
+//		and every read is checked for ordering and repeated entries; between rounds the whole book is checked
+//		against the models through every read path, and once the rounds are done a book large enough for
+//		the parallel read paths is checked against the serial ones, mutable and frozen
+//
+//		build with -DADDRESS_BOOK_SANITIZER=thread or address to catch races and memory errors on the way,
+//		exits with 1 on the first broken invariant
+//=======================================================
+
+//=======================================================
+//		Enums
+//=======================================================
+// Book-wide operations of the chaos thread
+enum class StressChaosOperation : uint32_t
+{
+	Clear,
+	Freeze,
+	Thaw,
+	Compact,
+	LookupFilter,
+	SearchCache,
+	SubstringIndex,
+	TieredStorage
+};
+
+constexpr uint32_t kStressChaosOperationCount = 8;
+
+//=======================================================
+//		Constants
+//=======================================================
+constexpr uint32_t kDefaultRoundCount = 20;
+constexpr uint32_t kDefaultThreadCount = 8;
+constexpr uint32_t kDefaultSeed = 42;
+
+// Operations per worker thread and round
+constexpr size_t kStressOperationsPerThread = 2000;
+
+// Phone numbers of a worker's entries start with its two digit tag, so every worker owns the entries it adds
+constexpr uint32_t kStressFirstTag = 10;
+constexpr uint32_t kStressThreadCountMax = 90;
+constexpr size_t kStressPhoneSuffixLengthMax = 2;
+
+// Entries a worker picks from in a round, few enough that adds and removes keep hitting the same ones
+constexpr size_t kStressEntryPoolSize = 48;
+constexpr size_t kStressBatchSizeMax = 4;
+
+// Names of few letters in both cases, so entries share trie nodes and some differ only by case
+constexpr const char* kStressNameLetters = "abAB";
+constexpr size_t kStressNameLengthMax = 3;
+constexpr size_t kStressSearchKeyLengthMax = 3;
+
+// Characters no name may hold, put at the start, middle or end of otherwise valid names
+constexpr const char* kStressInvalidNameCharacters = "19'- .";
+
+// Invalid adds checked between rounds
+constexpr size_t kStressInvalidCheckCount = 32;
+
+// Worker operation shares in per mille, the rest are reads checked for consistency only
+constexpr uint32_t kStressAddShare = 250;
+constexpr uint32_t kStressAddBatchShare = 50;
+constexpr uint32_t kStressRemoveShare = 200;
+constexpr uint32_t kStressInvalidShare = 20;
+constexpr uint32_t kStressSearchShare = 250;
+constexpr uint32_t kStressQueryShare = 50;
+
+// Consistency-only reads, picked evenly
+constexpr uint32_t kStressReadKindCount = 7;
+constexpr size_t kStressRankedCountMax = 12;
+constexpr uint64_t kStressScoreMax = 100;
+constexpr size_t kStressStreamChunkSize = 16;
+
+// Chaos operation shares in per mille, in StressChaosOperation order, thawing more often than freezing keeps writes going
+constexpr uint32_t kStressChaosShares[kStressChaosOperationCount] = { 40, 150, 260, 100, 150, 100, 100, 100 };
+
+// Pause between chaos operations
+constexpr uint32_t kStressChaosPauseMaxMicroseconds = 2000;
+
+// Fast path settings the chaos thread toggles, small enough to fill up and evict
+constexpr size_t kStressLookupFilterEntries = 64;
+constexpr double kStressLookupFilterFalsePositiveRate = 0.01;
+constexpr size_t kStressSearchCacheBytes = 64 * 1024;
+constexpr size_t kStressTieredCacheBytes = 16 * 1024;
+
+// Entries of the scale check, several times the trie size the book starts retrieving on worker threads at
+constexpr size_t kStressScaleEntryCount = 32 * 1024;
+constexpr size_t kStressScaleNameLengthMax = 6;
+
+//=======================================================
+//		Aliases
+//=======================================================
+// Entries by EntryText, ordered so differences are reported deterministically
+using CStressEntrySet = std::set<std::string>;
+
+//=======================================================
+//		CStressFailure : First broken invariant, later ones are dropped
+//=======================================================
+class CStressFailure
+{
+public:
+	void Report(const std::string& message)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mMessage.empty())
+		{
+			mMessage = message;
+		}
+
+		mFailed.store(true);
+	}
+
+	bool HasFailed() const { return mFailed.load(); }
+
+	std::string GetMessage() const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mMessage;
+	}
+
+private:
+	mutable std::mutex mMutex;
+	std::string mMessage;
+	std::atomic<bool> mFailed{ false };
+};
+
+//=======================================================
+//		CStressWorker : Worker thread state and the reference model of the entries it owns
+//=======================================================
+struct CStressWorker
+{
+	std::string mTag;
+	std::mt19937 mGenerator;
+	std::vector<AddressEntry> mPool;
+
+	// Entries this worker has in the book, by EntryText
+	std::map<std::string, AddressEntry> mModel;
+
+	uint64_t mOperations = 0;
+};
+
+//=======================================================
+//		CStressState : State shared by every thread of a run
+//=======================================================
+struct CStressState
+{
+	// Workers update their own model holding it shared, Clear empties every model holding it exclusively
+	std::shared_mutex mModelMutex;
+
+	std::vector<std::unique_ptr<CStressWorker>> mWorkers;
+	CStressFailure mFailure;
+
+	// Workers still running, the chaos thread stops once none is
+	std::atomic<uint32_t> mRunningWorkers{ 0 };
+
+	// Set by the chaos thread, the only one freezing, thawing and toggling fast paths
+	bool mFrozen = false;
+	bool mLookupFilter = false;
+	bool mSearchCache = false;
+	bool mSubstringIndex = false;
+	bool mTieredStorage = false;
+};
+
+//=======================================================
+//		FoldCase : Lower case copy of a name
+//=======================================================
+static std::string FoldCase(const std::string& name)
+{
+	std::string folded(name);
+	std::transform(folded.begin(), folded.end(), folded.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return folded;
+}
+
+//=======================================================
+//		EntryText : Entry as a single string, for entry sets and messages
+//=======================================================
+static std::string EntryText(const AddressEntry& entry)
+{
+	return entry.mFirstName + "|" + entry.mLastName + "|" + entry.mPhoneNumber;
+}
+
+//=======================================================
+//		StartsWith : Check if text starts with prefix
+//=======================================================
+static bool StartsWith(const std::string& text, const std::string& prefix)
+{
+	return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+//=======================================================
+//		MatchesSearch : Check if entry is a result of searching the lower case key, as the book defines it
+//		prefix searches match the name and the other name after it, and only entries that have the name
+//=======================================================
+static bool MatchesSearch(const AddressEntry& entry, const std::string& key, AddressEntrySearchType searchType)
+{
+	auto matchesPrefix = [&key](const std::string& name, const std::string& rest)
+		{
+			return !name.empty() && StartsWith(FoldCase(name + rest), key);
+		};
+
+	switch (searchType)
+	{
+	case AddressEntrySearchType::FirstNameSearch:
+		return matchesPrefix(entry.mFirstName, entry.mLastName);
+	case AddressEntrySearchType::LastNameSearch:
+		return matchesPrefix(entry.mLastName, entry.mFirstName);
+	case AddressEntrySearchType::FirstAndLastNameSearch:
+		return matchesPrefix(entry.mFirstName, entry.mLastName) || matchesPrefix(entry.mLastName, entry.mFirstName);
+	case AddressEntrySearchType::SubstringSearch:
+		return FoldCase(entry.mFirstName).find(key) != std::string::npos || FoldCase(entry.mLastName).find(key) != std::string::npos;
+	default:
+		return false;
+	}
+}
+
+//=======================================================
+//		MatchesQuery : Check if entry is a result of query
+//=======================================================
+static bool MatchesQuery(const AddressEntry& entry, const AddressQuery& query)
+{
+	auto matches = [&entry](const AddressQueryTerm& term)
+		{
+			switch (term.mField)
+			{
+			case AddressEntryField::FirstName:
+				return StartsWith(FoldCase(entry.mFirstName), FoldCase(term.mPrefix));
+			case AddressEntryField::LastName:
+				return StartsWith(FoldCase(entry.mLastName), FoldCase(term.mPrefix));
+			case AddressEntryField::PhoneNumber:
+				return StartsWith(entry.mPhoneNumber, term.mPrefix);
+			default:
+				return false;
+			}
+		};
+
+	return query.mOperator == AddressQueryOperator::And ? std::all_of(query.mTerms.cbegin(), query.mTerms.cend(), matches)
+														: std::any_of(query.mTerms.cbegin(), query.mTerms.cend(), matches);
+}
+
+//=======================================================
+//		CheckUnique : Check no entry is repeated, the book never holds the same entry twice
+//=======================================================
+template <typename Entries>
+static bool CheckUnique(const char* what, const Entries& entries, std::string& outError)
+{
+	CStressEntrySet seen;
+	for (const AddressEntry& entry : entries)
+	{
+		if (!seen.insert(EntryText(entry)).second)
+		{
+			outError = std::string(what) + ": " + EntryText(entry) + " repeated";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//=======================================================
+//		CheckOrder : Check entries are in the order RetrieveEntries returns them in
+//		entries without the leading name first, then by leading and trailing name, case insensitively
+//=======================================================
+static bool CheckOrder(const char* what, const AddressEntries& entries, AddressEntryOrderType orderType, std::string& outError)
+{
+	bool firstNameOrder = orderType == AddressEntryOrderType::FirstNameOrder;
+
+	std::pair<bool, std::string> previous(false, std::string());
+	for (const AddressEntry& entry : entries)
+	{
+		const std::string& leadingName = firstNameOrder ? entry.mFirstName : entry.mLastName;
+		const std::string& trailingName = firstNameOrder ? entry.mLastName : entry.mFirstName;
+
+		std::pair<bool, std::string> key(!leadingName.empty(), FoldCase(leadingName + trailingName));
+		if (key < previous)
+		{
+			outError = std::string(what) + ": " + EntryText(entry) + " out of order";
+			return false;
+		}
+
+		previous = std::move(key);
+	}
+
+	return CheckUnique(what, entries, outError);
+}
+
+//=======================================================
+//		CheckEntries : Check entries hold exactly the expected ones, in any order
+//=======================================================
+template <typename Entries>
+static bool CheckEntries(const char* what, const Entries& entries, const CStressEntrySet& expected, std::string& outError)
+{
+	if (!CheckUnique(what, entries, outError))
+	{
+		return false;
+	}
+
+	CStressEntrySet actual;
+	for (const AddressEntry& entry : entries)
+	{
+		actual.insert(EntryText(entry));
+	}
+
+	for (const std::string& text : expected)
+	{
+		if (actual.find(text) == actual.end())
+		{
+			outError = std::string(what) + ": " + text + " missing";
+			return false;
+		}
+	}
+
+	for (const std::string& text : actual)
+	{
+		if (expected.find(text) == expected.end())
+		{
+			outError = std::string(what) + ": " + text + " unexpected";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//=======================================================
+//		CheckSnapshot : Check a snapshot agrees with itself across its read paths and its encoding
+//=======================================================
+static bool CheckSnapshot(const AddressBookSnapshot& snapshot, std::string& outError)
+{
+	AddressEntries firstNameOrder(snapshot.RetrieveEntries(AddressEntryOrderType::FirstNameOrder));
+	AddressEntries lastNameOrder(snapshot.RetrieveEntries(AddressEntryOrderType::LastNameOrder));
+	if (!CheckOrder("snapshot first name order", firstNameOrder, AddressEntryOrderType::FirstNameOrder, outError) ||
+		!CheckOrder("snapshot last name order", lastNameOrder, AddressEntryOrderType::LastNameOrder, outError))
+	{
+		return false;
+	}
+
+	if (firstNameOrder.size() != snapshot.GetEntryCount())
+	{
+		outError = "snapshot holds " + std::to_string(snapshot.GetEntryCount()) + " entries, retrieves " + std::to_string(firstNameOrder.size());
+		return false;
+	}
+
+	CStressEntrySet entries;
+	for (const AddressEntry& entry : firstNameOrder)
+	{
+		entries.insert(EntryText(entry));
+	}
+
+	AddressEntries visited;
+	snapshot.ForEach([&visited](const AddressEntry& entry) { visited.push_back(entry); });
+	if (!CheckEntries("snapshot last name order against first", lastNameOrder, entries, outError) ||
+		!CheckEntries("snapshot foreach", visited, entries, outError))
+	{
+		return false;
+	}
+
+	AddressEntryBlockReader reader;
+	AddressEntries decoded;
+	if (reader.Open(snapshot.Encode(AddressEntryOrderType::FirstNameOrder)) != AddressEntryError::kAddressEntrySuccess ||
+		reader.ReadAll(decoded) != AddressEntryError::kAddressEntrySuccess ||
+		decoded != firstNameOrder)
+	{
+		outError = "snapshot encoding does not decode to its entries";
+		return false;
+	}
+
+	return true;
+}
+
+//=======================================================
+//		RandomName : Name of up to kStressNameLengthMax letters, may be empty
+//=======================================================
+static std::string RandomName(std::mt19937& generator, size_t lengthMin = 0)
+{
+	static const size_t kLetterCount = std::strlen(kStressNameLetters);
+
+	std::string name;
+	size_t length = lengthMin + generator() % (kStressNameLengthMax - lengthMin + 1);
+	for (size_t i = 0; i < length; i++)
+	{
+		name.push_back(kStressNameLetters[generator() % kLetterCount]);
+	}
+
+	return name;
+}
+
+//=======================================================
+//		RandomInvalidName : Name of letters with a digit or punctuation put in anywhere
+//=======================================================
+static std::string RandomInvalidName(std::mt19937& generator)
+{
+	static const size_t kCharacterCount = std::strlen(kStressInvalidNameCharacters);
+
+	std::string name(RandomName(generator, 1));
+	name.insert(name.begin() + generator() % (name.size() + 1), kStressInvalidNameCharacters[generator() % kCharacterCount]);
+	return name;
+}
+
+//=======================================================
+//		RandomEntry : Valid entry owned by worker
+//=======================================================
+static AddressEntry RandomEntry(CStressWorker& worker)
+{
+	AddressEntry entry;
+	do
+	{
+		entry.mFirstName = RandomName(worker.mGenerator);
+		entry.mLastName = RandomName(worker.mGenerator);
+	} while (entry.mFirstName.empty() && entry.mLastName.empty());
+
+	entry.mPhoneNumber = worker.mTag;
+	size_t suffixLength = worker.mGenerator() % (kStressPhoneSuffixLengthMax + 1);
+	for (size_t i = 0; i < suffixLength; i++)
+	{
+		entry.mPhoneNumber.push_back(static_cast<char>('0' + worker.mGenerator() % 10));
+	}
+
+	return entry;
+}
+
+//=======================================================
+//		RandomInvalidEntry : Entry owned by worker with an invalid first or last name, or both
+//=======================================================
+static AddressEntry RandomInvalidEntry(CStressWorker& worker)
+{
+	AddressEntry entry(RandomEntry(worker));
+	switch (worker.mGenerator() % 3)
+	{
+	case 0:
+		entry.mFirstName = RandomInvalidName(worker.mGenerator);
+		break;
+	case 1:
+		entry.mLastName = RandomInvalidName(worker.mGenerator);
+		break;
+	default:
+		entry.mFirstName = RandomInvalidName(worker.mGenerator);
+		entry.mLastName = RandomInvalidName(worker.mGenerator);
+		break;
+	}
+
+	return entry;
+}
+
+//=======================================================
+//		RandomSearchType
+//=======================================================
+static AddressEntrySearchType RandomSearchType(std::mt19937& generator)
+{
+	return static_cast<AddressEntrySearchType>(generator() % (static_cast<uint32_t>(AddressEntrySearchType::SubstringSearch) + 1));
+}
+
+//=======================================================
+//		RandomOrderType
+//=======================================================
+static AddressEntryOrderType RandomOrderType(std::mt19937& generator)
+{
+	return (generator() % 2 == 0) ? AddressEntryOrderType::FirstNameOrder : AddressEntryOrderType::LastNameOrder;
+}
+
+//=======================================================
+//		CheckAdd : Add an entry of the pool and check the outcome against the model
+//		writes of a frozen book fail with kAddressEntryReadOnly and leave the model alone
+//=======================================================
+static bool CheckAdd(CStressWorker& worker, std::string& outError)
+{
+	const AddressEntry& entry = worker.mPool[worker.mGenerator() % worker.mPool.size()];
+	std::string text(EntryText(entry));
+	bool inModel = worker.mModel.find(text) != worker.mModel.end();
+
+	AddressEntryError result = AddressBookInterface::AddEntry(entry);
+	if ((result == AddressEntryError::kAddressEntrySuccess && inModel) ||
+		(result == AddressEntryError::kAddressEntryDuplicate && !inModel) ||
+		(result != AddressEntryError::kAddressEntrySuccess && result != AddressEntryError::kAddressEntryDuplicate &&
+		 result != AddressEntryError::kAddressEntryReadOnly))
+	{
+		outError = "add " + text + " returned " + std::to_string(static_cast<uint32_t>(result)) + (inModel ? ", entry is in the book" : ", entry is not in the book");
+		return false;
+	}
+
+	if (result == AddressEntryError::kAddressEntrySuccess)
+	{
+		worker.mModel.emplace(text, entry);
+	}
+
+	return true;
+}
+
+//=======================================================
+//		CheckAddBatch : Add distinct entries of the pool at once, every entry is added or none is
+//=======================================================
+static bool CheckAddBatch(CStressWorker& worker, std::string& outError)
+{
+	AddressEntries batch;
+	CStressEntrySet batchTexts;
+	bool anyInModel = false;
+
+	size_t batchSize = 1 + worker.mGenerator() % kStressBatchSizeMax;
+	for (size_t i = 0; i < batchSize; i++)
+	{
+		const AddressEntry& entry = worker.mPool[worker.mGenerator() % worker.mPool.size()];
+		std::string text(EntryText(entry));
+		if (batchTexts.insert(text).second)
+		{
+			batch.push_back(entry);
+			anyInModel = anyInModel || worker.mModel.find(text) != worker.mModel.end();
+		}
+	}
+
+	AddressEntryError result = AddressBookInterface::AddEntries(batch);
+	if ((result == AddressEntryError::kAddressEntrySuccess && anyInModel) ||
+		(result == AddressEntryError::kAddressEntryDuplicate && !anyInModel) ||
+		(result != AddressEntryError::kAddressEntrySuccess && result != AddressEntryError::kAddressEntryDuplicate &&
+		 result != AddressEntryError::kAddressEntryReadOnly))
+	{
+		outError = "add batch of " + std::to_string(batch.size()) + " returned " + std::to_string(static_cast<uint32_t>(result)) +
+				   (anyInModel ? ", an entry is in the book" : ", no entry is in the book");
+		return false;
+	}
+
+	if (result == AddressEntryError::kAddressEntrySuccess)
+	{
+		for (const AddressEntry& entry : batch)
+		{
+			worker.mModel.emplace(EntryText(entry), entry);
+		}
+	}
+
+	return true;
+}
+
+//=======================================================
+//		CheckRemove : Remove an entry of the pool exactly and check the outcome against the model
+//=======================================================
+static bool CheckRemove(CStressWorker& worker, std::string& outError)
+{
+	const AddressEntry& entry = worker.mPool[worker.mGenerator() % worker.mPool.size()];
+	std::string text(EntryText(entry));
+	auto it = worker.mModel.find(text);
+
+	AddressEntryError result = AddressBookInterface::RemoveEntry(entry);
+	if ((result == AddressEntryError::kAddressEntrySuccess && it == worker.mModel.end()) ||
+		(result == AddressEntryError::kAddressEntryNotFound && it != worker.mModel.end()) ||
+		(result != AddressEntryError::kAddressEntrySuccess && result != AddressEntryError::kAddressEntryNotFound &&
+		 result != AddressEntryError::kAddressEntryReadOnly))
+	{
+		outError = "remove " + text + " returned " + std::to_string(static_cast<uint32_t>(result)) +
+				   (it != worker.mModel.end() ? ", entry is in the book" : ", entry is not in the book");
+		return false;
+	}
+
+	if (result == AddressEntryError::kAddressEntrySuccess)
+	{
+		worker.mModel.erase(it);
+	}
+
+	return true;
+}
+
+//=======================================================
+//		CheckInvalid : Check invalid entries and search keys are rejected
+//=======================================================
+static bool CheckInvalid(CStressWorker& worker, std::string& outError)
+{
+	// A frozen book rejects every write before looking at the entry
+	auto isRejected = [](AddressEntryError result)
+		{
+			return result == AddressEntryError::kAddressEntryInvalid || result == AddressEntryError::kAddressEntryReadOnly;
+		};
+
+	AddressEntry noName(std::string(), std::string(), worker.mTag, std::string());
+	AddressEntry badPhone(RandomName(worker.mGenerator, 1), std::string(), worker.mTag + "x", std::string());
+	if (!isRejected(AddressBookInterface::AddEntry(noName)) || !isRejected(AddressBookInterface::AddEntry(badPhone)) ||
+		AddressBookInterface::RemoveEntry(badPhone) != AddressEntryError::kAddressEntryInvalid)
+	{
+		outError = "invalid entry was not rejected";
+		return false;
+	}
+
+	if (!AddressBookInterface::Search(RandomName(worker.mGenerator, 1) + "1").empty())
+	{
+		outError = "search for a key that is not alphabets only found entries";
+		return false;
+	}
+
+	// Invalid names alone and last in a batch of entries not in the book, so the batch's earlier entries are prepared and aborted
+	AddressEntry invalidName(RandomInvalidEntry(worker));
+	AddressEntries batch;
+	for (size_t i = worker.mGenerator() % kStressBatchSizeMax; i > 0; i--)
+	{
+		AddressEntry entry(RandomEntry(worker));
+		std::string text(EntryText(entry));
+		if (worker.mModel.find(text) == worker.mModel.end() &&
+			std::none_of(batch.cbegin(), batch.cend(), [&text](const AddressEntry& other) { return EntryText(other) == text; }))
+		{
+			batch.push_back(entry);
+		}
+	}
+
+	batch.push_back(RandomInvalidEntry(worker));
+	if (!isRejected(AddressBookInterface::AddEntry(invalidName)) || !isRejected(AddressBookInterface::AddEntries(batch)))
+	{
+		outError = "entry with invalid name " + EntryText(invalidName) + " or batch ending with " + EntryText(batch.back()) + " was not rejected";
+		return false;
+	}
+
+	// Nothing of the rejected adds is left behind
+	AddressQuery query;
+	query.mTerms.push_back({ AddressEntryField::PhoneNumber, worker.mTag });
+
+	CStressEntrySet owned;
+	for (const auto& modelEntry : worker.mModel)
+	{
+		owned.insert(modelEntry.first);
+	}
+
+	return CheckEntries("query after invalid adds", AddressBookInterface::Query(query), owned, outError);
+}
+
+//=======================================================
+//		CheckSearch : Search a random key, results must match it and hold exactly the worker's matching entries
+//=======================================================
+static bool CheckSearch(CStressWorker& worker, std::string& outError)
+{
+	std::string searchKey(RandomName(worker.mGenerator, 1).substr(0, kStressSearchKeyLengthMax));
+	std::string key(FoldCase(searchKey));
+	AddressEntrySearchType searchType = RandomSearchType(worker.mGenerator);
+
+	AddressEntries result(AddressBookInterface::Search(searchKey, searchType));
+
+	AddressEntries owned;
+	for (const AddressEntry& entry : result)
+	{
+		if (!MatchesSearch(entry, key, searchType))
+		{
+			outError = "search " + searchKey + " found " + EntryText(entry);
+			return false;
+		}
+
+		if (StartsWith(entry.mPhoneNumber, worker.mTag))
+		{
+			owned.push_back(entry);
+		}
+	}
+
+	CStressEntrySet expected;
+	for (const auto& modelEntry : worker.mModel)
+	{
+		if (MatchesSearch(modelEntry.second, key, searchType))
+		{
+			expected.insert(modelEntry.first);
+		}
+	}
+
+	std::string what("search " + searchKey + " type " + std::to_string(static_cast<uint32_t>(searchType)));
+	return CheckUnique(what.c_str(), result, outError) && CheckEntries(what.c_str(), owned, expected, outError);
+}
+
+//=======================================================
+//		CheckQuery : Query the worker's phone tag and maybe a name prefix, results must be exactly the matching model entries
+//=======================================================
+static bool CheckQuery(CStressWorker& worker, std::string& outError)
+{
+	AddressQuery query;
+	query.mTerms.push_back({ AddressEntryField::PhoneNumber, worker.mTag });
+	if (worker.mGenerator() % 2 == 0)
+	{
+		AddressEntryField field = (worker.mGenerator() % 2 == 0) ? AddressEntryField::FirstName : AddressEntryField::LastName;
+		query.mTerms.push_back({ field, RandomName(worker.mGenerator, 1) });
+	}
+
+	CStressEntrySet expected;
+	for (const auto& modelEntry : worker.mModel)
+	{
+		if (MatchesQuery(modelEntry.second, query))
+		{
+			expected.insert(modelEntry.first);
+		}
+	}
+
+	return CheckEntries("query", AddressBookInterface::Query(query), expected, outError);
+}
+
+//=======================================================
+//		CheckRead : Read the book some way, results must be consistent but are not compared to the models,
+//		they run without the model lock and so race with every write and Clear
+//=======================================================
+static bool CheckRead(CStressWorker& worker, std::string& outError)
+{
+	switch (worker.mGenerator() % kStressReadKindCount)
+	{
+	case 0:
+	{
+		std::string searchKey(RandomName(worker.mGenerator, 1));
+		AddressEntrySearchType searchType = RandomSearchType(worker.mGenerator);
+		AddressEntries result(AddressBookInterface::Search(searchKey, searchType));
+		for (const AddressEntry& entry : result)
+		{
+			if (!MatchesSearch(entry, FoldCase(searchKey), searchType))
+			{
+				outError = "racing search " + searchKey + " found " + EntryText(entry);
+				return false;
+			}
+		}
+
+		return CheckUnique("racing search", result, outError);
+	}
+	case 1:
+	{
+		const AddressEntry& entry = worker.mPool[worker.mGenerator() % worker.mPool.size()];
+		AddressBookInterface::SetEntryScore(entry, worker.mGenerator() % kStressScoreMax);
+
+		std::string searchKey(RandomName(worker.mGenerator, 1));
+		AddressEntrySearchType searchType = RandomSearchType(worker.mGenerator);
+		size_t count = 1 + worker.mGenerator() % kStressRankedCountMax;
+		AddressEntries result(AddressBookInterface::SearchRanked(searchKey, count, searchType));
+		if (result.size() > count)
+		{
+			outError = "ranked search for " + std::to_string(count) + " returned " + std::to_string(result.size());
+			return false;
+		}
+
+		for (const AddressEntry& found : result)
+		{
+			if (!MatchesSearch(found, FoldCase(searchKey), searchType))
+			{
+				outError = "ranked search " + searchKey + " found " + EntryText(found);
+				return false;
+			}
+		}
+
+		return CheckUnique("ranked search", result, outError);
+	}
+	case 2:
+	{
+		AddressEntryOrderType orderType = RandomOrderType(worker.mGenerator);
+		return CheckOrder("racing retrieve", AddressBookInterface::RetrieveEntries(orderType), orderType, outError);
+	}
+	case 3:
+	{
+		AddressEntries visited;
+		AddressBookInterface::ForEach([&visited](const AddressEntry& entry) { visited.push_back(entry); });
+		return CheckUnique("racing foreach", visited, outError);
+	}
+	case 4:
+	{
+		std::mutex visitedMutex;
+		AddressEntries visited;
+		AddressBookInterface::ParallelForEach([&](const AddressEntry& entry)
+			{
+				std::lock_guard<std::mutex> lock(visitedMutex);
+				visited.push_back(entry);
+			});
+
+		return CheckUnique("racing parallel foreach", visited, outError);
+	}
+	case 5:
+	{
+		AddressEntryOrderType orderType = RandomOrderType(worker.mGenerator);
+		AddressEntryStream stream(AddressBookInterface::RetrieveEntriesAsync(orderType, kStressStreamChunkSize));
+
+		AddressEntries streamed;
+		AddressEntries chunk;
+		while (stream.Next(chunk) == AddressEntryStreamStatus::kStreamChunk)
+		{
+			streamed.splice(streamed.cend(), chunk);
+		}
+
+		return CheckOrder("racing streamed retrieve", streamed, orderType, outError);
+	}
+	default:
+		return CheckSnapshot(AddressBookInterface::PinSnapshot(), outError);
+	}
+}
+
+//=======================================================
+//		RunWorker : Run a worker's operations for one round
+//=======================================================
+static void RunWorker(CStressState& state, CStressWorker& worker)
+{
+	worker.mPool.clear();
+	for (size_t i = 0; i < kStressEntryPoolSize; i++)
+	{
+		worker.mPool.push_back(RandomEntry(worker));
+	}
+
+	std::string error;
+	for (size_t i = 0; i < kStressOperationsPerThread && !state.mFailure.HasFailed(); i++)
+	{
+		uint32_t share = worker.mGenerator() % 1000;
+		bool passed = true;
+
+		if (share >= kStressAddShare + kStressAddBatchShare + kStressRemoveShare + kStressInvalidShare + kStressSearchShare + kStressQueryShare)
+		{
+			passed = CheckRead(worker, error);
+		}
+		else
+		{
+			// The worker's entries only change under this lock, so the model matches the book throughout
+			std::shared_lock<std::shared_mutex> lock(state.mModelMutex);
+			if (share < kStressAddShare)
+			{
+				passed = CheckAdd(worker, error);
+			}
+			else if ((share -= kStressAddShare) < kStressAddBatchShare)
+			{
+				passed = CheckAddBatch(worker, error);
+			}
+			else if ((share -= kStressAddBatchShare) < kStressRemoveShare)
+			{
+				passed = CheckRemove(worker, error);
+			}
+			else if ((share -= kStressRemoveShare) < kStressInvalidShare)
+			{
+				passed = CheckInvalid(worker, error);
+			}
+			else if ((share -= kStressInvalidShare) < kStressSearchShare)
+			{
+				passed = CheckSearch(worker, error);
+			}
+			else
+			{
+				passed = CheckQuery(worker, error);
+			}
+		}
+
+		if (!passed)
+		{
+			state.mFailure.Report("worker " + worker.mTag + ": " + error);
+		}
+
+		worker.mOperations++;
+	}
+
+	state.mRunningWorkers.fetch_sub(1);
+}
+
+//=======================================================
+//		RunChaos : Apply book-wide operations at random until every worker is done
+//=======================================================
+static void RunChaos(CStressState& state, std::mt19937& generator, uint64_t& outOperations)
+{
+	while (state.mRunningWorkers.load() != 0 && !state.mFailure.HasFailed())
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(generator() % kStressChaosPauseMaxMicroseconds));
+
+		uint32_t operation = 0;
+		for (uint32_t share = generator() % 1000; operation + 1 < kStressChaosOperationCount && share >= kStressChaosShares[operation]; operation++)
+		{
+			share -= kStressChaosShares[operation];
+		}
+
+		AddressEntryError result = AddressEntryError::kAddressEntrySuccess;
+		switch (static_cast<StressChaosOperation>(operation))
+		{
+		case StressChaosOperation::Clear:
+		{
+			std::unique_lock<std::shared_mutex> lock(state.mModelMutex);
+			AddressBookInterface::Clear();
+			for (auto& pWorker : state.mWorkers)
+			{
+				pWorker->mModel.clear();
+			}
+
+			// Clearing a frozen book leaves it mutable
+			state.mFrozen = false;
+			break;
+		}
+		case StressChaosOperation::Freeze:
+		{
+			try
+			{
+				AddressBookInterface::Freeze().get();
+				state.mFrozen = true;
+			}
+			catch (const std::exception& exception)
+			{
+				state.mFailure.Report(std::string("freeze failed: ") + exception.what());
+			}
+
+			break;
+		}
+		case StressChaosOperation::Thaw:
+		{
+			AddressBookInterface::Thaw().get();
+			state.mFrozen = false;
+			break;
+		}
+		case StressChaosOperation::Compact:
+		{
+			AddressBookInterface::Compact().get();
+			break;
+		}
+		case StressChaosOperation::LookupFilter:
+		{
+			state.mLookupFilter = !state.mLookupFilter;
+			result = state.mLookupFilter ? AddressBookInterface::SetLookupFilter(kStressLookupFilterEntries, kStressLookupFilterFalsePositiveRate)
+								  : AddressBookInterface::SetLookupFilter(0, 0.0);
+			break;
+		}
+		case StressChaosOperation::SearchCache:
+		{
+			state.mSearchCache = !state.mSearchCache;
+			AddressBookInterface::SetSearchCacheBudget(state.mSearchCache ? kStressSearchCacheBytes : 0);
+			break;
+		}
+		case StressChaosOperation::SubstringIndex:
+		{
+			state.mSubstringIndex = !state.mSubstringIndex;
+			AddressBookInterface::SetSubstringIndexEnabled(state.mSubstringIndex).get();
+			break;
+		}
+		case StressChaosOperation::TieredStorage:
+		{
+			state.mTieredStorage = !state.mTieredStorage;
+			result = AddressBookInterface::SetTieredStorage(state.mTieredStorage ? std::filesystem::temp_directory_path().string() : std::string(),
+															kStressTieredCacheBytes);
+			break;
+		}
+		default:
+			break;
+		}
+
+		if (result != AddressEntryError::kAddressEntrySuccess)
+		{
+			state.mFailure.Report("chaos operation returned " + std::to_string(static_cast<uint32_t>(result)));
+		}
+
+		outOperations++;
+	}
+}
+
+//=======================================================
+//		CheckBook : Check the whole book against the models once every thread is done
+//=======================================================
+static bool CheckBook(CStressState& state, std::mt19937& generator, std::string& outError)
+{
+	CStressEntrySet expected;
+	for (const auto& pWorker : state.mWorkers)
+	{
+		for (const auto& modelEntry : pWorker->mModel)
+		{
+			expected.insert(modelEntry.first);
+		}
+	}
+
+	// Both tries hold every entry, in their own order
+	for (AddressEntryOrderType orderType : { AddressEntryOrderType::FirstNameOrder, AddressEntryOrderType::LastNameOrder })
+	{
+		AddressEntries entries(AddressBookInterface::RetrieveEntries(orderType));
+		const char* what = orderType == AddressEntryOrderType::FirstNameOrder ? "first name order" : "last name order";
+		if (!CheckOrder(what, entries, orderType, outError) || !CheckEntries(what, entries, expected, outError))
+		{
+			return false;
+		}
+	}
+
+	// Every traversal visits each entry once, ordered parallel traversals in ForEach order
+	AddressEntries visited;
+	AddressBookInterface::ForEach([&visited](const AddressEntry& entry) { visited.push_back(entry); });
+	if (!CheckEntries("foreach", visited, expected, outError))
+	{
+		return false;
+	}
+
+	AddressEntries visitedInOrder;
+	AddressBookInterface::ParallelForEach([&visitedInOrder](const AddressEntry& entry) { visitedInOrder.push_back(entry); },
+										  AddressEntryTraversalType::Ordered);
+	if (visitedInOrder != visited)
+	{
+		auto mismatch = std::mismatch(visited.cbegin(), visited.cend(), visitedInOrder.cbegin(), visitedInOrder.cend());
+		outError = "ordered parallel foreach differs from foreach at entry " + std::to_string(std::distance(visited.cbegin(), mismatch.first)) +
+				   " of " + std::to_string(visited.size()) + (state.mFrozen ? " (frozen)" : " (mutable)") + ": " +
+				   (mismatch.first != visited.cend() ? EntryText(*mismatch.first) : std::string("end")) + " against " +
+				   (mismatch.second != visitedInOrder.cend() ? EntryText(*mismatch.second) : std::string("end"));
+		return false;
+	}
+
+	std::mutex visitedMutex;
+	AddressEntries visitedUnordered;
+	AddressBookInterface::ParallelForEach([&](const AddressEntry& entry)
+		{
+			std::lock_guard<std::mutex> lock(visitedMutex);
+			visitedUnordered.push_back(entry);
+		});
+
+	AddressEntries visitedAsync;
+	AddressBookInterface::ForEachAsync([&visitedAsync](const AddressEntry& entry) { visitedAsync.push_back(entry); }).get();
+	if (!CheckEntries("parallel foreach", visitedUnordered, expected, outError) ||
+		!CheckEntries("asynchronous foreach", visitedAsync, expected, outError))
+	{
+		return false;
+	}
+
+	AddressBookSnapshot snapshot(AddressBookInterface::PinSnapshot());
+	if (!CheckSnapshot(snapshot, outError) ||
+		!CheckEntries("snapshot", snapshot.RetrieveEntries(AddressEntryOrderType::FirstNameOrder), expected, outError))
+	{
+		return false;
+	}
+
+	// Searches of every short key, in both cases
+	std::vector<std::string> searchKeys;
+	for (const char* key : { "a", "b", "aa", "ab", "ba", "bb", "A", "Ab", "bA", "aba", "bab" })
+	{
+		searchKeys.push_back(key);
+	}
+
+	for (const std::string& searchKey : searchKeys)
+	{
+		for (uint32_t type = 0; type <= static_cast<uint32_t>(AddressEntrySearchType::SubstringSearch); type++)
+		{
+			AddressEntrySearchType searchType = static_cast<AddressEntrySearchType>(type);
+
+			CStressEntrySet matching;
+			for (const auto& pWorker : state.mWorkers)
+			{
+				for (const auto& modelEntry : pWorker->mModel)
+				{
+					if (MatchesSearch(modelEntry.second, FoldCase(searchKey), searchType))
+					{
+						matching.insert(modelEntry.first);
+					}
+				}
+			}
+
+			std::string what("search " + searchKey + " type " + std::to_string(type));
+			if (!CheckEntries(what.c_str(), AddressBookInterface::Search(searchKey, searchType), matching, outError))
+			{
+				return false;
+			}
+		}
+	}
+
+	// Phone number index holds exactly each worker's entries
+	for (const auto& pWorker : state.mWorkers)
+	{
+		AddressQuery query;
+		query.mTerms.push_back({ AddressEntryField::PhoneNumber, pWorker->mTag });
+
+		CStressEntrySet owned;
+		for (const auto& modelEntry : pWorker->mModel)
+		{
+			owned.insert(modelEntry.first);
+		}
+
+		if (!CheckEntries(("phone query " + pWorker->mTag).c_str(), AddressBookInterface::Query(query), owned, outError))
+		{
+			return false;
+		}
+	}
+
+	// Entries with a name are in its trie, the others in the trie of entries without it
+	if (!state.mFrozen)
+	{
+		AddressBookMetrics metrics(AddressBookInterface::GetMetrics());
+		if (metrics.mFirstNameTrie.mEntryCount + metrics.mNoFirstNameTrie.mEntryCount != expected.size() ||
+			metrics.mLastNameTrie.mEntryCount + metrics.mNoLastNameTrie.mEntryCount != expected.size())
+		{
+			outError = "trie entry counts disagree with " + std::to_string(expected.size()) + " entries";
+			return false;
+		}
+	}
+
+	// Invalid names are rejected, by a mutable book as invalid and leaving every trie as it was
+	const AddressEntryError rejection = state.mFrozen ? AddressEntryError::kAddressEntryReadOnly : AddressEntryError::kAddressEntryInvalid;
+	CStressWorker& worker = *state.mWorkers[generator() % state.mWorkers.size()];
+
+	AddressBookMetrics metricsBefore(AddressBookInterface::GetMetrics());
+	for (size_t i = 0; i < kStressInvalidCheckCount; i++)
+	{
+		AddressEntry invalidName(RandomInvalidEntry(worker));
+		AddressEntries batch({ worker.mPool[generator() % worker.mPool.size()], invalidName });
+
+		// A batch whose valid entry is already in the book may be rejected as a duplicate first
+		bool batchDuplicate = worker.mModel.find(EntryText(batch.front())) != worker.mModel.end();
+		AddressEntryError batchResult = AddressBookInterface::AddEntries(batch);
+
+		if (AddressBookInterface::AddEntry(invalidName) != rejection ||
+			(batchResult != rejection && !(batchDuplicate && batchResult == AddressEntryError::kAddressEntryDuplicate)))
+		{
+			outError = "entry with invalid name " + EntryText(invalidName) + " was not rejected" + (state.mFrozen ? " as read only" : " as invalid");
+			return false;
+		}
+	}
+
+	AddressBookMetrics metricsAfter(AddressBookInterface::GetMetrics());
+	auto sameTrie = [](const AddressTrieMetrics& before, const AddressTrieMetrics& after)
+		{
+			return before.mEntryCount == after.mEntryCount && before.mNodeCount == after.mNodeCount;
+		};
+
+	if (!sameTrie(metricsBefore.mFirstNameTrie, metricsAfter.mFirstNameTrie) || !sameTrie(metricsBefore.mLastNameTrie, metricsAfter.mLastNameTrie) ||
+		!sameTrie(metricsBefore.mNoFirstNameTrie, metricsAfter.mNoFirstNameTrie) || !sameTrie(metricsBefore.mNoLastNameTrie, metricsAfter.mNoLastNameTrie))
+	{
+		outError = "rejected adds of invalid names changed the tries";
+		return false;
+	}
+
+	return CheckEntries("entries after invalid adds", AddressBookInterface::RetrieveEntries(AddressEntryOrderType::FirstNameOrder), expected, outError);
+}
+
+//=======================================================
+//		CheckScale : Check the parallel read paths of a large book against the serial ones
+//=======================================================
+static bool CheckScale(const CStressEntrySet& expected, const char* layout, std::string& outError)
+{
+	for (AddressEntryOrderType orderType : { AddressEntryOrderType::FirstNameOrder, AddressEntryOrderType::LastNameOrder })
+	{
+		AddressEntries entries(AddressBookInterface::RetrieveEntries(orderType));
+		std::string what(std::string(layout) + (orderType == AddressEntryOrderType::FirstNameOrder ? " first name order" : " last name order"));
+		if (!CheckOrder(what.c_str(), entries, orderType, outError) || !CheckEntries(what.c_str(), entries, expected, outError))
+		{
+			return false;
+		}
+	}
+
+	AddressEntries visited;
+	AddressBookInterface::ForEach([&visited](const AddressEntry& entry) { visited.push_back(entry); });
+
+	AddressEntries visitedInOrder;
+	AddressBookInterface::ParallelForEach([&visitedInOrder](const AddressEntry& entry) { visitedInOrder.push_back(entry); },
+										  AddressEntryTraversalType::Ordered);
+	if (visitedInOrder != visited)
+	{
+		outError = std::string(layout) + " ordered parallel foreach differs from foreach";
+		return false;
+	}
+
+	std::mutex visitedMutex;
+	AddressEntries visitedUnordered;
+	AddressBookInterface::ParallelForEach([&](const AddressEntry& entry)
+		{
+			std::lock_guard<std::mutex> lock(visitedMutex);
+			visitedUnordered.push_back(entry);
+		});
+
+	AddressBookSnapshot snapshot(AddressBookInterface::PinSnapshot());
+	return CheckEntries((std::string(layout) + " foreach").c_str(), visited, expected, outError) &&
+		   CheckEntries((std::string(layout) + " parallel foreach").c_str(), visitedUnordered, expected, outError) &&
+		   CheckSnapshot(snapshot, outError);
+}
+
+//=======================================================
+//		RunScale : Load a book large enough for the parallel read paths and check it mutable, frozen and bulk loaded
+//=======================================================
+static bool RunScale(CStressState& state, std::mt19937& generator, std::string& outError)
+{
+	static const char kLetters[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+	auto randomName = [&generator]()
+		{
+			std::string name;
+			size_t length = 1 + generator() % kStressScaleNameLengthMax;
+			for (size_t i = 0; i < length; i++)
+			{
+				name.push_back(kLetters[generator() % (sizeof(kLetters) - 1)]);
+			}
+
+			return name;
+		};
+
+	// Unique phone numbers keep every entry distinct
+	AddressEntries entries;
+	CStressEntrySet expected;
+	for (size_t i = 0; i < kStressScaleEntryCount; i++)
+	{
+		entries.push_back(AddressEntry(randomName(), randomName(), std::to_string(i), std::string()));
+		expected.insert(EntryText(entries.back()));
+	}
+
+	if (state.mFrozen)
+	{
+		AddressBookInterface::Thaw().get();
+		state.mFrozen = false;
+	}
+
+	AddressBookInterface::Clear();
+	if (AddressBookInterface::AddEntries(entries) != AddressEntryError::kAddressEntrySuccess)
+	{
+		outError = "adding the scale entries failed";
+		return false;
+	}
+
+	if (!CheckScale(expected, "mutable", outError))
+	{
+		return false;
+	}
+
+	// Frozen in memory, then spilled to a payload file
+	for (bool tieredStorage : { false, true })
+	{
+		if (state.mFrozen)
+		{
+			AddressBookInterface::Thaw().get();
+		}
+
+		state.mTieredStorage = tieredStorage;
+		if (AddressBookInterface::SetTieredStorage(tieredStorage ? std::filesystem::temp_directory_path().string() : std::string(),
+												   kStressTieredCacheBytes) != AddressEntryError::kAddressEntrySuccess)
+		{
+			outError = "setting tiered storage failed";
+			return false;
+		}
+
+		AddressBookInterface::Freeze().get();
+		state.mFrozen = true;
+		if (!CheckScale(expected, tieredStorage ? "frozen (tiered)" : "frozen", outError))
+		{
+			return false;
+		}
+	}
+
+	// Loaded straight into a tiered frozen book, a repeated entry leaves the book as it was
+	auto loadEntries = [&entries](bool repeatFirst)
+		{
+			auto it = entries.cbegin();
+			bool repeated = !repeatFirst;
+			return AddressBookInterface::LoadFrozen([&](AddressEntry& outEntry)
+				{
+					if (it == entries.cend())
+					{
+						if (repeated)
+						{
+							return false;
+						}
+
+						outEntry = entries.front();
+						repeated = true;
+						return true;
+					}
+
+					outEntry = *it++;
+					return true;
+				});
+		};
+
+	AddressBookInterface::Clear();
+	state.mFrozen = false;
+	if (loadEntries(false) != AddressEntryError::kAddressEntrySuccess)
+	{
+		outError = "loading the scale entries failed";
+		return false;
+	}
+
+	state.mFrozen = true;
+	if (!CheckScale(expected, "loaded (tiered)", outError))
+	{
+		return false;
+	}
+
+	if (loadEntries(true) != AddressEntryError::kAddressEntryDuplicate)
+	{
+		outError = "loading a repeated entry was not rejected as duplicate";
+		return false;
+	}
+
+	if (!CheckScale(expected, "loaded (tiered) after a rejected load", outError))
+	{
+		return false;
+	}
+
+	// Thawing adds the entries back in the order they were loaded
+	AddressBookInterface::Thaw().get();
+	state.mFrozen = false;
+	if (!CheckScale(expected, "thawed load", outError))
+	{
+		return false;
+	}
+
+	AddressEntries thawed;
+	AddressBookInterface::ForEach([&thawed](const AddressEntry& entry) { thawed.push_back(entry); });
+	AddressBookInterface::Clear();
+	AddressBookInterface::AddEntries(entries);
+
+	AddressEntries added;
+	AddressBookInterface::ForEach([&added](const AddressEntry& entry) { added.push_back(entry); });
+	if (thawed != added)
+	{
+		outError = "thawed load differs from adding the same entries";
+		return false;
+	}
+
+	return true;
+}
+
+//=======================================================
+//		RunRemoveByName : Remove every entry of a name while other splits of the same joined name are in the book
+//=======================================================
+static bool RunRemoveByName(std::string& outError)
+{
+	// Tries key on both names joined, these all share "smithjohn" or "johnsmith"
+	AddressEntries entries{ AddressEntry("john", "smith", "1", std::string()),
+							AddressEntry("John", "Smith", "2", std::string()),
+							AddressEntry(std::string(), "smithjohn", "3", std::string()),
+							AddressEntry("smithjohn", std::string(), "4", std::string()),
+							AddressEntry("smith", "john", "5", std::string()),
+							AddressEntry("johnsmith", std::string(), "6", std::string()) };
+
+	AddressBookInterface::Clear();
+	if (AddressBookInterface::AddEntries(entries) != AddressEntryError::kAddressEntrySuccess)
+	{
+		outError = "adding the entries to remove by name failed";
+		return false;
+	}
+
+	// Names are matched ignoring case, phone numbers are ignored
+	CStressEntrySet expected;
+	for (const AddressEntry& entry : entries)
+	{
+		expected.insert(EntryText(entry));
+	}
+
+	for (const AddressEntry& remove : { AddressEntry("john", "smith", "1", std::string()),
+										AddressEntry(std::string(), "SmithJohn", "1", std::string()) })
+	{
+		if (AddressBookInterface::RemoveEntry(remove, false) != AddressEntryError::kAddressEntrySuccess)
+		{
+			outError = "remove by name " + EntryText(remove) + " failed";
+			return false;
+		}
+
+		for (const AddressEntry& entry : entries)
+		{
+			if (FoldCase(entry.mFirstName) == FoldCase(remove.mFirstName) && FoldCase(entry.mLastName) == FoldCase(remove.mLastName))
+			{
+				expected.erase(EntryText(entry));
+			}
+		}
+
+		for (AddressEntryOrderType orderType : { AddressEntryOrderType::FirstNameOrder, AddressEntryOrderType::LastNameOrder })
+		{
+			std::string what("retrieve after removing " + EntryText(remove) + " by name");
+			if (!CheckEntries(what.c_str(), AddressBookInterface::RetrieveEntries(orderType), expected, outError))
+			{
+				return false;
+			}
+		}
+	}
+
+	AddressBookInterface::Clear();
+	return true;
+}
+
+//=======================================================
+//		ParseArgument : Parse a decimal argument, false unless it is digits only
+//=======================================================
+static bool ParseArgument(const char* text, uint32_t& outValue)
+{
+	char* end = nullptr;
+	unsigned long value = std::strtoul(text, &end, 10);
+	if (!std::isdigit(static_cast<unsigned char>(text[0])) || *end != '\0' || value > std::numeric_limits<uint32_t>::max())
+	{
+		return false;
+	}
+
+	outValue = static_cast<uint32_t>(value);
+	return true;
+}
+
+//=======================================================
+//		main
+//		usage: StressApp [round count] [thread count] [seed]
+//=======================================================
+int main(int argc, char* argv[])
+{
+	uint32_t roundCount = kDefaultRoundCount;
+	uint32_t threadCount = kDefaultThreadCount;
+	uint32_t seed = kDefaultSeed;
+	if (argc > 4 ||
+		(argc > 1 && !ParseArgument(argv[1], roundCount)) ||
+		(argc > 2 && !ParseArgument(argv[2], threadCount)) ||
+		(argc > 3 && !ParseArgument(argv[3], seed)))
+	{
+		std::fprintf(stderr, "usage: StressApp [round count] [thread count] [seed]\n");
+		return 2;
+	}
+
+	threadCount = std::min(std::max<uint32_t>(threadCount, 1), kStressThreadCountMax);
+
+	std::printf("Address book stress test: %u rounds, %u threads, seed %u\n\n", roundCount, threadCount, seed);
+
+	CStressState state;
+	for (uint32_t i = 0; i < threadCount; i++)
+	{
+		auto pWorker = std::make_unique<CStressWorker>();
+		pWorker->mTag = std::to_string(kStressFirstTag + i);
+		pWorker->mGenerator.seed(seed + i);
+		state.mWorkers.push_back(std::move(pWorker));
+	}
+
+	std::mt19937 chaosGenerator(seed + threadCount);
+	const ToolsClock::time_point start = ToolsClock::now();
+
+	for (uint32_t round = 1; round <= roundCount; round++)
+	{
+		uint64_t chaosOperations = 0;
+		uint64_t operationsBefore = 0;
+		for (const auto& pWorker : state.mWorkers)
+		{
+			operationsBefore += pWorker->mOperations;
+		}
+
+		state.mRunningWorkers.store(threadCount);
+
+		std::vector<std::thread> threads;
+		for (auto& pWorker : state.mWorkers)
+		{
+			threads.emplace_back([&state, &worker = *pWorker]() { RunWorker(state, worker); });
+		}
+
+		threads.emplace_back([&]() { RunChaos(state, chaosGenerator, chaosOperations); });
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		std::string error;
+		if (!state.mFailure.HasFailed() && !CheckBook(state, chaosGenerator, error))
+		{
+			state.mFailure.Report("book check: " + error);
+		}
+
+		if (state.mFailure.HasFailed())
+		{
+			std::printf("FAILED in round %u: %s\n", round, state.mFailure.GetMessage().c_str());
+			return 1;
+		}
+
+		uint64_t operations = 0;
+		size_t entryCount = 0;
+		for (const auto& pWorker : state.mWorkers)
+		{
+			operations += pWorker->mOperations;
+			entryCount += pWorker->mModel.size();
+		}
+
+		std::printf("round %3u: %8llu operations, %4llu chaos operations, %5zu entries, %s\n",
+					round,
+					static_cast<unsigned long long>(operations - operationsBefore),
+					static_cast<unsigned long long>(chaosOperations),
+					entryCount,
+					state.mFrozen ? "frozen" : "mutable");
+	}
+
+	std::string error;
+	if (!RunScale(state, chaosGenerator, error))
+	{
+		std::printf("FAILED in scale check: %s\n", error.c_str());
+		return 1;
+	}
+
+	std::printf("scale check: %zu entries, mutable, frozen, frozen (tiered) and loaded (tiered)\n", kStressScaleEntryCount);
+
+	if (!RunRemoveByName(error))
+	{
+		std::printf("FAILED in remove by name check: %s\n", error.c_str());
+		return 1;
+	}
+
+	std::printf("remove by name check: names sharing a joined key\n");
+	std::printf("\npassed in %.1f s\n", ElapsedNanoseconds(start) / 1e9);
+	return 0;
+}
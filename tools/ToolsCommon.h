@@ -0,0 +1,284 @@
+#ifndef TOOLS_COMMON_H
+#define TOOLS_COMMON_H
+//=======================================================
+//		Includes
+//=======================================================
+#include "AddressBookTypes.h"
+
+// System
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+//=======================================================
+//		Aliases
+//=======================================================
+using ToolsClock = std::chrono::steady_clock;
+
+//=======================================================
+//		ElapsedNanoseconds : Nanoseconds since start
+//=======================================================
+inline double ElapsedNanoseconds(const ToolsClock::time_point& start)
+{
+	return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(ToolsClock::now() - start).count());
+}
+
+//=======================================================
+//		PeakResidentBytes : Peak resident set size of the process, zero if unknown
+//=======================================================
+inline size_t PeakResidentBytes()
+{
+#if defined(__APPLE__)
+	struct rusage usage;
+	return getrusage(RUSAGE_SELF, &usage) == 0 ? static_cast<size_t>(usage.ru_maxrss) : 0;
+#elif defined(__unix__)
+	struct rusage usage;
+	return getrusage(RUSAGE_SELF, &usage) == 0 ? static_cast<size_t>(usage.ru_maxrss) * 1024 : 0;
+#else
+	return 0;
+#endif
+}
+
+//=======================================================
+//		CZipfDistribution : Zipfian rank sampler over [0, count)
+//=======================================================
+class CZipfDistribution
+{
+public:
+	CZipfDistribution(size_t count, double exponent) :
+		mCumulative(count)
+	{
+		double sum = 0.0;
+		for (size_t rank = 0; rank < count; rank++)
+		{
+			sum += 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+			mCumulative[rank] = sum;
+		}
+
+		for (double& value : mCumulative)
+		{
+			value /= sum;
+		}
+	}
+
+	template <typename Generator>
+	size_t operator()(Generator& generator) const
+	{
+		double sample = std::uniform_real_distribution<double>(0.0, 1.0)(generator);
+		auto it = std::lower_bound(mCumulative.begin(), mCumulative.end(), sample);
+		return std::min(static_cast<size_t>(it - mCumulative.begin()), mCumulative.size() - 1);
+	}
+
+private:
+	std::vector<double> mCumulative;
+};
+
+//=======================================================
+//		CDatasetGenerator : Reproducible name/phone datasets
+//		first names are Zipfian over a small pool, surnames have a common head and a long unique tail
+//=======================================================
+class CDatasetGenerator
+{
+public:
+	// C-tor
+	explicit CDatasetGenerator(uint32_t seed,
+							   size_t firstNamePool = 2000,
+							   size_t commonSurnamePool = 5000) :
+		mGenerator(seed),
+		mFirstNameRanks(firstNamePool, 1.1),
+		mSurnameRanks(commonSurnamePool, 0.9)
+	{
+		for (size_t i = 0; i < firstNamePool; i++)
+		{
+			mFirstNames.push_back(MakeName(2 + i % 2));
+		}
+
+		for (size_t i = 0; i < commonSurnamePool; i++)
+		{
+			mSurnames.push_back(MakeName(2 + i % 3));
+		}
+	}
+
+	// Random entry, a small share has no first or no last name
+	AddressEntry NextEntry()
+	{
+		AddressEntry entry;
+
+		uint32_t shape = mGenerator() % 100;
+		if (shape >= 2)
+		{
+			entry.mFirstName = mFirstNames[mFirstNameRanks(mGenerator)];
+		}
+
+		if (shape < 2 || shape >= 4)
+		{
+			// Long tail of surnames seen only once
+			entry.mLastName = (mGenerator() % 100 < 30) ? MakeName(2 + mGenerator() % 3)
+														: mSurnames[mSurnameRanks(mGenerator)];
+		}
+
+		uint32_t phoneLength = (mGenerator() % 10 == 0) ? 0 : 10;
+		for (uint32_t i = 0; i < phoneLength; i++)
+		{
+			entry.mPhoneNumber.push_back(static_cast<char>('0' + mGenerator() % 10));
+		}
+
+		return entry;
+	}
+
+	// *count* distinct entries
+	AddressEntries NextEntries(size_t count)
+	{
+		AddressEntries entries;
+		for (size_t i = 0; i < count; i++)
+		{
+			AddressEntry entry(NextEntry());
+
+			// Phone number suffix makes colliding samples distinct
+			entry.mPhoneNumber += std::to_string(i);
+			entries.push_back(std::move(entry));
+		}
+
+		return entries;
+	}
+
+	// Prefix of a popular key, to match search traffic
+	std::string NextSearchKey(size_t length)
+	{
+		const std::string& name = (mGenerator() % 2 == 0) ? mFirstNames[mFirstNameRanks(mGenerator)]
+														  : mSurnames[mSurnameRanks(mGenerator)];
+		return name.substr(0, std::min(length, name.size()));
+	}
+
+	// Prefix of a popular key ending in letters no generated name has, like a mistyped search
+	std::string NextMissingKey(size_t length)
+	{
+		static const char* kUnusedLetters = "qxy";
+
+		std::string key(NextSearchKey(length > 2 ? length - 2 : 1));
+		while (key.size() < length)
+		{
+			key.push_back(kUnusedLetters[mGenerator() % 3]);
+		}
+
+		return key;
+	}
+
+	// Infix of a popular name, at least *length* characters are kept when the name allows
+	std::string NextSubstringKey(size_t length)
+	{
+		const std::string& name = (mGenerator() % 2 == 0) ? mFirstNames[mFirstNameRanks(mGenerator)]
+														  : mSurnames[mSurnameRanks(mGenerator)];
+		size_t start = name.size() > length ? mGenerator() % (name.size() - length + 1) : 0;
+		return name.substr(start, length);
+	}
+
+	std::mt19937& GetGenerator() { return mGenerator; }
+
+private:
+	// Pronounceable lower case name made of syllables
+	std::string MakeName(uint32_t syllables)
+	{
+		static const char* kConsonants = "bcdfghjklmnprstvwz";
+		static const char* kVowels = "aeiou";
+
+		std::string name;
+		for (uint32_t i = 0; i < syllables; i++)
+		{
+			name.push_back(kConsonants[mGenerator() % 18]);
+			name.push_back(kVowels[mGenerator() % 5]);
+			if (mGenerator() % 3 == 0)
+			{
+				name.push_back(kConsonants[mGenerator() % 18]);
+			}
+		}
+
+		return name;
+	}
+
+private:
+	std::mt19937 mGenerator;
+	CZipfDistribution mFirstNameRanks;
+	CZipfDistribution mSurnameRanks;
+	std::vector<std::string> mFirstNames;
+	std::vector<std::string> mSurnames;
+};
+
+//=======================================================
+//		CLatencyRecorder : Latency samples with percentile summary
+//=======================================================
+class CLatencyRecorder
+{
+public:
+	void Record(double nanoseconds)
+	{
+		mSamples.push_back(nanoseconds);
+		mSorted = false;
+	}
+
+	void Merge(const CLatencyRecorder& other)
+	{
+		mSamples.insert(mSamples.end(), other.mSamples.begin(), other.mSamples.end());
+		mSorted = false;
+	}
+
+	size_t GetCount() const { return mSamples.size(); }
+
+	// Percentile in nanoseconds, *percentile* in [0, 100]
+	double Percentile(double percentile)
+	{
+		if (mSamples.empty())
+		{
+			return 0.0;
+		}
+
+		if (!mSorted)
+		{
+			std::sort(mSamples.begin(), mSamples.end());
+			mSorted = true;
+		}
+
+		size_t index = static_cast<size_t>(percentile / 100.0 * (mSamples.size() - 1) + 0.5);
+		return mSamples[std::min(index, mSamples.size() - 1)];
+	}
+
+	// Power of two histogram of the samples, bucket i holds [2^i, 2^(i+1)) nanoseconds as in the book's metrics
+	AddressBookLatencyHistogram ToHistogram() const
+	{
+		AddressBookLatencyHistogram histogram;
+		for (double sample : mSamples)
+		{
+			uint64_t nanoseconds = static_cast<uint64_t>(sample);
+
+			uint32_t bucket = 0;
+			for (uint64_t value = nanoseconds >> 1; value != 0 && bucket < kAddressBookLatencyBuckets - 1; value >>= 1)
+			{
+				bucket++;
+			}
+
+			histogram.mBuckets[bucket]++;
+			histogram.mCount++;
+			histogram.mTotalNanoseconds += nanoseconds;
+			histogram.mMaxNanoseconds = std::max(histogram.mMaxNanoseconds, nanoseconds);
+		}
+
+		return histogram;
+	}
+
+	void Clear()
+	{
+		mSamples.clear();
+		mSorted = false;
+	}
+
+private:
+	std::vector<double> mSamples;
+	bool mSorted = false;
+};
+#endif // TOOLS_COMMON_H
\ No newline at end of file